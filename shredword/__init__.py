@@ -1,4 +1,6 @@
 from .trainer import BPETrainer
+from .encoder import BPEEncoder
+from .decoder import BPEDecoder
 
 __version__ = '0.0.1'
 __author__ = 'Shivendra S'
\ No newline at end of file
@@ -24,22 +24,35 @@ MAX_OCCS_PER_MERGE = 50000
 INITIAL_VOCAB_SIZE = 256
 INITIAL_STR_SIZE = 4096
 
-class Symbol(Structure): pass
-class WordPos(Structure): pass
 class Corpus(Structure): pass
 class BPEConfig(Structure): pass
 class Trainer(Structure): pass
 class MaxHeap(Structure): pass
 class BIMap(Structure): pass
 class PairKey(Structure): pass
+class Encoder(Structure): pass
+class EncodeBatch(Structure): pass
+class Decoder(Structure): pass
+class DecodeBatch(Structure): pass
+class DecodeStream(Structure): pass
 
 # populating fields------------
-Symbol._fields_ = [("id", c_int32), ("prev", POINTER(Symbol)), ("next", POINTER(Symbol)), ("deleted", c_bool)]
-WordPos._fields_ = [("word_index", c_size_t), ("pos", POINTER(Symbol))]
-Corpus._fields_ = [("words", POINTER(POINTER(Symbol))), ("word_counts", POINTER(c_uint64)), ("vocab_size", c_size_t)]
-BPEConfig._fields_ = [("target_vocab_size", c_size_t), ("unk_id", c_int32), ("character_coverage", c_float), ("min_pair_freq", c_uint64)]
+Corpus._fields_ = [("symbols", POINTER(c_int32)), ("offsets", POINTER(c_size_t)), ("lengths", POINTER(ctypes.c_uint32)), ("word_counts", POINTER(c_uint64)),
+                   ("vocab_size", c_size_t), ("num_symbols", c_size_t), ("active", POINTER(c_size_t)), ("num_active", c_size_t)]
+PairKey._fields_ = [("first", c_int32), ("second", c_int32)]
+MaxHeap._fields_ = [("data", ctypes.c_void_p), ("size", c_size_t), ("cap", c_size_t), ("pos", POINTER(c_size_t)), ("pos_cap", c_size_t)]
+BIMap._fields_ = [("slots", ctypes.c_void_p), ("nslots", c_size_t), ("keys", POINTER(PairKey)), ("infos", ctypes.c_void_p), ("size", c_size_t), ("cap", c_size_t)]
+BPEConfig._fields_ = [("target_vocab_size", c_size_t), ("unk_id", c_int32), ("character_coverage", c_float), ("min_pair_freq", c_uint64), ("num_threads", c_int32), ("pre_tokenizer", c_int32)]
 Trainer._fields_ = [("config", BPEConfig), ("heap", MaxHeap), ("corpus", Corpus), ("bigram_map", BIMap), ("next_token", c_size_t), ("num_merges", c_size_t),
-                    ("merge_ops", POINTER(PairKey)), ("token_strs", POINTER(c_char_p)), ("token_freq", POINTER(c_uint64))]
+                    ("merge_ops", POINTER(PairKey)), ("token_strs", POINTER(c_char_p)), ("token_freq", POINTER(c_uint64)), ("pool", ctypes.c_void_p),
+                    ("scratch", ctypes.c_void_p), ("nscratch", c_size_t), ("ckpt_path", c_char_p), ("ckpt_every", c_int32),
+                    ("pending", ctypes.c_void_p), ("npending", c_size_t)]
+Encoder._fields_ = [("slots", ctypes.c_void_p), ("nslots", c_size_t), ("num_merges", c_size_t), ("pre_tokenizer", c_int32),
+                    ("num_threads", c_int32), ("pool", ctypes.c_void_p), ("cache", ctypes.c_void_p)]
+EncodeBatch._fields_ = [("ids", POINTER(c_int32)), ("offsets", POINTER(c_size_t)), ("num_ids", c_size_t), ("num_texts", c_size_t)]
+Decoder._fields_ = [("bytes", ctypes.c_void_p), ("offsets", POINTER(c_size_t)), ("vocab_size", c_size_t), ("max_token_bytes", c_size_t)]
+DecodeBatch._fields_ = [("bytes", ctypes.c_void_p), ("offsets", POINTER(c_size_t)), ("num_bytes", c_size_t), ("num_texts", c_size_t)]
+DecodeStream._fields_ = [("dec", POINTER(Decoder)), ("buf", ctypes.c_void_p), ("cap", c_size_t), ("emitted", c_size_t), ("held", c_size_t)]
 
 lib.create_trainer.argtypes = [POINTER(BPEConfig)]
 lib.create_trainer.restype = POINTER(Trainer)
@@ -51,9 +64,85 @@ lib.bpe_count_bigrams.argtypes = [POINTER(Trainer)]
 lib.bpe_count_bigrams.restype = None
 lib.bpe_load_corpus.argtypes = [POINTER(Trainer), c_char_p]
 lib.bpe_load_corpus.restype = c_int
+lib.bpe_load_corpus_files.argtypes = [POINTER(Trainer), POINTER(c_char_p), c_size_t]
+lib.bpe_load_corpus_files.restype = c_int
+lib.bpe_feed.argtypes = [POINTER(Trainer), POINTER(ctypes.c_void_p), POINTER(c_size_t), c_size_t]
+lib.bpe_feed.restype = c_int
+lib.bpe_build_corpus.argtypes = [POINTER(Trainer)]
+lib.bpe_build_corpus.restype = c_int
+lib.bpe_count_files.argtypes = [POINTER(Trainer), POINTER(c_char_p), c_size_t]
+lib.bpe_count_files.restype = c_int
+lib.bpe_save_counts.argtypes = [POINTER(Trainer), c_char_p, c_int]
+lib.bpe_save_counts.restype = c_int
+lib.bpe_load_counts.argtypes = [POINTER(Trainer), POINTER(c_char_p), c_size_t]
+lib.bpe_load_counts.restype = c_int
 lib.bpe_merge_batch.argtypes = [POINTER(Trainer), c_int]
 lib.bpe_merge_batch.restype = c_int
 lib.bpe_train.argtypes = [POINTER(Trainer)]
 lib.bpe_train.restype = c_int
 lib.bpe_save.argtypes = [POINTER(Trainer), c_char_p, c_char_p]
-lib.bpe_save.restype = None
\ No newline at end of file
+lib.bpe_save.restype = None
+lib.bpe_checkpoint.argtypes = [POINTER(Trainer), c_char_p]
+lib.bpe_checkpoint.restype = c_int
+lib.bpe_resume.argtypes = [POINTER(Trainer), c_char_p]
+lib.bpe_resume.restype = c_int
+lib.bpe_set_checkpoint.argtypes = [POINTER(Trainer), c_char_p, c_int]
+lib.bpe_set_checkpoint.restype = None
+lib.bpe_load_merges.argtypes = [POINTER(Trainer), c_char_p]
+lib.bpe_load_merges.restype = c_int
+
+lib.encoder_create.argtypes = [c_char_p, c_int, c_int]
+lib.encoder_create.restype = POINTER(Encoder)
+lib.encoder_destroy.argtypes = [POINTER(Encoder)]
+lib.encoder_destroy.restype = None
+lib.encoder_vocab_size.argtypes = [POINTER(Encoder)]
+lib.encoder_vocab_size.restype = c_size_t
+lib.encoder_encode_word.argtypes = [POINTER(Encoder), ctypes.c_void_p, c_size_t, POINTER(c_int32)]
+lib.encoder_encode_word.restype = c_size_t
+lib.encoder_encode.argtypes = [POINTER(Encoder), ctypes.c_void_p, c_size_t, POINTER(c_int32)]
+lib.encoder_encode.restype = c_size_t
+lib.encoder_encode_batch.argtypes = [POINTER(Encoder), POINTER(ctypes.c_void_p), POINTER(c_size_t), c_size_t]
+lib.encoder_encode_batch.restype = POINTER(EncodeBatch)
+lib.encoder_batch_free.argtypes = [POINTER(EncodeBatch)]
+lib.encoder_batch_free.restype = None
+lib.encoder_set_cache.argtypes = [POINTER(Encoder), c_size_t]
+lib.encoder_set_cache.restype = c_int
+lib.encoder_cache_stats.argtypes = [POINTER(Encoder), POINTER(c_uint64), POINTER(c_uint64), POINTER(c_size_t)]
+lib.encoder_cache_stats.restype = None
+lib.encoder_warm.argtypes = [POINTER(Encoder), POINTER(Trainer), c_size_t]
+lib.encoder_warm.restype = ctypes.c_long
+lib.encoder_encode_files.argtypes = [POINTER(Encoder), POINTER(c_char_p), c_size_t, c_char_p, c_uint64, c_int]
+lib.encoder_encode_files.restype = ctypes.c_long
+
+lib.decoder_create.argtypes = [c_char_p]
+lib.decoder_create.restype = POINTER(Decoder)
+lib.decoder_destroy.argtypes = [POINTER(Decoder)]
+lib.decoder_destroy.restype = None
+lib.decoder_vocab_size.argtypes = [POINTER(Decoder)]
+lib.decoder_vocab_size.restype = c_size_t
+lib.decoder_decode.argtypes = [POINTER(Decoder), ctypes.c_void_p, c_size_t, ctypes.c_void_p, c_size_t]
+lib.decoder_decode.restype = ctypes.c_int64
+lib.decoder_decode_batch.argtypes = [POINTER(Decoder), ctypes.c_void_p, ctypes.c_void_p, c_size_t]
+lib.decoder_decode_batch.restype = POINTER(DecodeBatch)
+lib.decoder_batch_free.argtypes = [POINTER(DecodeBatch)]
+lib.decoder_batch_free.restype = None
+lib.decoder_stream_create.argtypes = [POINTER(Decoder)]
+lib.decoder_stream_create.restype = POINTER(DecodeStream)
+lib.decoder_stream_destroy.argtypes = [POINTER(DecodeStream)]
+lib.decoder_stream_destroy.restype = None
+lib.decoder_stream_push.argtypes = [POINTER(DecodeStream), ctypes.c_void_p, c_size_t, POINTER(c_size_t)]
+lib.decoder_stream_push.restype = ctypes.c_void_p
+lib.decoder_stream_flush.argtypes = [POINTER(DecodeStream), POINTER(c_size_t)]
+lib.decoder_stream_flush.restype = ctypes.c_void_p
+
+# buffer protocol access, lets `bytes`, `memoryview`, Arrow buffers etc. be passed to C without a copy
+class Py_buffer(Structure):
+  _fields_ = [("buf", ctypes.c_void_p), ("obj", ctypes.c_void_p), ("len", ctypes.c_ssize_t), ("itemsize", ctypes.c_ssize_t),
+              ("readonly", c_int), ("ndim", c_int), ("format", c_char_p), ("shape", POINTER(ctypes.c_ssize_t)),
+              ("strides", POINTER(ctypes.c_ssize_t)), ("suboffsets", POINTER(ctypes.c_ssize_t)), ("internal", ctypes.c_void_p)]
+
+PyBUF_SIMPLE = 0
+ctypes.pythonapi.PyObject_GetBuffer.argtypes = [ctypes.py_object, POINTER(Py_buffer), c_int]
+ctypes.pythonapi.PyObject_GetBuffer.restype = c_int
+ctypes.pythonapi.PyBuffer_Release.argtypes = [POINTER(Py_buffer)]
+ctypes.pythonapi.PyBuffer_Release.restype = None
@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "arena.h"
+
+// block payload starts right after the header, rounded up to the alignment
+#define  ARENA_HEADER  ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static inline char* block_data(ArenaBlock* b) {
+  return (char*)b + ARENA_HEADER;
+}
+
+void arena_init(Arena* arena, size_t block_size) {
+  if (!arena) {
+    fprintf(stderr, "Pointer to Arena not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  arena->head = arena->cur = NULL;
+  arena->block_size = block_size > 0 ? block_size : ARENA_BLOCK_SIZE;
+  arena->reserved = 0;
+}
+
+// allocates a block of at least `size` bytes and links it after the current one
+static ArenaBlock* arena_grow(Arena* arena, size_t size) {
+  size_t cap = size > arena->block_size ? size : arena->block_size;
+  ArenaBlock* b = (ArenaBlock*)malloc(ARENA_HEADER + cap);
+  if (!b) {
+    fprintf(stderr, "Memory allocation failed for Arena block!\n");
+    exit(EXIT_FAILURE);
+  }
+  b->cap = cap;
+  b->used = 0;
+  if (arena->cur) {
+    b->next = arena->cur->next;
+    arena->cur->next = b;
+  } else {
+    b->next = arena->head;
+    arena->head = b;
+  }
+  arena->reserved += cap;
+  return b;
+}
+
+/**
+ @brief Hand out `size` bytes from the arena, aligned to ARENA_ALIGN.
+ * Walks forward over blocks kept by a previous reset before allocating a new
+ * one; requests bigger than the block size get a block of their own.
+ @param arena The arena
+ @param size Number of bytes (may be 0)
+ @return Pointer valid until the next `arena_reset` or `arena_free`.
+*/
+void* arena_alloc(Arena* arena, size_t size) {
+  if (!arena) {
+    fprintf(stderr, "Pointer to Arena not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  ArenaBlock* b = arena->cur ? arena->cur : arena->head;
+  while (b && b->used + size > b->cap) {
+    if (!b->next) break;
+    b = b->next;
+  }
+  if (b) arena->cur = b;
+  if (!b || b->used + size > b->cap) b = arena->cur = arena_grow(arena, size);
+  void* p = block_data(b) + b->used;
+  b->used += size;
+  return p;
+}
+
+void arena_reset(Arena* arena) {
+  if (!arena) return;
+  for (ArenaBlock* b = arena->head; b; b = b->next) b->used = 0;
+  arena->cur = arena->head;
+}
+
+void arena_free(Arena* arena) {
+  if (!arena) return;
+  ArenaBlock* b = arena->head;
+  while (b) {
+    ArenaBlock* next = b->next;
+    free(b);
+    b = next;
+  }
+  arena->head = arena->cur = NULL;
+  arena->reserved = 0;
+}
@@ -0,0 +1,41 @@
+/**
+  @file arena.h
+  @brief Bump allocator for short-lived trainer nodes.
+
+  * Small nodes that are created by the million and all die together (frequency
+    deltas of a merge, histogram entries of a load) are carved out of large blocks
+    instead of being `malloc`ed one by one.
+  * Nothing is freed individually: `arena_reset` rewinds every block for the next
+    phase while keeping the memory, and `arena_free` releases all of it.
+  * An arena isn't thread-safe; threads that allocate concurrently use one each.
+*/
+
+#ifndef __ARENA__H__
+#define __ARENA__H__
+
+#include <stddef.h>
+
+#define  ARENA_BLOCK_SIZE  (1 << 16)   // default block capacity in bytes
+#define  ARENA_ALIGN  16   // alignment of every allocation
+
+typedef struct ArenaBlock {
+  struct ArenaBlock* next;
+  size_t cap;   // usable bytes after the header
+  size_t used;  // bytes handed out since the last reset
+} ArenaBlock;
+
+typedef struct Arena {
+  ArenaBlock* head;   // first block of the chain
+  ArenaBlock* cur;    // block allocations are currently carved from
+  size_t block_size;  // capacity of regular blocks
+  size_t reserved;    // bytes held by all blocks
+} Arena;
+
+extern "C" {
+  void arena_init(Arena* arena, size_t block_size);
+  void* arena_alloc(Arena* arena, size_t size);  // aligned to ARENA_ALIGN, never NULL
+  void arena_reset(Arena* arena);  // invalidates every allocation, keeps the blocks
+  void arena_free(Arena* arena);
+}
+
+#endif  //!__ARENA__H__
@@ -5,6 +5,20 @@
 #include "heap.h"
 #include "histogram.h"
 #include "bpe.h"
+#include "checkpoint.h"
+#include "reader.h"
+#include "counts.h"
+#include "pretok.h"
+#include "scan.h"
+#include "decoder.h"
+#include "../threads.h"
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
 
 // Simple hash table for tracking frequency changes during merges
 typedef struct FreqChange {
@@ -13,21 +27,25 @@ typedef struct FreqChange {
   struct FreqChange* next;
 } FreqChange;
 
-// Simple hash table for frequency changes
-#define FREQ_CHANGE_BUCKETS 1024
+// Simple hash table for frequency changes, nodes live in the merge's scratch arena
+#define FREQ_CHANGE_BITS 10
+#define FREQ_CHANGE_BUCKETS (1 << FREQ_CHANGE_BITS)
 
 typedef struct FreqChangeMap {
   FreqChange* buckets[FREQ_CHANGE_BUCKETS];
+  Arena* arena;   // owns every node; dropped wholesale by `arena_reset`
 } FreqChangeMap;
 
-static void freq_change_init(FreqChangeMap* map) {
+static void freq_change_init(FreqChangeMap* map, Arena* arena) {
   for (int i = 0; i < FREQ_CHANGE_BUCKETS; i++) {
     map->buckets[i] = NULL;
   }
+  map->arena = arena;
 }
 
 static void freq_change_add(FreqChangeMap* map, uint64_t pair_hash, int64_t delta) {
-  size_t bucket = pair_hash % FREQ_CHANGE_BUCKETS;
+  // fibonacci hashing: neighbour deltas of a merge share a symbol, so the packed key's low bits collide
+  size_t bucket = (size_t)((pair_hash * 0x9E3779B97F4A7C15ULL) >> (64 - FREQ_CHANGE_BITS));
   
   // Check if entry already exists
   for (FreqChange* fc = map->buckets[bucket]; fc; fc = fc->next) {
@@ -38,23 +56,32 @@ static void freq_change_add(FreqChangeMap* map, uint64_t pair_hash, int64_t delt
   }
   
   // Create new entry
-  FreqChange* new_fc = (FreqChange*)malloc(sizeof(FreqChange));
+  FreqChange* new_fc = (FreqChange*)arena_alloc(map->arena, sizeof(FreqChange));
   new_fc->pair_hash = pair_hash;
   new_fc->delta = delta;
   new_fc->next = map->buckets[bucket];
   map->buckets[bucket] = new_fc;
 }
 
-static void freq_change_free(FreqChangeMap* map) {
-  for (int i = 0; i < FREQ_CHANGE_BUCKETS; i++) {
-    FreqChange* fc = map->buckets[i];
-    while (fc) {
-      FreqChange* next = fc->next;
-      free(fc);
-      fc = next;
+// worker pool shared by bigram counting and merging, sized by `config.num_threads`
+static ThreadPool* trainer_pool(Trainer* trainer) {
+  if (!trainer->pool) trainer->pool = threadpool_create(resolve_threads(trainer->config.num_threads));
+  return trainer->pool;
+}
+
+// scratch arenas, one per pool thread: `scratch[t]` is only ever touched by tid t
+static Arena* trainer_scratch(Trainer* trainer) {
+  if (!trainer->scratch) {
+    size_t n = (size_t)threadpool_size(trainer_pool(trainer));
+    trainer->scratch = (Arena*)malloc(n * sizeof(Arena));
+    if (!trainer->scratch) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of scratch arenas\n");
+      exit(EXIT_FAILURE);
     }
-    map->buckets[i] = NULL;
+    for (size_t t = 0; t < n; t++) arena_init(&trainer->scratch[t], ARENA_BLOCK_SIZE);
+    trainer->nscratch = n;
   }
+  return trainer->scratch;
 }
 
 /**
@@ -64,10 +91,6 @@ static void freq_change_free(FreqChangeMap* map) {
  * (represented by `key.first` and `key.second`) by counting how many times it appears 
  * across all symbol sequences, weighted by the frequency of the word in which it appears.
  *
- * Deleted symbols (marked via `s->deleted`) are skipped to ensure only live bigrams are counted.
- * This helps maintain accurate frequency statistics during merge steps when the symbol list
- * is modified in-place.
- *
  @param key     The bigram to count, defined by its `first` and `second` symbol IDs.
  @param info    Pointer to the Info struct associated with this bigram (not modified here).
  @param trainer Pointer to the Trainer object that contains the corpus.
@@ -80,23 +103,50 @@ uint64_t recompute_freq(PairKey key, Info* info, Trainer* trainer) {
   if (key.first == trainer->config.unk_id || key.second == trainer->config.unk_id) return 0;
 
   uint64_t freq = 0;
-  size_t vocab_size = trainer->corpus.vocab_size;
+  const Corpus* corpus = &trainer->corpus;
 
-  for (size_t wi = 0; wi < vocab_size; ++wi) {
-    Symbol* s = trainer->corpus.words[wi];
+  for (size_t a = 0; a < corpus->num_active; ++a) {
+    size_t wi = corpus->active[a];
+    const int32_t* ids = trainer->corpus.symbols + trainer->corpus.offsets[wi];
+    uint32_t len = trainer->corpus.lengths[wi];
     uint64_t count = trainer->corpus.word_counts[wi];
-        
-    while (s && s->next) {
-      if (!s->deleted && !s->next->deleted &&
-        s->id == key.first && s->next->id == key.second) {
+
+    for (uint32_t i = 0; i + 1 < len; ++i) {
+      if (ids[i] == key.first && ids[i + 1] == key.second) {
         freq += count;
       }
-      s = s->next;
     }
   }
   return freq;
 }
 
+/**
+ @brief Compacts `corpus.active` in place, dropping words that no longer hold a countable pair.
+ *
+ * Words only ever shrink, so once a word has collapsed to a single token (or every
+ * remaining pair touches `unk_id`) it can't take part in a merge again. The list keeps
+ * ascending order, i.e. the order of the words' runs inside `corpus.symbols`.
+ *
+ @param trainer Pointer to the trainer whose corpus is compacted.
+*/
+static void refresh_active_words(Trainer* trainer) {
+  Corpus* corpus = &trainer->corpus;
+  int32_t unk_id = trainer->config.unk_id;
+  size_t kept = 0;
+  for (size_t a = 0; a < corpus->num_active; ++a) {
+    size_t wi = corpus->active[a];
+    const int32_t* ids = corpus->symbols + corpus->offsets[wi];
+    uint32_t len = corpus->lengths[wi];
+    for (uint32_t i = 0; i + 1 < len; ++i) {
+      if (ids[i] != unk_id && ids[i + 1] != unk_id) {
+        corpus->active[kept++] = wi;
+        break;
+      }
+    }
+  }
+  corpus->num_active = kept;
+}
+
 /**
  @brief Allocates and initializes a new BPE trainer instance with user-specified or default configuration.
  *
@@ -114,7 +164,7 @@ Trainer* create_trainer(const BPEConfig* config) {
     fprintf(stderr, "[ERROR]\t Config pointer is NULL\n");
     exit(EXIT_FAILURE);
   }
-  Trainer* trainer = (Trainer*)malloc(sizeof(Trainer));
+  Trainer* trainer = (Trainer*)calloc(1, sizeof(Trainer));
   if (!trainer) {
     fprintf(stderr, "[ERROR]\t Couldn't allocate Memory to Trainer\n");
     exit(EXIT_FAILURE);
@@ -128,6 +178,10 @@ Trainer* create_trainer(const BPEConfig* config) {
   if (trainer->config.min_pair_freq == 0) {
     trainer->config.min_pair_freq = MIN_PAIR_FREQ;
   }
+  if (trainer->config.pre_tokenizer < PRETOK_WHITESPACE || trainer->config.pre_tokenizer > PRETOK_GPT4) {
+    fprintf(stderr, "[ERROR]\t Unknown pre-tokenizer %d, splitting on whitespace\n", trainer->config.pre_tokenizer);
+    trainer->config.pre_tokenizer = PRETOK_WHITESPACE;
+  }
   trainer->num_merges = 0;
   trainer->merge_ops = (PairKey*)malloc(sizeof(PairKey) * trainer->config.target_vocab_size);
   heap_init(&trainer->heap, MIN_HEAP_SIZE);
@@ -138,8 +192,9 @@ Trainer* create_trainer(const BPEConfig* config) {
 /**
  @brief Frees all resources associated with a BPE trainer instance.
  *
- * This function deallocates the internal corpus arrays (word symbols and counts),
- * frees the internal heap structure, and finally frees the trainer object itself.
+ * This function deallocates the internal corpus arrays (symbols, word offsets, lengths, counts and active words),
+ * frees the bigram map, the internal heap structure and the merge list, stops the worker pool,
+ * releases the scratch arenas, checkpoint path & unbuilt feed tables and finally frees the trainer object itself.
  *
  @param trainer Pointer to the `Trainer` struct to be destroyed.
  *
@@ -151,9 +206,20 @@ void bpe_trainer_destroy(Trainer* trainer) {
     exit(EXIT_FAILURE);
   }
   // freeing corpus arrays (if loaded)
-  free(trainer->corpus.words);
+  free(trainer->corpus.symbols);
+  free(trainer->corpus.offsets);
+  free(trainer->corpus.lengths);
   free(trainer->corpus.word_counts);
+  free(trainer->corpus.active);
+  bimap_free(&trainer->bigram_map);
   heap_free(&trainer->heap);
+  free(trainer->merge_ops);
+  threadpool_destroy(trainer->pool);
+  for (size_t t = 0; t < trainer->nscratch; t++) arena_free(&trainer->scratch[t]);
+  free(trainer->scratch);
+  free(trainer->ckpt_path);
+  for (size_t t = 0; t < trainer->npending; t++) wordtable_free(&trainer->pending[t]);
+  free(trainer->pending);
   free(trainer);
 }
 
@@ -184,79 +250,293 @@ void bpe_init(Trainer* trainer) {
   bpe_count_bigrams(trainer);
 }
 
+typedef struct CountShard {
+  const char* begin;  // first byte of the shard
+  const char* end;    // one past the last byte
+  WordTable* table;   // shard-local word counts
+  int pre_tokenizer;
+} CountShard;
+
+// splits [p, end) into words with the given pre-tokenizer and counts every word into table
+static void count_range(WordTable* table, const char* p, const char* end, int pre_tokenizer) {
+  if (pre_tokenizer != PRETOK_WHITESPACE) {
+    while (p < end) {
+      size_t len = pretok_next(pre_tokenizer, p, end);
+      wordtable_add(table, p, len, 1);
+      p += len;
+    }
+    return;
+  }
+  if (!scan_simd()) {
+    while (p < end) {
+      while (p < end && is_corpus_delim((unsigned char)*p)) p++;
+      const char* word = p;
+      while (p < end && !is_corpus_delim((unsigned char)*p)) p++;
+      if (p > word) wordtable_add(table, word, (size_t)(p - word), 1);
+    }
+    return;
+  }
+  // words are the runs of clear bits in the delimiter mask, walked 64 bytes per kernel call
+  const char* word = NULL;  // start of the word in progress
+  uint64_t prev = 1;  // delimiter bit of the byte before the block, a word can start at p
+  for (const char* block = p; block < end; block += SCAN_BLOCK) {
+    size_t n = (size_t)(end - block);
+    uint64_t delims = n >= SCAN_BLOCK ? scan_kernels.delim_mask(block) : scan_delim_mask_tail(block, n);
+    uint64_t shifted = delims << 1 | prev;
+    uint64_t starts = ~delims & shifted, ends = delims & ~shifted;
+    prev = delims >> 63;
+    while (starts | ends) {
+      uint64_t bit = (starts | ends) & -(starts | ends);
+      const char* at = block + scan_ctz64(bit);
+      if (starts & bit) {
+        word = at;
+      } else {
+        wordtable_add(table, word, (size_t)(at - word), 1);
+        word = NULL;
+      }
+      starts &= ~bit;
+      ends &= ~bit;
+    }
+  }
+  if (word) wordtable_add(table, word, (size_t)(end - word), 1);
+}
+
+// moves a shard boundary forward to where no word is split: a newline, or a pre-tokenizer cut
+static const char* shard_cut(const char* data, const char* stop, const char* end, int pre_tokenizer) {
+  if (pre_tokenizer == PRETOK_WHITESPACE) {
+    while (stop < end && *stop != '\n') stop++;
+  } else {
+    while (stop < end && !pretok_is_cut(data, (size_t)(stop - data), (size_t)(end - data))) stop++;
+  }
+  return stop;
+}
+
+static void count_shard_task(void* arg, int tid) {
+  CountShard* shard = &((CountShard*)arg)[tid];
+  count_range(shard->table, shard->begin, shard->end, shard->pre_tokenizer);
+}
+
 /**
- @brief Loads the training corpus from a text file and constructs the initial vocabulary and character histogram.
+ @brief Counts words over a byte buffer on the trainer's pool.
  *
- * This function performs the following steps:
- *  1. Reads the file line by line and splits it into tokens using tab, newline, space, and carriage return as delimiters.
- *  2. Builds a frequency map of unique words using a `StrMap`.
- *  3. Constructs a histogram of character frequencies across all words and determines which characters to retain
- *     based on the `character_coverage` parameter in the configuration.
- *  4. Initializes the corpus vocabulary:
- *     - Assigns known characters their byte ID.
- *     - Maps all rare or unknown characters to the special UNK token.
- *     - Stores tokenized words as linked lists of `Symbol` nodes.
- *  5. Allocates and sets up the initial `bigram_map`.
- *
- @param trainer Pointer to the `Trainer` object being initialized.
- @param input_path Path to the input corpus file.
- @return 0 on success, -1 on failure (e.g., file not found, memory allocation failure).
+ * The buffer is cut into byte ranges whose boundaries are moved forward to the next newline
+ * (or pre-tokenizer cut), so no word is split between shards. Every shard is counted into its own `WordTable`, and the
+ * shard tables are merged into `freq_map` in shard order. Small buffers are counted serially.
  *
- @note This is a prerequisite step before BPE training can start. The function is optimized
- *       for handling large files and long lines using dynamic buffer resizing.
+ @param trainer Trainer whose pool does the counting & whose config picks the pre-tokenizer.
+ @param freq_map Word frequency table to accumulate into.
+ @param data Start of the buffer.
+ @param size Buffer length in bytes.
 */
-int bpe_load_corpus(Trainer* trainer, const char* input_path) {
-  if (!trainer || !input_path) {
-    fprintf(stderr, "[ERROR]\t NULL trainer or input path pointers\n");
-    return -1;
+static void count_buffer_sharded(Trainer* trainer, WordTable* freq_map, const char* data, size_t size) {
+  int pre_tokenizer = trainer->config.pre_tokenizer;
+  ThreadPool* pool = trainer_pool(trainer);
+  size_t nshards = (size_t)threadpool_size(pool);
+  if (nshards > size / MIN_SHARD_BYTES) nshards = size / MIN_SHARD_BYTES;
+  if (nshards <= 1) {
+    count_range(freq_map, data, data + size, pre_tokenizer);
+    return;
   }
-  StrMap freq_map;
-  strmap_init(&freq_map, INITIAL_STR_BUFFER);
-  FILE* fp = fopen(input_path, "r");
-  if (!fp) {
+
+  CountShard* shards = (CountShard*)malloc(nshards * sizeof(CountShard));
+  WordTable* maps = (WordTable*)malloc(nshards * sizeof(WordTable));
+  if (!shards || !maps) {
+    free(shards); free(maps);
+    count_range(freq_map, data, data + size, pre_tokenizer);
+    return;
+  }
+  const char* end = data + size;
+  const char* p = data;
+  for (size_t i = 0; i < nshards; i++) {
+    const char* stop = (i == nshards - 1) ? end : data + (size / nshards) * (i + 1);
+    if (stop < p) stop = p;
+    stop = shard_cut(data, stop, end, pre_tokenizer);
+    shards[i].begin = p;
+    shards[i].end = stop;
+    shards[i].pre_tokenizer = pre_tokenizer;
+    if (i == 0) {
+      shards[i].table = freq_map;
+    } else {
+      wordtable_init(&maps[i], INITIAL_STR_BUFFER);
+      shards[i].table = &maps[i];
+    }
+    p = stop;
+  }
+  threadpool_run(pool, (int)nshards, count_shard_task, shards);
+  for (size_t i = 1; i < nshards; i++) {
+    wordtable_merge(freq_map, &maps[i]);
+    wordtable_free(&maps[i]);
+  }
+  printf("[DEBUG]\t Counted corpus words over %zu shards\n", nshards);
+  free(shards);
+  free(maps);
+}
+
+/**
+ @brief Counts the words of a corpus file by memory-mapping it and splitting in place.
+ *
+ * Words are located directly over the mapped bytes and handed to the frequency map as
+ * (pointer, length) views, so a word's bytes are copied only the first time it is inserted.
+ * The mapping is advised as sequential so the kernel reads ahead and drops consumed pages.
+ * Large files are split into newline-aligned shards counted in parallel.
+ *
+ @param trainer Trainer whose pool does the counting.
+ @param freq_map Word frequency table to accumulate into.
+ @param input_path Path to the input corpus file.
+ @return 0 on success, 1 if the file can't be mapped or is compressed (caller should stream it instead),
+ *       -1 if the file can't be opened.
+*/
+static int count_words_mmap(Trainer* trainer, WordTable* freq_map, const char* input_path) {
+#ifdef _WIN32
+  (void)trainer; (void)freq_map; (void)input_path;
+  return 1;
+#else
+  int fd = open(input_path, O_RDONLY);
+  if (fd < 0) {
     fprintf(stderr, "[ERROR]\t Couldn't open file: %s\n", input_path);
-    strmap_free(&freq_map);
     return -1;
   }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return 1;
+  }
+  size_t size = (size_t)st.st_size;
+  if (size == 0) {
+    close(fd);
+    return 0;
+  }
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return 1;
+  if (corpus_detect_codec((const unsigned char*)map, size) != CORPUS_PLAIN) {
+    munmap(map, size);  // compressed, has to be decoded by the reader
+    return 1;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+  count_buffer_sharded(trainer, freq_map, (const char*)map, size);
+  munmap(map, size);
+  return 0;
+#endif
+}
 
-  char* line = (char*)malloc(INITIAL_STR_BUFFER);
-  if (!line) {
-    fprintf(stderr, "[ERROR]\t Memory allocation failed\n");
-    fclose(fp);
-    strmap_free(&freq_map);
-    return -1;
+/**
+ @brief Counts the words of many corpus files while a reader thread streams them in.
+ *
+ * The reader fills one buffer while the words of the other are counted, so reading from a slow
+ * disk overlaps with counting. Each chunk is split into newline-aligned shards on the trainer's
+ * pool; shard `t` always counts into the same table, and those tables are merged into `freq_map`
+ * once, after the last chunk, rather than after every chunk.
+ *
+ @param trainer Trainer whose pool does the counting.
+ @param freq_map Word frequency table to accumulate into.
+ @param files Expanded list of corpus files, read in order.
+ @return 0 on success, -1 if a file can't be read.
+*/
+static int count_words_reader(Trainer* trainer, WordTable* freq_map, const CorpusFiles* files) {
+  ThreadPool* pool = trainer_pool(trainer);
+  size_t nthreads = (size_t)threadpool_size(pool);
+  CountShard* shards = (CountShard*)malloc(nthreads * sizeof(CountShard));
+  WordTable* maps = (WordTable*)malloc(nthreads * sizeof(WordTable));
+  if (!shards || !maps) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of count shards\n");
+    exit(EXIT_FAILURE);
   }
-  size_t line_cap = INITIAL_STR_BUFFER;
-  while (fgets(line, line_cap, fp)) {
-    size_t len = strlen(line);
-    while (len == line_cap - 1 && line[len-1] != '\n') {
-      line_cap *= 2;
-      char* new_line = (char*)realloc(line, line_cap);
-      if (!new_line) {
-        fprintf(stderr, "[ERROR]\t Memory reallocation failed\n");
-        free(line);
-        fclose(fp);
-        strmap_free(&freq_map);
-        return -1;
-      }
-      line = new_line;
-      if (!fgets(line + len, line_cap - len, fp)) break;
-      len = strlen(line);
+  for (size_t t = 1; t < nthreads; t++) wordtable_init(&maps[t], INITIAL_STR_BUFFER);
+
+  int pre_tokenizer = trainer->config.pre_tokenizer;
+  CorpusReader* reader = reader_open(files, READER_CHUNK_BYTES, pre_tokenizer);
+  const char* data;
+  size_t size, nchunks = 0, nbytes = 0;
+  int status;
+  while ((status = reader_next(reader, &data, &size)) > 0) {
+    nchunks++;
+    nbytes += size;
+    size_t nshards = nthreads;
+    if (nshards > size / MIN_SHARD_BYTES) nshards = size / MIN_SHARD_BYTES;
+    if (nshards <= 1) {
+      count_range(freq_map, data, data + size, pre_tokenizer);
+      continue;
     }
-    if (len > 0 && line[len-1] == '\n') { line[len-1] = '\0'; }
-    char* tok = strtok(line, "\t\r\n ");
-    while (tok) {
-      strmap_increment(&freq_map, tok);
-      tok = strtok(NULL, "\t\r\n ");
+    const char* end = data + size;
+    const char* p = data;
+    for (size_t t = 0; t < nshards; t++) {
+      const char* stop = (t == nshards - 1) ? end : data + (size / nshards) * (t + 1);
+      if (stop < p) stop = p;
+      stop = shard_cut(data, stop, end, pre_tokenizer);
+      shards[t].begin = p;
+      shards[t].end = stop;
+      shards[t].table = (t == 0) ? freq_map : &maps[t];
+      shards[t].pre_tokenizer = pre_tokenizer;
+      p = stop;
     }
+    threadpool_run(pool, (int)nshards, count_shard_task, shards);
   }
-  free(line);
-  fclose(fp);
+  reader_close(reader);
 
+  for (size_t t = 1; t < nthreads; t++) {
+    wordtable_merge(freq_map, &maps[t]);
+    wordtable_free(&maps[t]);
+  }
+  free(shards);
+  free(maps);
+  if (status == 0) printf("[DEBUG]\t Read %zu files (%zu bytes) in %zu chunks\n", files->size, nbytes, nchunks);
+  return status;
+}
+
+// allocates one pending word table per pool thread on first use
+static void ensure_pending(Trainer* trainer) {
+  if (trainer->pending) return;
+  trainer->npending = (size_t)threadpool_size(trainer_pool(trainer));
+  trainer->pending = (WordTable*)malloc(trainer->npending * sizeof(WordTable));
+  if (!trainer->pending) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of pending word tables\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t t = 0; t < trainer->npending; t++) wordtable_init(&trainer->pending[t], INITIAL_STR_BUFFER);
+}
+
+// hands a counted table over to the pending counts; it's moved in as is while the first table is empty
+static void stage_words(Trainer* trainer, WordTable* table) {
+  ensure_pending(trainer);
+  WordTable* first = &trainer->pending[0];
+  if (first->size == 0) {
+    wordtable_free(first);
+    *first = *table;
+  } else {
+    wordtable_merge(first, table);
+    wordtable_free(table);
+  }
+}
+
+// gathers all pending counts into freq_map (the first table is moved, the others merged in thread order)
+static void drain_pending(Trainer* trainer, WordTable* freq_map) {
+  *freq_map = trainer->pending[0];
+  for (size_t t = 1; t < trainer->npending; t++) {
+    wordtable_merge(freq_map, &trainer->pending[t]);
+    wordtable_free(&trainer->pending[t]);
+  }
+  free(trainer->pending);
+  trainer->pending = NULL;
+  trainer->npending = 0;
+}
+
+/**
+ @brief Turns counted words into the trainer's corpus.
+ *
+ * Builds the character histogram, keeps the most frequent characters up to `character_coverage`,
+ * and stores every word as a run of ids (rare characters mapped to UNK) in the corpus arrays.
+ * Takes over `freq_map` and frees it.
+ *
+ @return 0 on success, -1 on allocation failure.
+*/
+static int build_corpus(Trainer* trainer, WordTable* freq_map) {
   // building character histogram
+  Arena* scratch = &trainer_scratch(trainer)[0];
   StrMap char_map;
   strmap_init(&char_map, INITIAL_VOCAB_SIZE);
-  strmap_iter(&freq_map, char_hist, &char_map);
+  char_map.arena = scratch;
+  wordtable_iter(freq_map, char_hist, &char_map);
   
   // collecting & sorting CharCount
   CharCount* counts = (CharCount*)malloc(INITIAL_VOCAB_SIZE * sizeof(CharCount));
@@ -278,39 +558,398 @@ int bpe_load_corpus(Trainer* trainer, const char* input_path) {
   }
   free(counts);
   strmap_free(&char_map);
+  arena_reset(scratch);
   
   // counting unique tokens
-  size_t N = 0;
-  strmap_iter(&freq_map, [](const char* k, uint64_t v, void* u){(*(size_t*)u)++;}, &N);
+  size_t N = freq_map->size;
   trainer->corpus.vocab_size = N;
-  trainer->corpus.words = (Symbol**)malloc(N * sizeof(Symbol*));
+  trainer->corpus.num_symbols = freq_map->arena_size - N;  // arena holds each key plus its NUL
+  trainer->corpus.symbols = (int32_t*)malloc((trainer->corpus.num_symbols + 1) * sizeof(int32_t));
+  trainer->corpus.offsets = (size_t*)malloc(N * sizeof(size_t));
+  trainer->corpus.lengths = (uint32_t*)malloc(N * sizeof(uint32_t));
   trainer->corpus.word_counts = (uint64_t*)malloc(N * sizeof(uint64_t));
+  trainer->corpus.active = (size_t*)malloc(N * sizeof(size_t));
+  if (!trainer->corpus.symbols || (N && (!trainer->corpus.offsets || !trainer->corpus.lengths || !trainer->corpus.word_counts || !trainer->corpus.active))) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of corpus arrays\n");
+    wordtable_free(freq_map);
+    return -1;
+  }
+
+  // populating symbol runs, mapping rare chars to UNK
+  size_t idx = 0, pos = 0;
+  BuildCtx c_btx = { trainer, &idx, &pos, keep_char };
+  wordtable_iter(freq_map, build_symbol_cb, &c_btx);
+  wordtable_free(freq_map);
 
-  // populating symbol chains, mapping rare chars to UNK
-  size_t idx = 0;
-  BuildCtx c_btx = { trainer, &idx, keep_char };
-  strmap_iter(&freq_map, build_symbol_cb, &c_btx);
+  // every word starts out active, single-token words are filtered right away
+  for (size_t wi = 0; wi < N; wi++) trainer->corpus.active[wi] = wi;
+  trainer->corpus.num_active = N;
+  refresh_active_words(trainer);
+  printf("[DEBUG]\t %zu of %zu words hold mergeable pairs\n", trainer->corpus.num_active, N);
 
-  strmap_free(&freq_map);
   bimap_init(&trainer->bigram_map, MIN_HEAP_SIZE);
   return 0;
 }
 
+/**
+ @brief Counts the words of corpus files into the trainer's pending word counts, without building the corpus.
+ *
+ * Lets the counts be saved with `bpe_save_counts` (or combined with more files, fed text or count
+ * files) before `bpe_build_corpus` / `bpe_train` turn them into the corpus. See `bpe_load_corpus_files`.
+ *
+ @param trainer Pointer to a trainer whose corpus isn't built yet.
+ @param paths Corpus files, directories or glob patterns.
+ @param npaths Number of entries in `paths`.
+ @return 0 on success, -1 on failure.
+*/
+int bpe_count_files(Trainer* trainer, const char* const* paths, size_t npaths) {
+  if (!trainer || !paths || npaths == 0) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or input path pointers\n");
+    return -1;
+  }
+  if (trainer->corpus.symbols) {
+    fprintf(stderr, "[ERROR]\t Corpus already loaded\n");
+    return -1;
+  }
+  CorpusFiles files;
+  corpus_files_init(&files);
+  for (size_t i = 0; i < npaths; i++) {
+    if (!paths[i] || corpus_files_expand(&files, paths[i]) != 0) {
+      corpus_files_free(&files);
+      return -1;
+    }
+  }
+  WordTable freq_map;
+  wordtable_init(&freq_map, INITIAL_STR_BUFFER);
+  int status = 1;
+  if (files.size == 1) status = count_words_mmap(trainer, &freq_map, files.paths[0]);
+  if (status == 1) status = count_words_reader(trainer, &freq_map, &files);
+  corpus_files_free(&files);
+  if (status != 0) {
+    wordtable_free(&freq_map);
+    return -1;
+  }
+
+  stage_words(trainer, &freq_map);
+  return 0;
+}
+
+/**
+ @brief Loads the training corpus from one or more text files and constructs the initial vocabulary and character histogram.
+ *
+ * This function performs the following steps:
+ *  1. Expands every path: a directory stands for all files below it and a pattern with wildcards
+ *     for its matches (both in name order).
+ *  2. Splits the text into tokens using tab, newline, space, and carriage return as delimiters.
+ *     A single regular file is memory-mapped and counted in newline-aligned shards on
+ *     `config.num_threads` threads; several files (or one that can't be mapped, or a gzip/zstd
+ *     file, decoded on the fly) are streamed by a reader thread with double buffering, so reading
+ *     and decompression overlap with counting.
+ *  3. Builds a frequency table of unique words using a growable, interning `WordTable`, adding
+ *     the words still pending from `bpe_feed`, `bpe_count_files` or `bpe_load_counts`.
+ *  4. Constructs a histogram of character frequencies across all words and determines which characters to retain
+ *     based on the `character_coverage` parameter in the configuration.
+ *  5. Initializes the corpus vocabulary:
+ *     - Assigns known characters their byte ID.
+ *     - Maps all rare or unknown characters to the special UNK token.
+ *     - Stores every word as a run of int32 ids in one contiguous `symbols` buffer,
+ *       addressed through per-word offsets and lengths.
+ *  6. Allocates and sets up the initial `bigram_map`.
+ *
+ @param trainer Pointer to the `Trainer` object being initialized.
+ @param paths Corpus files, directories or glob patterns.
+ @param npaths Number of entries in `paths`.
+ @return 0 on success, -1 on failure (e.g., file not found, memory allocation failure).
+ *
+ @note This is a prerequisite step before BPE training can start. Files are never concatenated:
+ *       words are copied only once, when first inserted into the frequency map.
+*/
+int bpe_load_corpus_files(Trainer* trainer, const char* const* paths, size_t npaths) {
+  if (bpe_count_files(trainer, paths, npaths) != 0) return -1;
+  return bpe_build_corpus(trainer);
+}
+
+/**
+ @brief Loads the training corpus from a single path, see `bpe_load_corpus_files`.
+ @param input_path Corpus file, directory or glob pattern.
+*/
+int bpe_load_corpus(Trainer* trainer, const char* input_path) {
+  if (!trainer || !input_path) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or input path pointers\n");
+    return -1;
+  }
+  return bpe_load_corpus_files(trainer, &input_path, 1);
+}
+
+typedef struct FeedShard {
+  const char* const* texts;
+  const size_t* lengths;
+  size_t n;   // no of buffers
+  size_t first, first_off;  // shard start: buffer index & byte offset
+  size_t last, last_off;  // shard end (exclusive): buffer index & byte offset
+  WordTable* table;   // the thread's feed table
+  int pre_tokenizer;
+} FeedShard;
+
+static void feed_shard_task(void* arg, int tid) {
+  FeedShard* s = &((FeedShard*)arg)[tid];
+  for (size_t j = s->first; j <= s->last && j < s->n; j++) {
+    size_t b = (j == s->first) ? s->first_off : 0;
+    size_t e = (j == s->last) ? s->last_off : s->lengths[j];
+    if (e > b) count_range(s->table, s->texts[j] + b, s->texts[j] + e, s->pre_tokenizer);
+  }
+}
+
+/**
+ @brief Counts the words of a batch of in-memory text buffers into the trainer.
+ *
+ * Counts accumulate across calls, and the buffers are only read during the call, so the caller
+ * may reuse them afterwards. A buffer's end always ends a word, so a word never spans two buffers.
+ * The batch is cut into byte ranges of about equal size (moved forward to the next delimiter,
+ * so no word is split) that the pool's threads count into pending tables of their own; those
+ * are merged when the corpus gets built, by `bpe_build_corpus`, `bpe_load_corpus` or `bpe_train`.
+ *
+ @param trainer Pointer to a trainer whose corpus isn't built yet.
+ @param texts Start of each buffer (need not be NUL-terminated).
+ @param lengths Length of each buffer in bytes.
+ @param n Number of buffers.
+ @return 0 on success, -1 on invalid arguments or if the corpus was already built.
+*/
+int bpe_feed(Trainer* trainer, const char* const* texts, const size_t* lengths, size_t n) {
+  if (!trainer || (n && (!texts || !lengths))) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or text buffer pointers\n");
+    return -1;
+  }
+  if (trainer->corpus.symbols) {
+    fprintf(stderr, "[ERROR]\t Corpus already built, can't feed more text\n");
+    return -1;
+  }
+  ThreadPool* pool = trainer_pool(trainer);
+  ensure_pending(trainer);
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) total += lengths[i];
+  size_t nshards = trainer->npending;
+  if (nshards > total / MIN_SHARD_BYTES) nshards = total / MIN_SHARD_BYTES;
+  if (nshards < 1) nshards = 1;
+
+  FeedShard* shards = (FeedShard*)malloc(nshards * sizeof(FeedShard));
+  if (!shards) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of feed shards\n");
+    exit(EXIT_FAILURE);
+  }
+  // mapping each cut of the concatenated bytes to a buffer & offset
+  size_t i = 0, base = 0, prev_i = 0, prev_off = 0;
+  for (size_t t = 0; t < nshards; t++) {
+    shards[t].texts = texts;
+    shards[t].lengths = lengths;
+    shards[t].n = n;
+    shards[t].table = &trainer->pending[t];
+    shards[t].pre_tokenizer = trainer->config.pre_tokenizer;
+    shards[t].first = prev_i;
+    shards[t].first_off = prev_off;
+    if (t == nshards - 1) {
+      prev_i = n;
+      prev_off = 0;
+    } else {
+      size_t pos = (total / nshards) * (t + 1);
+      while (i < n && base + lengths[i] <= pos) base += lengths[i++];
+      size_t off = (i < n) ? pos - base : 0;
+      if (i < n && trainer->config.pre_tokenizer != PRETOK_WHITESPACE) {
+        while (off < lengths[i] && !pretok_is_cut(texts[i], off, lengths[i])) off++;
+      } else if (i < n) {
+        off += scan_to_delim(texts[i] + off, lengths[i] - off);
+      }
+      if (i == prev_i && off < prev_off) off = prev_off;
+      prev_i = i;
+      prev_off = off;
+    }
+    shards[t].last = prev_i;
+    shards[t].last_off = prev_off;
+  }
+  threadpool_run(pool, (int)nshards, feed_shard_task, shards);
+  free(shards);
+  return 0;
+}
+
+/**
+ @brief Builds the corpus from the pending word counts (fed text, counted files & loaded count files).
+ *
+ * Called by `bpe_train` & `bpe_load_merges` on their own when words are pending but no corpus is built,
+ * so an explicit call is only needed to inspect the corpus first. No more words can be added afterwards.
+ *
+ @param trainer Pointer to a trainer holding pending word counts.
+ @return 0 on success, -1 if no words are pending or the corpus already exists.
+*/
+int bpe_build_corpus(Trainer* trainer) {
+  if (!trainer) {
+    fprintf(stderr, "[ERROR]\t NULL trainer pointer\n");
+    return -1;
+  }
+  if (trainer->corpus.symbols) {
+    fprintf(stderr, "[ERROR]\t Corpus already loaded\n");
+    return -1;
+  }
+  if (!trainer->pending) {
+    fprintf(stderr, "[ERROR]\t No words counted to build a corpus from\n");
+    return -1;
+  }
+  WordTable freq_map;
+  drain_pending(trainer, &freq_map);
+  return build_corpus(trainer, &freq_map);
+}
+
+/**
+ @brief Saves the pending word counts to a count file, so later runs can skip counting the corpus.
+ *
+ * Counts only exist until the corpus is built, so this goes between counting (`bpe_count_files`,
+ * `bpe_feed`, `bpe_load_counts`) and `bpe_build_corpus` / `bpe_train`; the counts stay pending.
+ *
+ @param trainer Pointer to a trainer holding pending word counts.
+ @param path Output path of the count file.
+ @param as_text Non-zero writes `word<TAB>count` lines instead of the compact binary layout.
+ @return 0 on success, -1 on failure.
+*/
+int bpe_save_counts(Trainer* trainer, const char* path, int as_text) {
+  if (!trainer || !path) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or count file path pointers\n");
+    return -1;
+  }
+  if (trainer->corpus.symbols || !trainer->pending) {
+    fprintf(stderr, "[ERROR]\t No pending word counts to save, count the corpus without building it first\n");
+    return -1;
+  }
+  WordTable words;
+  drain_pending(trainer, &words);
+  int status = counts_write(&words, path, as_text != 0);
+  if (status == 0) printf("[INFO]\t Saved %zu word counts to %s\n", words.size, path);
+  stage_words(trainer, &words);
+  return status;
+}
+
+typedef struct CountsShard {
+  const CorpusFiles* files;
+  size_t stride;  // no of shards, shard t reads files t, t + stride, ...
+  WordTable table;
+  int status;
+} CountsShard;
+
+static void read_counts_task(void* arg, int tid) {
+  CountsShard* shard = &((CountsShard*)arg)[tid];
+  for (size_t i = (size_t)tid; i < shard->files->size && shard->status == 0; i += shard->stride) {
+    shard->status = counts_read(&shard->table, shard->files->paths[i]);
+  }
+}
+
+/**
+ @brief Adds the words of count files written by `bpe_save_counts` (or `word<TAB>count` text files)
+ * to the pending word counts; counts of a word found in several files are summed.
+ *
+ * The files are read in parallel on the pool, each thread into a table of its own. On any error
+ * nothing is added.
+ *
+ @param trainer Pointer to a trainer whose corpus isn't built yet.
+ @param paths Count files, directories or glob patterns.
+ @param npaths Number of entries in `paths`.
+ @return 0 on success, -1 on failure.
+*/
+int bpe_load_counts(Trainer* trainer, const char* const* paths, size_t npaths) {
+  if (!trainer || !paths || npaths == 0) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or count file path pointers\n");
+    return -1;
+  }
+  if (trainer->corpus.symbols) {
+    fprintf(stderr, "[ERROR]\t Corpus already loaded\n");
+    return -1;
+  }
+  CorpusFiles files;
+  corpus_files_init(&files);
+  for (size_t i = 0; i < npaths; i++) {
+    if (!paths[i] || corpus_files_expand(&files, paths[i]) != 0) {
+      corpus_files_free(&files);
+      return -1;
+    }
+  }
+  ThreadPool* pool = trainer_pool(trainer);
+  size_t nshards = (size_t)threadpool_size(pool);
+  if (nshards > files.size) nshards = files.size;
+  CountsShard* shards = (CountsShard*)malloc(nshards * sizeof(CountsShard));
+  if (!shards) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of count file shards\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t t = 0; t < nshards; t++) {
+    shards[t].files = &files;
+    shards[t].stride = nshards;
+    wordtable_init(&shards[t].table, INITIAL_STR_BUFFER);
+    shards[t].status = 0;
+  }
+  threadpool_run(pool, (int)nshards, read_counts_task, shards);
+
+  int status = 0;
+  for (size_t t = 0; t < nshards; t++) {
+    if (shards[t].status != 0) status = -1;
+  }
+  for (size_t t = 0; t < nshards; t++) {
+    if (status == 0) stage_words(trainer, &shards[t].table);
+    else wordtable_free(&shards[t].table);
+  }
+  if (status == 0) printf("[DEBUG]\t Loaded word counts from %zu files\n", files.size);
+  free(shards);
+  corpus_files_free(&files);
+  return status;
+}
+
+typedef struct PairShard {
+  const Trainer* trainer;
+  size_t begin, end;  // range [begin, end) of `corpus.active`
+  BIMap* map;   // shard-local pair counts and occurrence lists
+  uint64_t total;   // pair occurrences counted in the range
+} PairShard;
+
+// counts every adjacent non-UNK pair of the words in [shard->begin, shard->end)
+static void count_pairs_range(PairShard* shard) {
+  const Corpus* corpus = &shard->trainer->corpus;
+  int32_t unk_id = shard->trainer->config.unk_id;
+  uint64_t total = 0;
+  for (size_t a = shard->begin; a < shard->end; a++) {
+    size_t wi = corpus->active[a];
+    const int32_t* ids = corpus->symbols + corpus->offsets[wi];
+    uint32_t len = corpus->lengths[wi];
+    uint64_t wcount = corpus->word_counts[wi];
+    for (uint32_t i = 0; i + 1 < len; i++) {
+      if (ids[i] == unk_id || ids[i + 1] == unk_id) continue;
+      PairKey key = { ids[i], ids[i + 1] };
+      Info* info = bimap_get(shard->map, key);
+      info->freq += wcount;
+      wordlist_push(&info->words, wi);
+      total += wcount;
+    }
+  }
+  shard->total = total;
+}
+
+static void count_pairs_task(void* arg, int tid) {
+  count_pairs_range(&((PairShard*)arg)[tid]);
+}
+
 /**
  @brief Scans the current corpus and counts the frequency of all valid bigrams, populating the heap for training.
  *
- * This function processes every pair of consecutive non-deleted symbols across all words in the corpus,
+ * This function processes every pair of consecutive symbols across all words in the corpus,
  * counting how often each bigram (pair of IDs) occurs. It maintains a hash map (`bigram_map`) for fast lookup.
- * It then pushes all bigrams whose frequency is greater than or equal to `min_pair_freq` into the trainer's max-heap.
+ * It then loads all bigrams whose frequency is greater than or equal to `min_pair_freq` into the trainer's max-heap.
  *
  * The function performs two passes:
- *  - First pass: Scans the entire corpus and accumulates frequencies in the `bigram_map`.
- *  - Second pass: Pushes qualifying pairs into the heap based on their frequency threshold.
+ *  - First pass: Splits the words into contiguous ranges counted on `config.num_threads` threads, each into
+ *    its own `BIMap` along with the words every pair occurs in (the occurrence index used by `bpe_merge_batch`).
+ *    The per-thread maps are then reduced into `bigram_map` in range order, which reproduces the serial
+ *    insertion order and ascending occurrence lists exactly.
+ *  - Second pass: Collects qualifying pairs and bulk-builds the heap from them in one heapify.
  *
  @param trainer Pointer to the initialized `Trainer` containing the corpus.
  *
  @note This is the core pre-processing step that makes bigram statistics available for the merge loop.
- *       It also logs progress periodically for large datasets (every 10k words).
+ *       Small corpora (under `MIN_SHARD_WORDS` words per thread) are counted on the calling thread.
 */
 void bpe_count_bigrams(Trainer* trainer) {
   if (!trainer) {
@@ -318,69 +957,304 @@ void bpe_count_bigrams(Trainer* trainer) {
     exit(EXIT_FAILURE);
   }
 
-  size_t v = trainer->corpus.vocab_size;
+  refresh_active_words(trainer);
+  size_t v = trainer->corpus.num_active;
   uint64_t min_freq = trainer->config.min_pair_freq;
   uint64_t total_pairs = 0;
-  size_t unique_pairs = 0;
+  BIMap* map = &trainer->bigram_map;
 
-  printf("[INFO]\t Counting bigrams from %zu words...\n", v);
+  ThreadPool* pool = trainer_pool(trainer);
+  size_t nshards = (size_t)threadpool_size(pool);
+  if (nshards > v / MIN_SHARD_WORDS) nshards = v / MIN_SHARD_WORDS;
+  if (nshards < 1) nshards = 1;
+  printf("[INFO]\t Counting bigrams from %zu active words on %zu thread(s)...\n", v, nshards);
 
   // First pass: count all bigram frequencies
-  for (size_t wi = 0; wi < v; wi++) {
-    Symbol* s = trainer->corpus.words[wi];
-    uint64_t wcount = trainer->corpus.word_counts[wi];
-    while (s && s->next) {
-      if (s->deleted || s->next->deleted || 
-        s->id == trainer->config.unk_id || s->next->id == trainer->config.unk_id) {
-        s = s->next;
-        continue;
-      }
-        
-      PairKey key = { s->id, s->next->id };
-      Info* info = bimap_get(&trainer->bigram_map, key);
-        
-      if (info->freq == 0) {
-        unique_pairs++;
-        info->version = 0; // Initialize version
-      }
-        
-      info->freq += wcount;
-      total_pairs += wcount;  
-      s = s->next;
+  PairShard* shards = (PairShard*)malloc(nshards * sizeof(PairShard));
+  BIMap* maps = (BIMap*)malloc(nshards * sizeof(BIMap));
+  if (!shards || !maps) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of bigram shards\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t t = 0; t < nshards; t++) {
+    shards[t].trainer = trainer;
+    shards[t].begin = v * t / nshards;
+    shards[t].end = v * (t + 1) / nshards;
+    shards[t].total = 0;
+    if (nshards == 1) {
+      shards[t].map = map;
+    } else {
+      bimap_init(&maps[t], MIN_HEAP_SIZE);
+      shards[t].map = &maps[t];
     }
-    
-    if (wi % 10000 == 0 && wi > 0) {
-      printf("[DEBUG]\t Processed %zu/%zu words, found %zu unique pairs\n", wi, v, unique_pairs);
+  }
+  threadpool_run(pool, (int)nshards, count_pairs_task, shards);
+  for (size_t t = 0; t < nshards; t++) {
+    total_pairs += shards[t].total;
+    if (nshards == 1) break;
+    for (size_t i = 0; i < maps[t].size; i++) {
+      Info* info = bimap_get(map, maps[t].keys[i]);
+      info->freq += maps[t].infos[i].freq;
+      wordlist_append(&info->words, &maps[t].infos[i].words);
     }
+    bimap_free(&maps[t]);
   }
+  free(shards);
+  free(maps);
+  size_t unique_pairs = map->size;
 
-  // Second pass: populate heap with frequent pairs
+  // Second pass: heapify the frequent pairs in one go, each keyed by its BIMap slot
+  HeapEntry* entries = (HeapEntry*)malloc((unique_pairs + 1) * sizeof(HeapEntry));
+  if (!entries) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of heap entries\n");
+    exit(EXIT_FAILURE);
+  }
   size_t heap_entries = 0;
-  for (size_t i = 0; i < trainer->bigram_map.nbuckets; i++) {
-    for (BIEntry* e = trainer->bigram_map.buckets[i]; e; e = e->next) {
-      if (e->info.freq >= min_freq) {
-        heap_push(&trainer->heap, e->key, e->info.freq, e->info.version);
-        heap_entries++;
-      }
+  for (size_t i = 0; i < map->size; i++) {
+    if (map->infos[i].freq >= min_freq) {
+      HeapEntry* e = &entries[heap_entries++];
+      e->key = map->keys[i];
+      e->freq = map->infos[i].freq;
+      e->version = 0;
+      e->slot = (uint32_t)i;
+    } else {
+      wordlist_free(&map->infos[i].words);  // a pair below threshold never becomes mergeable again
     }
   }
+  heap_build(&trainer->heap, entries, heap_entries);
+  free(entries);
 
   printf("[INFO]\t Counted %llu total bigram occurrences, %zu unique pairs\n", (unsigned long long)total_pairs, unique_pairs);
   printf("[INFO]\t Added %zu pairs to heap (freq >= %llu)\n", heap_entries, (unsigned long long)min_freq);
 }
 
+typedef struct MergeJob {
+  PairKey key;
+  int32_t new_id;
+  uint64_t freq;  // frequency of the pair when it was picked
+  WordList occs;  // the pair's occurrence list, taken over from its Info
+} MergeJob;
+
+typedef struct MergeDelta {
+  FreqChangeMap changes;  // neighbour pair deltas seen by one shard for one job
+  BIMap* pairs;   // receives the occurrence lists of newly formed pairs
+  uint64_t merged;  // merged occurrences, weighted by word counts
+} MergeDelta;
+
+typedef struct MergeShard {
+  Trainer* trainer;
+  const MergeJob* jobs;
+  int njobs;
+  const size_t* words;  // union of the jobs' occurrence lists, ascending
+  const uint64_t* masks;  // bit j is set if the word is listed for jobs[j]
+  size_t begin, end;  // range [begin, end) of `words` rewritten by this shard
+  MergeDelta* deltas;   // one per job
+} MergeShard;
+
+// rewrites `job->key` -> `job->new_id` inside word `wi`, recording neighbour deltas
+static void merge_word(Corpus* corpus, int32_t unk_id, size_t wi, const MergeJob* job, MergeDelta* delta) {
+  int32_t* ids = corpus->symbols + corpus->offsets[wi];
+  uint32_t len = corpus->lengths[wi];
+  uint64_t word_count = corpus->word_counts[wi];
+  PairKey key = job->key;
+  int32_t new_id = job->new_id;
+
+  // compacts the word in place: `out` trails `i`, so ids[out - 1] is the already
+  // rewritten left neighbour while ids[i + 2] is the untouched right neighbour
+  uint32_t out = 0;
+  for (uint32_t i = 0; i < len; ) {
+    if (i + 1 >= len || ids[i] != key.first || ids[i + 1] != key.second) {
+      ids[out++] = ids[i++];
+      continue;
+    }
+
+    // Count this merge
+    delta->merged += word_count;
+
+    // Track frequency changes for neighboring pairs, pairs with UNK are never counted
+    // Left neighbor
+    if (out > 0 && ids[out - 1] != unk_id) {
+      PairKey old_left = {ids[out - 1], key.first};
+      PairKey new_left = {ids[out - 1], new_id};
+      freq_change_add(&delta->changes, pair_pack(old_left), -(int64_t)word_count);
+      freq_change_add(&delta->changes, pair_pack(new_left), (int64_t)word_count);
+      wordlist_push(&bimap_get(delta->pairs, new_left)->words, wi);
+    }
+
+    // Right neighbor
+    if (i + 2 < len && ids[i + 2] != unk_id) {
+      PairKey old_right = {key.second, ids[i + 2]};
+      PairKey new_right = {new_id, ids[i + 2]};
+      freq_change_add(&delta->changes, pair_pack(old_right), -(int64_t)word_count);
+      freq_change_add(&delta->changes, pair_pack(new_right), (int64_t)word_count);
+      wordlist_push(&bimap_get(delta->pairs, new_right)->words, wi);
+    }
+
+    // Perform the actual merge
+    ids[out++] = new_id;
+    i += 2;
+  }
+  corpus->lengths[wi] = out;
+}
+
+static void merge_words_range(MergeShard* shard) {
+  Corpus* corpus = &shard->trainer->corpus;
+  int32_t unk_id = shard->trainer->config.unk_id;
+  for (size_t i = shard->begin; i < shard->end; ++i) {
+    // jobs run in rank order, leaving each word (and each job's deltas) exactly as sequential merges would
+    for (int j = 0; j < shard->njobs; j++) {
+      if ((shard->masks[i] >> j) & 1) merge_word(corpus, unk_id, shard->words[i], &shard->jobs[j], &shard->deltas[j]);
+    }
+  }
+}
+
+static void merge_words_task(void* arg, int tid) {
+  merge_words_range(&((MergeShard*)arg)[tid]);
+}
+
+// merges the jobs' ascending occurrence lists into one ascending word list with membership bits
+static size_t union_occ_lists(const MergeJob* jobs, int njobs, Arena* arena, size_t** words_out, uint64_t** masks_out) {
+  size_t total = 0;
+  for (int j = 0; j < njobs; j++) total += jobs[j].occs.size;
+  size_t* words = (size_t*)arena_alloc(arena, total * sizeof(size_t));
+  uint64_t* masks = (uint64_t*)arena_alloc(arena, total * sizeof(uint64_t));
+  size_t* tmp_words = (size_t*)arena_alloc(arena, total * sizeof(size_t));
+  uint64_t* tmp_masks = (uint64_t*)arena_alloc(arena, total * sizeof(uint64_t));
+
+  size_t n = 0;
+  for (int j = 0; j < njobs; j++) {
+    const WordList* occs = &jobs[j].occs;
+    uint64_t bit = (uint64_t)1 << j;
+    size_t a = 0, b = 0, m = 0;
+    while (a < n || b < occs->size) {
+      if (b >= occs->size || (a < n && words[a] < occs->idx[b])) {
+        tmp_words[m] = words[a];
+        tmp_masks[m++] = masks[a++];
+      } else if (a >= n || occs->idx[b] < words[a]) {
+        tmp_words[m] = occs->idx[b++];
+        tmp_masks[m++] = bit;
+      } else {
+        tmp_words[m] = words[a];
+        tmp_masks[m++] = masks[a++] | bit;
+        b++;
+      }
+    }
+    size_t* sw = words; words = tmp_words; tmp_words = sw;
+    uint64_t* sm = masks; masks = tmp_masks; tmp_masks = sm;
+    n = m;
+  }
+  *words_out = words;
+  *masks_out = masks;
+  return n;
+}
+
+// true if `key` shares a symbol with any pair already picked for the group
+static bool pair_conflicts(const MergeJob* jobs, int njobs, PairKey key) {
+  for (int j = 0; j < njobs; j++) {
+    PairKey k = jobs[j].key;
+    if (key.first == k.first || key.first == k.second || key.second == k.first || key.second == k.second) return true;
+  }
+  return false;
+}
+
+/**
+ @brief Publishes one rewritten job: reduces its shard deltas into `bigram_map` & the heap and records the merge.
+ @param deltas The job's `MergeDelta` of the first shard; the others follow every `stride` entries.
+ @param direct True if the shard wrote its new pairs straight into `bigram_map`.
+*/
+static void commit_merge(Trainer* trainer, const MergeJob* job, MergeDelta* deltas, size_t nshards, size_t stride, bool direct) {
+  PairKey key = job->key;
+  uint64_t min_freq = trainer->config.min_pair_freq;
+  printf("[MERGE]\t Merging (%d,%d) freq=%llu -> new_id=%d (merge %zu)\n", key.first, key.second, (unsigned long long)job->freq, job->new_id, trainer->num_merges + 1);
+
+  // Reduce shards in order: new pairs are registered in the same order, and their
+  // occurrence lists stay ascending, exactly as a single serial pass would leave them
+  FreqChangeMap* freq_changes = &deltas[0].changes;
+  uint64_t total_merge_count = 0;
+  for (size_t t = 0; t < nshards; t++) {
+    MergeDelta* d = &deltas[t * stride];
+    total_merge_count += d->merged;
+    if (!direct) {
+      for (size_t i = 0; i < d->pairs->size; i++) {
+        Info* pair_info = bimap_get(&trainer->bigram_map, d->pairs->keys[i]);
+        wordlist_append(&pair_info->words, &d->pairs->infos[i].words);
+      }
+    }
+    if (t == 0) continue;
+    for (int b = 0; b < FREQ_CHANGE_BUCKETS; b++) {
+      for (FreqChange* fc = d->changes.buckets[b]; fc; fc = fc->next) {
+        freq_change_add(freq_changes, fc->pair_hash, fc->delta);
+      }
+    }
+  }
+
+  // Apply frequency changes
+  for (int i = 0; i < FREQ_CHANGE_BUCKETS; i++) {
+    for (FreqChange* fc = freq_changes->buckets[i]; fc; fc = fc->next) {
+      uint64_t pair_hash = fc->pair_hash;
+      int64_t delta = fc->delta;
+
+      PairKey pk = pair_unpack(pair_hash);
+
+      // Skip if this is the pair we just merged
+      if (pk.first == key.first && pk.second == key.second) {
+        continue;
+      }
+
+      Info* pair_info = bimap_get(&trainer->bigram_map, pk);
+      // Apply frequency change safely
+      if (delta < 0) {
+        uint64_t abs_delta = (uint64_t)(-delta);
+        if (pair_info->freq >= abs_delta) {
+          pair_info->freq -= abs_delta;
+        } else {
+          pair_info->freq = 0;
+        }
+      } else {
+        pair_info->freq += (uint64_t)delta;
+      }
+
+      // Re-prioritize the pair's heap slot, dropping it once below threshold. Only the merge that
+      // forms a pair's newer symbol ever adds to its count, so a dropped pair's words aren't needed again
+      uint32_t slot = bimap_slot(&trainer->bigram_map, pair_info);
+      if (pair_info->freq >= min_freq) {
+        heap_update(&trainer->heap, slot, pk, pair_info->freq);
+      } else {
+        heap_remove(&trainer->heap, slot);
+        wordlist_free(&pair_info->words);
+      }
+    }
+  }
+
+  // Mark the merged pair as processed (re-fetched: insertions above may have moved it)
+  Info* info = bimap_get(&trainer->bigram_map, key);
+  info->freq = 0;
+  info->version++;
+  if (trainer->num_merges < trainer->config.target_vocab_size) {
+    trainer->merge_ops[trainer->num_merges] = key;
+  }
+  trainer->num_merges++;
+  printf("[DEBUG]\t Merged %llu occurrences in corpus\n", (unsigned long long)total_merge_count);
+}
+
 /**
  @brief Perform a batch of BPE merges based on the most frequent bigrams.
  *
- * This function repeatedly pops the most frequent valid bigram from the heap and merges it,
- * updating affected bigrams' frequencies using a hash-based difference tracking mechanism.
- * This avoids expensive rescans or linear recomputations.
+ * This function repeatedly takes the most frequent valid bigram off the heap together with the
+ * pairs queued right behind it, up to the first one that shares a symbol with a pair already taken,
+ * and applies the whole group in a single pass over the words they occur in. The result is the same
+ * as merging them one at a time: disjoint merges can't change each other's counts, and every pair a
+ * merge forms is outranked by the old pair it replaces (never more frequent, with a larger new id),
+ * which is still queued behind the whole group. The group is then committed in rank order.
  *
  * The function maintains:
- * - Lazy validation: Skips stale heap entries by checking version mismatch.
- * - In-place merges: Symbol chains are modified directly.
+ * - Indexed heap: every pair owns a single heap slot (its BIMap index) whose priority is
+ *   updated in place, so popped entries are always current and the heap holds only live pairs.
+ * - Occurrence index: Only the words listed in the pairs' `Info.words` are visited, and every
+ *   word in which a merge creates a new neighbour pair is appended to that pair's list.
+ * - In-place merges: each word's id run is compacted directly inside `corpus.symbols`.
  * - Frequency tracking: Uses 64-bit hash keys to track deltas in neighbor frequencies.
- * - Efficient heap updates: Only pushes new or changed bigrams above threshold.
+ * - Efficient heap updates: Only new or changed bigrams touch the heap; pairs below threshold leave it.
  *
  @param trainer Pointer to the initialized Trainer instance.
  @param batch_size Number of merges to perform in one go.
@@ -399,188 +1273,98 @@ int bpe_merge_batch(Trainer* trainer, int batch_size) {
   }
 
   int merges_done = 0;
-  int stale_entries = 0;
   uint64_t min_freq = trainer->config.min_pair_freq;
-  
+  ThreadPool* pool = trainer_pool(trainer);
+  Arena* scratch = trainer_scratch(trainer);
+  MergeJob jobs[MAX_MERGE_GROUP];
+
   while (merges_done < batch_size && !heap_empty(&trainer->heap)) {
-    HeapEntry top = heap_pop(&trainer->heap);
-    PairKey key = top.key;
+    // Pick the group: the top pair, then the following ones until a pair shares a symbol
+    int limit = batch_size - merges_done;
+    if (limit > MAX_MERGE_GROUP) limit = MAX_MERGE_GROUP;
+    int njobs = 0;
+    while (njobs < limit && !heap_empty(&trainer->heap)) {
+      PairKey key = trainer->heap.data[0].key;
+      if (pair_conflicts(jobs, njobs, key)) break;
+      heap_pop(&trainer->heap);
+      Info* info = bimap_get(&trainer->bigram_map, key);
 
-    Info* info = bimap_get(&trainer->bigram_map, key);
+      // Verify frequency is still above threshold
+      if (info->freq < min_freq) {
+        continue;
+      }
 
-    // Skip stale heap entries (version mismatch)
-    if (top.version != info->version) {
-      stale_entries++;
-      continue;
+      // the merged pair can never be formed again, so its occurrence list is taken over here
+      MergeJob* job = &jobs[njobs];
+      job->key = key;
+      job->new_id = INITIAL_VOCAB_SIZE + (int32_t)(trainer->num_merges + njobs);
+      job->freq = info->freq;
+      job->occs = info->words;
+      info->words.idx = NULL;
+      info->words.size = info->words.cap = 0;
+      njobs++;
     }
+    if (njobs == 0) continue;
 
-    // Verify frequency is still above threshold
-    uint64_t current_freq = info->freq;
-    if (current_freq < min_freq) {
-      continue;
-    }
+    // everything below lives in the scratch arenas until the group is committed
+    for (size_t t = 0; t < trainer->nscratch; t++) arena_reset(&scratch[t]);
+    size_t* words = NULL;
+    uint64_t* masks = NULL;
+    size_t nwords = union_occ_lists(jobs, njobs, &scratch[0], &words, &masks);
 
-    // Proceed with merge
-    int32_t new_id = INITIAL_VOCAB_SIZE + trainer->num_merges;
-    printf("[MERGE]\t Merging (%d,%d) freq=%llu -> new_id=%d (merge %zu)\n", key.first, key.second, (unsigned long long)current_freq, new_id, trainer->num_merges + 1);
-
-    if (trainer->num_merges < trainer->config.target_vocab_size) {
-      trainer->merge_ops[trainer->num_merges] = key;
-    }
-
-    // Track affected pairs and their frequency changes using our C hash table
-    FreqChangeMap freq_changes;
-    freq_change_init(&freq_changes);
-    uint64_t total_merge_count = 0;
-        
-    // Perform merges in all words
-    for (size_t wi = 0; wi < trainer->corpus.vocab_size; ++wi) {
-      Symbol* s = trainer->corpus.words[wi];
-      uint64_t word_count = trainer->corpus.word_counts[wi];
-      
-      while (s && s->next) {
-        if (s->deleted || s->next->deleted ||
-          s->id != key.first || s->next->id != key.second) {
-          s = s->next;
-          continue;
-        }
-
-        // Count this merge
-        total_merge_count += word_count;
-        
-        // Track frequency changes for neighboring pairs
-        // Left neighbor
-        if (s->prev && !s->prev->deleted) {
-          PairKey old_left = {s->prev->id, s->id};
-          PairKey new_left = {s->prev->id, new_id};
-          uint64_t old_hash = ((uint64_t)old_left.first << 32) | (uint64_t)old_left.second;
-          uint64_t new_hash = ((uint64_t)new_left.first << 32) | (uint64_t)new_left.second;
-          freq_change_add(&freq_changes, old_hash, -(int64_t)word_count);
-          freq_change_add(&freq_changes, new_hash, (int64_t)word_count);
-        }
-        
-        // Right neighbor  
-        if (s->next->next && !s->next->next->deleted) {
-          PairKey old_right = {s->next->id, s->next->next->id};
-          PairKey new_right = {new_id, s->next->next->id};
-          uint64_t old_hash = ((uint64_t)old_right.first << 32) | (uint64_t)old_right.second;
-          uint64_t new_hash = ((uint64_t)new_right.first << 32) | (uint64_t)new_right.second;
-          freq_change_add(&freq_changes, old_hash, -(int64_t)word_count);
-          freq_change_add(&freq_changes, new_hash, (int64_t)word_count);
-        }
-
-        // Perform the actual merge
-        Symbol* b = s->next;
-        s->id = new_id;
-        s->next = b->next;
-        if (b->next) {
-          b->next->prev = s;
-        }
-        b->deleted = true;
-        // Continue from the merged symbol
-        // Don't advance s here - let the outer loop handle it
+    // Rewrite the words on up to one shard per pool thread
+    size_t nshards = (size_t)threadpool_size(pool);
+    if (nshards > nwords / MIN_SHARD_WORDS) nshards = nwords / MIN_SHARD_WORDS;
+    if (nshards < 1) nshards = 1;
+    bool direct = nshards == 1;   // a single shard registers new pairs in bigram_map itself
+    size_t ndeltas = nshards * (size_t)njobs;
+    MergeShard* shards = (MergeShard*)arena_alloc(&scratch[0], nshards * sizeof(MergeShard));
+    MergeDelta* deltas = (MergeDelta*)arena_alloc(&scratch[0], ndeltas * sizeof(MergeDelta));
+    BIMap* maps = (BIMap*)arena_alloc(&scratch[0], ndeltas * sizeof(BIMap));
+    for (size_t d = 0; d < ndeltas; d++) {
+      freq_change_init(&deltas[d].changes, &scratch[d / njobs]);
+      deltas[d].merged = 0;
+      if (direct) {
+        deltas[d].pairs = &trainer->bigram_map;
+      } else {
+        bimap_init(&maps[d], 0);
+        deltas[d].pairs = &maps[d];
       }
     }
-
-    // Apply frequency changes
-    for (int i = 0; i < FREQ_CHANGE_BUCKETS; i++) {
-      for (FreqChange* fc = freq_changes.buckets[i]; fc; fc = fc->next) {
-        uint64_t pair_hash = fc->pair_hash;
-        int64_t delta = fc->delta;
-        
-        PairKey pk = {(int32_t)(pair_hash >> 32), (int32_t)(pair_hash & 0xFFFFFFFF)};
-        
-        // Skip if this is the pair we just merged
-        if (pk.first == key.first && pk.second == key.second) {
-          continue;
-        }
-        
-        Info* pair_info = bimap_get(&trainer->bigram_map, pk);
-        // Apply frequency change safely
-        if (delta < 0) {
-          uint64_t abs_delta = (uint64_t)(-delta);
-          if (pair_info->freq >= abs_delta) {
-            pair_info->freq -= abs_delta;
-          } else {
-            pair_info->freq = 0;
-          }
-        } else {
-          pair_info->freq += (uint64_t)delta;
-        }
-
-        // Add to heap if frequency meets threshold
-        if (pair_info->freq >= min_freq) {
-          pair_info->version++;
-          heap_push(&trainer->heap, pk, pair_info->freq, pair_info->version);
-        }
-      }
+    for (size_t t = 0; t < nshards; t++) {
+      MergeShard* sh = &shards[t];
+      sh->trainer = trainer;
+      sh->jobs = jobs;
+      sh->njobs = njobs;
+      sh->words = words;
+      sh->masks = masks;
+      sh->begin = nwords * t / nshards;
+      sh->end = nwords * (t + 1) / nshards;
+      sh->deltas = &deltas[t * njobs];
     }
+    threadpool_run(pool, (int)nshards, merge_words_task, shards);
 
-    // Clean up frequency changes map
-    freq_change_free(&freq_changes);
+    for (int j = 0; j < njobs; j++) {
+      commit_merge(trainer, &jobs[j], &deltas[j], nshards, (size_t)njobs, direct);
+    }
 
-    // Mark the merged pair as processed
-    info->freq = 0;
-    info->version++;
-    trainer->num_merges++;
-    merges_done++;
-    
-    printf("[DEBUG]\t Merged %llu occurrences in corpus\n", (unsigned long long)total_merge_count);
-  }
-  if (stale_entries > 0) {
-    printf("[DEBUG]\t Skipped %d stale heap entries\n", stale_entries);
+    // Clean up shard maps & the merged pairs' lists (frequency changes go with the next reset)
+    for (size_t d = 0; d < ndeltas && !direct; d++) bimap_free(&maps[d]);
+    for (int j = 0; j < njobs; j++) wordlist_free(&jobs[j].occs);
+    merges_done += njobs;
   }
 
   return merges_done;
 }
 
-/**
- @brief Safely remove all symbols marked as `deleted` from the corpus.
- *
- * This function scans all words in the corpus and frees memory of symbols marked deleted
- * during BPE merges. It also updates the `prev` and `next` pointers to maintain
- * linked list consistency for remaining symbols.
- *
- * Should be called periodically (e.g., every few thousand merges) to avoid memory bloat
- * and dangling pointer references.
- *
- @param trainer Pointer to the Trainer whose corpus contains the symbols.
- *
- * Example: After merging "th" and "e", the original "e" Symbol is marked deleted.
- * This function will safely unlink and free it.
-*/
-void free_deleted_symbols(Trainer* trainer) {
-  if (!trainer) return;
-  for (size_t wi = 0; wi < trainer->corpus.vocab_size; ++wi) {
-    Symbol* s = trainer->corpus.words[wi];
-    Symbol* prev = NULL;
-    while (s) {
-      if (s->deleted) {
-        Symbol* to_free = s;
-        if (prev) {
-          prev->next = s->next;
-        } else {
-          trainer->corpus.words[wi] = s->next;
-        }
-        if (s->next) { s->next->prev = prev; }
-        s = s->next;
-        free(to_free);
-      } else {
-        prev = s;
-        s = s->next;
-      }
-    }
-  }
-}
-
 /**
  @brief Executes the BPE training loop until the target vocabulary size is reached.
  *
  * This function drives the main training process by:
- *  - Initializing the bigram heap and frequency map
+ *  - Initializing the bigram heap and frequency map (unless resumed via `bpe_resume`)
  *  - Dynamically determining a batch size for each iteration based on the top bigram frequency
  *  - Performing batch merges via `bpe_merge_batch`
- *  - Periodically freeing deleted symbols to reduce memory footprint
+ *  - Writing checkpoints between batches when `bpe_set_checkpoint` is active
  *
  * The batch size is adaptively chosen to balance merge speed and accuracy.
  * It ensures the training progresses efficiently while still considering
@@ -592,18 +1376,26 @@ void free_deleted_symbols(Trainer* trainer) {
  *  - A batch merge results in no actual merges (convergence)
  *
  @param trainer A pointer to the initialized Trainer structure
- @return The total number of merges performed during training
+ @return The total number of merges performed during training (including resumed ones)
 */
 int bpe_train(Trainer* trainer) {
   if (!trainer) {
     fprintf(stderr, "[ERROR]\t Trainer pointer is NULL!\n");
     return -1;
   }
+  if (!trainer->corpus.symbols && trainer->pending && bpe_build_corpus(trainer) != 0) return -1;
   printf("[INFO]\t Starting BPE training (target vocab size: %zu)\n", trainer->config.target_vocab_size);  
-  bpe_init(trainer);
-  int total_merges = 0;
+  // a pair table that is already built (resumed run or earlier call) is carried on from
+  if (trainer->bigram_map.size == 0) {
+    bpe_init(trainer);
+  } else {
+    printf("[INFO]\t Continuing from %zu merges\n", trainer->num_merges);
+  }
+  int total_merges = (int)trainer->num_merges;
   int target_merges = (int)trainer->config.target_vocab_size - INITIAL_VOCAB_SIZE;
   printf("[INFO]\t Need to perform %d merges to reach target vocab size\n", target_merges);
+  int next_refresh = total_merges + ACTIVE_REFRESH_MERGES;
+  checkpoint_watch(trainer, true);
 
   while (total_merges < target_merges) {
     if (heap_empty(&trainer->heap)) {
@@ -635,11 +1427,13 @@ int bpe_train(Trainer* trainer) {
       break;
     }
     total_merges += merged;
+    checkpoint_poll(trainer, (size_t)(total_merges - merged));
 
-    // Periodic cleanup
-    if (total_merges % 100 == 0) {
-      printf("[DEBUG]\t Cleaning up deleted symbols after %d merges\n", total_merges);
-      free_deleted_symbols(trainer);
+    // Periodically drop words that collapsed to a single token from the active list
+    if (total_merges >= next_refresh) {
+      refresh_active_words(trainer);
+      next_refresh = total_merges + ACTIVE_REFRESH_MERGES;
+      printf("[DEBUG]\t Active words: %zu of %zu\n", trainer->corpus.num_active, trainer->corpus.vocab_size);
     }
 
     // Progress reporting
@@ -648,8 +1442,7 @@ int bpe_train(Trainer* trainer) {
                100.0 * total_merges / target_merges);
     }
   }
-  printf("[INFO]\t Final cleanup of deleted symbols\n");
-  free_deleted_symbols(trainer);
+  checkpoint_watch(trainer, false);
   printf("[INFO]\t Training completed. Performed %d merges\n", total_merges);
   return total_merges;
 }
@@ -661,11 +1454,12 @@ int bpe_train(Trainer* trainer) {
  *  - A vocabulary file (`vocab_path`) containing each token string and its frequency
  *  - A merge operations file (`model_path`) listing each merge (left_id, right_id, new_id)
  *
- * The function reconstructs merged token strings by concatenating their component strings,
- * which are tracked using an in-memory array `toks[]` indexed by token ID.
+ * Token strings come from the byte table of a `Decoder` built from the merges. They are
+ * escaped as in the text count files (`\\`, `\t`, `\n`, `\r`, `\0`), so every token takes
+ * exactly one line; the frequency follows the last space of the line.
  *
  * Frequencies are computed by iterating over the final corpus and summing the
- * token counts across all words, skipping deleted symbols.
+ * token counts across all words; UNK symbols outside the id range are not counted.
  *
  @param trainer A pointer to the trained BPE model
  @param model_path Output path for writing the merge operations (one per line)
@@ -683,57 +1477,222 @@ void bpe_save(const Trainer* trainer, const char* model_path, const char* vocab_
   size_t M = trainer->num_merges;
   size_t T = INITIAL_VOCAB_SIZE + M;
 
-  // building token strings
-  char** toks = (char**)calloc(T, sizeof(char*));
-  for (size_t i = 0; i < INITIAL_VOCAB_SIZE; ++i) {
-    toks[i] = (char*)malloc(2);
-    toks[i][0] = (char)i; 
-    toks[i][1] = '\0';
-  }
-  for (size_t m = 0; m < M; ++m) {
-    PairKey ops = trainer->merge_ops[m];
-    size_t id = INITIAL_VOCAB_SIZE + m;
-    char *A = toks[ops.first], *B = toks[ops.second];
-    size_t aL = strlen(A), bL = strlen(B);
-    toks[id] = (char*)malloc(aL + bL + 1);
-    memcpy(toks[id], A, aL);
-    memcpy(toks[id] + aL, B, bL + 1);
+  // token bytes, built once into the decoder's blob
+  Decoder* dec = decoder_build(trainer->merge_ops, M);
+  if (!dec) {
+    fprintf(stderr, "[ERROR]\t Can't build the token bytes, nothing saved\n");
+    return;
   }
 
   // count actual token frequencies in final corpus
   uint64_t* freq = (uint64_t*)calloc(T, sizeof(uint64_t));
   for (size_t w = 0; w < trainer->corpus.vocab_size; ++w) {
     uint64_t wc = trainer->corpus.word_counts[w];
-    for (Symbol* s = trainer->corpus.words[w]; s; s = s->next) {
-      if (!s->deleted) {
-        freq[s->id] += wc;
+    const int32_t* ids = trainer->corpus.symbols + trainer->corpus.offsets[w];
+    for (uint32_t i = 0; i < trainer->corpus.lengths[w]; ++i) {
+      if (ids[i] >= 0 && (size_t)ids[i] < T) {
+        freq[ids[i]] += wc;
       }
     }
   }
 
   // Write vocabulary with frequencies
   FILE* vf = fopen(vocab_path, "w");
-  for (size_t i = 0; i < T; ++i) {
-    fprintf(vf, "%s %llu\n", toks[i], (unsigned long long)freq[i]);
+  if (!vf) {
+    fprintf(stderr, "[ERROR]\t Cannot open vocab file: %s\n", vocab_path);
+  } else {
+    for (size_t i = 0; i < T; ++i) {
+      counts_put_escaped(vf, dec->bytes + dec->offsets[i], dec->offsets[i + 1] - dec->offsets[i]);
+      fprintf(vf, " %llu\n", (unsigned long long)freq[i]);
+    }
+    fclose(vf);
   }
-  fclose(vf);
 
   // Write merge operations
   FILE* mf = fopen(model_path, "wb");
-  for (size_t m = 0; m < M; ++m) {
-    PairKey op = trainer->merge_ops[m];
-    int32_t a = (int32_t)op.first;
-    int32_t b = (int32_t)op.second;
-    int32_t new_id = (int32_t)(INITIAL_VOCAB_SIZE + m);
-    fwrite(&a, sizeof(int32_t), 1, mf);
-    fwrite(&b, sizeof(int32_t), 1, mf);
-    fwrite(&new_id, sizeof(int32_t), 1, mf);
+  if (!mf) {
+    fprintf(stderr, "[ERROR]\t Cannot open model file: %s\n", model_path);
+  } else {
+    for (size_t m = 0; m < M; ++m) {
+      PairKey op = trainer->merge_ops[m];
+      int32_t a = (int32_t)op.first;
+      int32_t b = (int32_t)op.second;
+      int32_t new_id = (int32_t)(INITIAL_VOCAB_SIZE + m);
+      fwrite(&a, sizeof(int32_t), 1, mf);
+      fwrite(&b, sizeof(int32_t), 1, mf);
+      fwrite(&new_id, sizeof(int32_t), 1, mf);
+    }
+    fclose(mf);
   }
-  fclose(mf);
 
   // cleanup
-  for (size_t i = 0; i < T; ++i) free(toks[i]);
-  free(toks);
+  decoder_destroy(dec);
   free(freq);
   printf("[INFO]\tSaved %zu-token vocab to %s and %zu merges to %s\n", T, vocab_path, M, model_path);
-}
\ No newline at end of file
+}
+
+typedef struct ReplayShard {
+  Trainer* trainer;
+  const BIMap* ranks;   // pair -> merge rank, stored in `Info.freq`
+  size_t begin, end;  // range [begin, end) of `corpus.active`
+  uint64_t merged;  // merges applied in the range, weighted by word counts
+} ReplayShard;
+
+// applies the known merges to every word of the shard, always the lowest-ranked pair first
+static void replay_words_range(ReplayShard* shard) {
+  Corpus* corpus = &shard->trainer->corpus;
+  int32_t unk_id = shard->trainer->config.unk_id;
+  uint64_t merged = 0;
+  for (size_t a = shard->begin; a < shard->end; a++) {
+    size_t wi = corpus->active[a];
+    int32_t* ids = corpus->symbols + corpus->offsets[wi];
+    uint32_t len = corpus->lengths[wi];
+    for (;;) {
+      // lowest-ranked known pair left in the word; pairs of a lower rank can't form later
+      // since every merge only creates ids above those of its own & earlier ranks
+      uint64_t best = UINT64_MAX;
+      PairKey key = {0, 0};
+      for (uint32_t i = 0; i + 1 < len; i++) {
+        if (ids[i] == unk_id || ids[i + 1] == unk_id) continue;
+        PairKey pk = { ids[i], ids[i + 1] };
+        const Info* info = bimap_find(shard->ranks, pk);
+        if (info && info->freq < best) {
+          best = info->freq;
+          key = pk;
+        }
+      }
+      if (best == UINT64_MAX) break;
+
+      int32_t new_id = (int32_t)(INITIAL_VOCAB_SIZE + best);
+      uint32_t out = 0;
+      for (uint32_t i = 0; i < len; ) {
+        if (i + 1 < len && ids[i] == key.first && ids[i + 1] == key.second) {
+          ids[out++] = new_id;
+          merged += corpus->word_counts[wi];
+          i += 2;
+        } else {
+          ids[out++] = ids[i++];
+        }
+      }
+      len = out;
+    }
+    corpus->lengths[wi] = len;
+  }
+  shard->merged = merged;
+}
+
+static void replay_words_task(void* arg, int tid) {
+  replay_words_range(&((ReplayShard*)arg)[tid]);
+}
+
+/**
+ @brief Loads the merges of a model written by `bpe_save` and replays them onto the loaded corpus.
+ *
+ * This lets an existing tokenizer be extended on new data: after this call the corpus is in
+ * exactly the state the saved merges would have left it in, the merges become the first entries
+ * of the merge list, and `bpe_train` rebuilds the pair statistics from it and keeps merging
+ * towards `target_vocab_size`. Instead of popping each merge off the heap, every word is rewritten
+ * once by applying its lowest-ranked known pair until none is left (words are split across the
+ * worker pool). Merges with pairs that contain `unk_id` are kept but never applied, as in training.
+ *
+ @param trainer Pointer to a trainer with a loaded corpus on which no training has run yet.
+ @param model_path Path of the binary merges file (int32 triples `left, right, new_id`).
+ @return Number of merges loaded, or -1 if the file is missing or malformed or the trainer isn't fresh.
+*/
+int bpe_load_merges(Trainer* trainer, const char* model_path) {
+  if (!trainer || !model_path) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or model path pointers\n");
+    return -1;
+  }
+  if (trainer->num_merges > 0 || trainer->bigram_map.size > 0) {
+    fprintf(stderr, "[ERROR]\t Merges can only be loaded before training starts\n");
+    return -1;
+  }
+  if (!trainer->corpus.symbols && trainer->pending && bpe_build_corpus(trainer) != 0) return -1;
+  FILE* fp = fopen(model_path, "rb");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]\t Cannot open model file: %s\n", model_path);
+    return -1;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  size_t triple = 3 * sizeof(int32_t);
+  if (size < 0 || (size_t)size % triple != 0) {
+    fprintf(stderr, "[ERROR]\t Malformed model file: %s\n", model_path);
+    fclose(fp);
+    return -1;
+  }
+  size_t M = (size_t)size / triple;
+  int32_t* raw = (int32_t*)malloc((size_t)size + triple);
+  if (!raw || fread(raw, triple, M, fp) != M) {
+    fprintf(stderr, "[ERROR]\t Cannot read model file: %s\n", model_path);
+    free(raw);
+    fclose(fp);
+    return -1;
+  }
+  fclose(fp);
+
+  // rank table: every merge must build on earlier ids and produce the next one
+  BIMap ranks;
+  bimap_init(&ranks, M);
+  for (size_t m = 0; m < M; m++) {
+    int32_t a = raw[3 * m], b = raw[3 * m + 1], id = raw[3 * m + 2];
+    int32_t expected = (int32_t)(INITIAL_VOCAB_SIZE + m);
+    if (id != expected || a < 0 || b < 0 || a >= expected || b >= expected) {
+      fprintf(stderr, "[ERROR]\t Malformed merge %zu in model file: %s\n", m, model_path);
+      bimap_free(&ranks);
+      free(raw);
+      return -1;
+    }
+    PairKey key = { a, b };
+    Info* info = bimap_get(&ranks, key);
+    if (info->version++ == 0) info->freq = m;  // a repeated pair keeps its first (effective) rank
+  }
+
+  // the loaded merges open the merge list
+  if (trainer->config.target_vocab_size < M) {
+    PairKey* ops = (PairKey*)realloc(trainer->merge_ops, M * sizeof(PairKey));
+    if (!ops) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of merge list\n");
+      exit(EXIT_FAILURE);
+    }
+    trainer->merge_ops = ops;
+  }
+  for (size_t m = 0; m < M; m++) {
+    trainer->merge_ops[m].first = raw[3 * m];
+    trainer->merge_ops[m].second = raw[3 * m + 1];
+  }
+  trainer->num_merges = M;
+  free(raw);
+
+  // replaying on up to one shard per pool thread
+  refresh_active_words(trainer);
+  ThreadPool* pool = trainer_pool(trainer);
+  size_t v = trainer->corpus.num_active;
+  size_t nshards = (size_t)threadpool_size(pool);
+  if (nshards > v / MIN_SHARD_WORDS) nshards = v / MIN_SHARD_WORDS;
+  if (nshards < 1) nshards = 1;
+  ReplayShard* shards = (ReplayShard*)malloc(nshards * sizeof(ReplayShard));
+  if (!shards) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of replay shards\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t t = 0; t < nshards; t++) {
+    shards[t].trainer = trainer;
+    shards[t].ranks = &ranks;
+    shards[t].begin = v * t / nshards;
+    shards[t].end = v * (t + 1) / nshards;
+    shards[t].merged = 0;
+  }
+  threadpool_run(pool, (int)nshards, replay_words_task, shards);
+  uint64_t merged = 0;
+  for (size_t t = 0; t < nshards; t++) merged += shards[t].merged;
+  free(shards);
+  bimap_free(&ranks);
+
+  refresh_active_words(trainer);
+  printf("[INFO]\t Replayed %zu merges from %s (%llu occurrences), %zu words still active\n",
+         M, model_path, (unsigned long long)merged, trainer->corpus.num_active);
+  return (int)M;
+}
@@ -4,9 +4,10 @@
       with help of hashing & heaps for faster merges.
   * main entry point file code for BPE-trainer related codebase.
   * compile it as:
-    *- '.so': g++ -shared -fPIC -o libbpe.so bpe/bpe.cpp bpe/histogram.cpp bpe/hash.cpp bpe/heap.cpp
-    *- '.dll': g++ -shared -o libbpe.dll bpe/bpe.cpp bpe/histogram.cpp bpe/hash.cpp bpe/heap.cpp
-    *- '.dylib': g++ -dynamiclib -o libbpe.dylib bpe/bpe.cpp bpe/histogram.cpp bpe/hash.cpp bpe/heap.cpp
+    *- '.so': g++ -shared -fPIC -o libbpe.so bpe/bpe.cpp bpe/histogram.cpp bpe/hash.cpp bpe/heap.cpp bpe/arena.cpp bpe/checkpoint.cpp bpe/reader.cpp bpe/counts.cpp bpe/pretok.cpp bpe/scan.cpp bpe/encoder.cpp bpe/shards.cpp bpe/decoder.cpp threads.cpp
+    *- '.dll': g++ -shared -o libbpe.dll bpe/bpe.cpp bpe/histogram.cpp bpe/hash.cpp bpe/heap.cpp bpe/arena.cpp bpe/checkpoint.cpp bpe/reader.cpp bpe/counts.cpp bpe/pretok.cpp bpe/scan.cpp bpe/encoder.cpp bpe/shards.cpp bpe/decoder.cpp threads.cpp
+    *- '.dylib': g++ -dynamiclib -o libbpe.dylib bpe/bpe.cpp bpe/histogram.cpp bpe/hash.cpp bpe/heap.cpp bpe/arena.cpp bpe/checkpoint.cpp bpe/reader.cpp bpe/counts.cpp bpe/pretok.cpp bpe/scan.cpp bpe/encoder.cpp bpe/shards.cpp bpe/decoder.cpp threads.cpp
+    *- gzip/zstd corpora: add '-DSHRED_HAVE_ZLIB -lz' and/or '-DSHRED_HAVE_ZSTD -lzstd'
 */
 
 #ifndef __BPE__H__
@@ -15,29 +16,27 @@
 #include <stdint.h>
 #include "heap.h"
 #include "hash.h"
+#include "../threads.h"
 
 #define  MIN_HEAP_SIZE  4096
 #define  INITIAL_VOCAB_SIZE  256  // UTF-8 base chars from 0 -> 255
 #define  INITIAL_STR_BUFFER  4096  // no of characters to be loaded
 #define  MAX_OCCS_PER_MERGE  50000
 #define  MIN_PAIR_FREQ  2000
-
-typedef struct Symbol {
-  int32_t id;  // current token's int value
-  struct Symbol* prev;  // previous token
-  struct Symbol* next;  // next token
-  bool deleted; // check deleted or not?
-} Symbol;
-
-typedef struct WordPos {
-  size_t word_index;  // index to word list
-  Symbol* pos;  // pointer to first bigram symbol
-} WordPos;
+#define  MIN_SHARD_BYTES  (1 << 20)  // smallest corpus byte range worth its own thread
+#define  MIN_SHARD_WORDS  (1 << 14)  // smallest word range worth its own thread
+#define  MAX_MERGE_GROUP  64   // most symbol-disjoint merges applied in one corpus pass
+#define  ACTIVE_REFRESH_MERGES  1024   // merges between two compactions of the active word list
 
 typedef struct Corpus {
-  Symbol** words; // index to a word list
+  int32_t* symbols;   // token ids of every word, stored back to back
+  size_t* offsets;   // start of each word in `symbols`
+  uint32_t* lengths;   // current no of tokens in each word (shrinks as merges compact it)
   uint64_t* word_counts;  // corresponding freq
   size_t vocab_size;  // no of unique word in train corpus
+  size_t num_symbols;   // capacity of `symbols` (the initial character count)
+  size_t* active;   // ascending indices of the words that still hold a countable pair
+  size_t num_active;
 } Corpus;
 
 typedef struct BPEConfig {
@@ -45,6 +44,8 @@ typedef struct BPEConfig {
   int32_t unk_id;   // for unknown tokens
   float character_coverage;   // 0.995 -> 99.5%
   uint64_t min_pair_freq;   // eg: 400
+  int32_t num_threads;   // worker threads, <= 0 -> all available cores
+  int32_t pre_tokenizer;  // how the corpus is split into words, see `PreTokenizer` in pretok.h (0 -> whitespace)
 } BPEConfig;
 
 typedef struct Trainer {
@@ -57,18 +58,36 @@ typedef struct Trainer {
   PairKey* merge_ops;
   char** token_strs;
   uint64_t* token_freq;
+  ThreadPool* pool;   // workers for bigram counting & merges, created on first use
+  Arena* scratch;   // per-thread arenas for short-lived nodes, reset between phases & merge groups
+  size_t nscratch;
+  char* ckpt_path;  // checkpoint file written by `bpe_train`, NULL if off
+  int32_t ckpt_every;   // merges between checkpoints, 0 for signals only
+  WordTable* pending;   // per-thread word counts (fed text, counted files, count files) until the corpus is built
+  size_t npending;
 } Trainer;
 
 extern "C" {
   Trainer* create_trainer(const BPEConfig* config);
   void bpe_trainer_destroy(Trainer* trainer);
   int bpe_load_corpus(Trainer* trainer, const char* input_path);
+  int bpe_load_corpus_files(Trainer* trainer, const char* const* paths, size_t npaths);  // files, directories or globs
+  int bpe_feed(Trainer* trainer, const char* const* texts, const size_t* lengths, size_t n);  // counts in-memory text
+  int bpe_count_files(Trainer* trainer, const char* const* paths, size_t npaths);  // counts without building the corpus
+  int bpe_build_corpus(Trainer* trainer);  // turns the pending word counts into the corpus
+  int bpe_save_counts(Trainer* trainer, const char* path, int as_text);
+  int bpe_load_counts(Trainer* trainer, const char* const* paths, size_t npaths);
 
   void bpe_init(Trainer* trainer);
   void bpe_count_bigrams(Trainer* trainer);
   int bpe_merge_batch(Trainer* trainer, int batch_size);
   int bpe_train(Trainer* trainer);
   void bpe_save(const Trainer* trainer, const char* model_path, const char* vocab_path);
+  int bpe_load_merges(Trainer* trainer, const char* model_path);  // replays a saved model onto the loaded corpus
+
+  int bpe_checkpoint(const Trainer* trainer, const char* path);
+  int bpe_resume(Trainer* trainer, const char* path);
+  void bpe_set_checkpoint(Trainer* trainer, const char* path, int every);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,445 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "hash.h"
+#include "heap.h"
+#include "bpe.h"
+#include "checkpoint.h"
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+// pads the file with zeros up to the next CKPT_ALIGN boundary
+static int write_pad(FILE* fp, uint64_t* pos) {
+  static const char zeros[CKPT_ALIGN] = {0};
+  size_t pad = (size_t)((CKPT_ALIGN - (*pos % CKPT_ALIGN)) % CKPT_ALIGN);
+  if (pad && fwrite(zeros, 1, pad, fp) != pad) return -1;
+  *pos += pad;
+  return 0;
+}
+
+// writes one aligned section & records where it starts
+static int write_section(FILE* fp, uint64_t* pos, CkptHeader* h, CkptSection s, const void* data, size_t bytes) {
+  if (write_pad(fp, pos) != 0) return -1;
+  h->sections[s] = *pos;
+  if (bytes && fwrite(data, 1, bytes, fp) != bytes) return -1;
+  *pos += bytes;
+  return 0;
+}
+
+// writes a size_t array as uint64 values, converting through a small buffer if needed
+static int write_section_u64(FILE* fp, uint64_t* pos, CkptHeader* h, CkptSection s, const size_t* data, size_t n) {
+  if (sizeof(size_t) == sizeof(uint64_t)) return write_section(fp, pos, h, s, data, n * sizeof(uint64_t));
+  if (write_pad(fp, pos) != 0) return -1;
+  h->sections[s] = *pos;
+  uint64_t buf[1024];
+  for (size_t i = 0; i < n; ) {
+    size_t k = (n - i < 1024) ? n - i : 1024;
+    for (size_t j = 0; j < k; j++) buf[j] = (uint64_t)data[i + j];
+    if (fwrite(buf, sizeof(uint64_t), k, fp) != k) return -1;
+    i += k;
+  }
+  *pos += n * sizeof(uint64_t);
+  return 0;
+}
+
+/**
+ @brief Writes a snapshot of the trainer to `path`, see checkpoint.h for the layout.
+ *
+ * The snapshot is written to `<path>.tmp` first and renamed over `path` once complete,
+ * so an interrupted write never clobbers the previous checkpoint.
+ *
+ @param trainer Pointer to a trainer with a loaded corpus (training may be in progress).
+ @param path Destination file path.
+ @return 0 on success, -1 on failure.
+*/
+int bpe_checkpoint(const Trainer* trainer, const char* path) {
+  if (!trainer || !path) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or checkpoint path pointers\n");
+    return -1;
+  }
+  const Corpus* corpus = &trainer->corpus;
+  const BIMap* map = &trainer->bigram_map;
+  size_t num_merges = trainer->num_merges;
+  if (num_merges > trainer->config.target_vocab_size) num_merges = trainer->config.target_vocab_size;
+
+  size_t plen = strlen(path);
+  char* tmp_path = (char*)malloc(plen + 5);
+  if (!tmp_path) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of checkpoint path\n");
+    return -1;
+  }
+  memcpy(tmp_path, path, plen);
+  memcpy(tmp_path + plen, ".tmp", 5);
+  FILE* fp = fopen(tmp_path, "wb");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]\t Cannot open checkpoint file: %s\n", tmp_path);
+    free(tmp_path);
+    return -1;
+  }
+
+  CkptHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CKPT_MAGIC, sizeof(h.magic));
+  h.version = CKPT_VERSION;
+  h.header_size = (uint32_t)sizeof(CkptHeader);
+  h.target_vocab_size = trainer->config.target_vocab_size;
+  h.min_pair_freq = trainer->config.min_pair_freq;
+  h.unk_id = trainer->config.unk_id;
+  h.character_coverage = trainer->config.character_coverage;
+  h.num_merges = num_merges;
+  h.vocab_size = corpus->vocab_size;
+  h.num_symbols = corpus->num_symbols;
+  h.num_active = corpus->num_active;
+  h.num_pairs = map->size;
+
+  // pair counts & versions are split out of `Info`, whose word lists aren't stored
+  uint64_t* freqs = (uint64_t*)malloc((map->size + 1) * sizeof(uint64_t));
+  uint32_t* versions = (uint32_t*)malloc((map->size + 1) * sizeof(uint32_t));
+  if (!freqs || !versions) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of checkpoint pair table\n");
+    free(freqs); free(versions); free(tmp_path);
+    fclose(fp);
+    return -1;
+  }
+  for (size_t i = 0; i < map->size; i++) {
+    freqs[i] = map->infos[i].freq;
+    versions[i] = map->infos[i].version;
+  }
+
+  uint64_t pos = sizeof(CkptHeader);
+  int rc = fwrite(&h, sizeof(h), 1, fp) == 1 ? 0 : -1;
+  if (rc == 0) rc = write_section(fp, &pos, &h, CKPT_SYMBOLS, corpus->symbols, corpus->num_symbols * sizeof(int32_t));
+  if (rc == 0) rc = write_section_u64(fp, &pos, &h, CKPT_OFFSETS, corpus->offsets, corpus->vocab_size);
+  if (rc == 0) rc = write_section(fp, &pos, &h, CKPT_LENGTHS, corpus->lengths, corpus->vocab_size * sizeof(uint32_t));
+  if (rc == 0) rc = write_section(fp, &pos, &h, CKPT_COUNTS, corpus->word_counts, corpus->vocab_size * sizeof(uint64_t));
+  if (rc == 0) rc = write_section_u64(fp, &pos, &h, CKPT_ACTIVE, corpus->active, corpus->num_active);
+  if (rc == 0) rc = write_section(fp, &pos, &h, CKPT_MERGES, trainer->merge_ops, num_merges * sizeof(PairKey));
+  if (rc == 0) rc = write_section(fp, &pos, &h, CKPT_PAIR_KEYS, map->keys, map->size * sizeof(PairKey));
+  if (rc == 0) rc = write_section(fp, &pos, &h, CKPT_PAIR_FREQS, freqs, map->size * sizeof(uint64_t));
+  if (rc == 0) rc = write_section(fp, &pos, &h, CKPT_PAIR_VERSIONS, versions, map->size * sizeof(uint32_t));
+  h.file_size = pos;
+
+  // header goes last, now that every section offset is known
+  if (rc == 0) rc = (fseek(fp, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, fp) == 1) ? 0 : -1;
+  if (rc == 0) rc = fflush(fp) == 0 ? 0 : -1;
+#ifndef _WIN32
+  if (rc == 0) fsync(fileno(fp));
+#endif
+  if (fclose(fp) != 0) rc = -1;
+  free(freqs);
+  free(versions);
+
+  if (rc == 0) {
+#ifdef _WIN32
+    remove(path);  // rename doesn't replace an existing file on Windows
+#endif
+    rc = rename(tmp_path, path) == 0 ? 0 : -1;
+  }
+  if (rc != 0) {
+    fprintf(stderr, "[ERROR]\t Failed writing checkpoint: %s\n", path);
+    remove(tmp_path);
+  } else {
+    printf("[INFO]\t Checkpoint written to %s (%zu merges, %llu bytes)\n", path, num_merges, (unsigned long long)h.file_size);
+  }
+  free(tmp_path);
+  return rc;
+}
+
+// returns the start of section `s` if `bytes` of it fit inside the file, NULL otherwise
+static const char* section_ptr(const char* base, size_t size, const CkptHeader* h, CkptSection s, uint64_t bytes) {
+  uint64_t off = h->sections[s];
+  if (off % CKPT_ALIGN != 0 || off > size || bytes > size - off) return NULL;
+  return base + off;
+}
+
+// copies `n` uint64 values into a freshly allocated size_t array
+static size_t* copy_u64(const char* src, size_t n) {
+  size_t* dst = (size_t*)malloc((n + 1) * sizeof(size_t));
+  if (!dst) return NULL;
+  if (sizeof(size_t) == sizeof(uint64_t)) {
+    memcpy(dst, src, n * sizeof(uint64_t));
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      uint64_t v;
+      memcpy(&v, src + i * sizeof(uint64_t), sizeof(v));
+      dst[i] = (size_t)v;
+    }
+  }
+  return dst;
+}
+
+// copies `bytes` from the mapped file into a new buffer (at least one byte, so NULL means failure)
+static void* copy_bytes(const char* src, size_t bytes) {
+  void* dst = malloc(bytes ? bytes : 1);
+  if (dst && bytes) memcpy(dst, src, bytes);
+  return dst;
+}
+
+/**
+ @brief Restores a trainer from a checkpoint written by `bpe_checkpoint`.
+ *
+ * The file is memory-mapped (read into memory on Windows) and its sections are copied
+ * into the trainer, replacing any corpus, pair table & merges it held. `unk_id`,
+ * `character_coverage` and `min_pair_freq` are taken from the checkpoint, while
+ * `target_vocab_size` and `num_threads` keep the trainer's own values, so a run can
+ * be resumed towards a larger vocabulary. Occurrence lists and the heap are rebuilt
+ * from the restored pair table; `bpe_train` then carries on from the stored merge count.
+ *
+ @param trainer Pointer to a trainer created with `create_trainer`.
+ @param path Checkpoint file path.
+ @return 0 on success, -1 if the file can't be read or fails validation (the trainer is left untouched).
+*/
+int bpe_resume(Trainer* trainer, const char* path) {
+  if (!trainer || !path) {
+    fprintf(stderr, "[ERROR]\t NULL trainer or checkpoint path pointers\n");
+    return -1;
+  }
+
+  // mapping the whole file
+  const char* base = NULL;
+  size_t size = 0;
+#ifndef _WIN32
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "[ERROR]\t Cannot open checkpoint file: %s\n", path);
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  size = (size_t)st.st_size;
+  void* mapped = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    fprintf(stderr, "[ERROR]\t Cannot map checkpoint file: %s\n", path);
+    return -1;
+  }
+  base = (const char*)mapped;
+#else
+  FILE* fp = fopen(path, "rb");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]\t Cannot open checkpoint file: %s\n", path);
+    return -1;
+  }
+  fseek(fp, 0, SEEK_END);
+  long fsize = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  char* buffer = fsize > 0 ? (char*)malloc((size_t)fsize) : NULL;
+  if (!buffer || fread(buffer, 1, (size_t)fsize, fp) != (size_t)fsize) {
+    fprintf(stderr, "[ERROR]\t Cannot read checkpoint file: %s\n", path);
+    free(buffer);
+    fclose(fp);
+    return -1;
+  }
+  fclose(fp);
+  size = (size_t)fsize;
+  base = buffer;
+#endif
+
+  int rc = -1;
+  CkptHeader h;
+  const char *sym, *off, *len, *cnt, *act, *mrg, *pkeys, *pfreqs, *pvers;
+  Corpus c;
+  memset(&c, 0, sizeof(c));
+  PairKey* merges = NULL;
+
+  // validating header & section bounds before touching the trainer
+  if (size < sizeof(CkptHeader)) goto invalid;
+  memcpy(&h, base, sizeof(h));
+  if (memcmp(h.magic, CKPT_MAGIC, sizeof(h.magic)) != 0 || h.version != CKPT_VERSION || h.header_size != sizeof(CkptHeader) || h.file_size != size) goto invalid;
+  if (h.num_pairs >= BIMAP_EMPTY || h.num_active > h.vocab_size) goto invalid;
+  sym = section_ptr(base, size, &h, CKPT_SYMBOLS, h.num_symbols * sizeof(int32_t));
+  off = section_ptr(base, size, &h, CKPT_OFFSETS, h.vocab_size * sizeof(uint64_t));
+  len = section_ptr(base, size, &h, CKPT_LENGTHS, h.vocab_size * sizeof(uint32_t));
+  cnt = section_ptr(base, size, &h, CKPT_COUNTS, h.vocab_size * sizeof(uint64_t));
+  act = section_ptr(base, size, &h, CKPT_ACTIVE, h.num_active * sizeof(uint64_t));
+  mrg = section_ptr(base, size, &h, CKPT_MERGES, h.num_merges * sizeof(PairKey));
+  pkeys = section_ptr(base, size, &h, CKPT_PAIR_KEYS, h.num_pairs * sizeof(PairKey));
+  pfreqs = section_ptr(base, size, &h, CKPT_PAIR_FREQS, h.num_pairs * sizeof(uint64_t));
+  pvers = section_ptr(base, size, &h, CKPT_PAIR_VERSIONS, h.num_pairs * sizeof(uint32_t));
+  if (!sym || !off || !len || !cnt || !act || !mrg || !pkeys || !pfreqs || !pvers) goto invalid;
+
+  // copying the corpus out of the mapping, every word run has to stay inside `symbols`
+  c.vocab_size = (size_t)h.vocab_size;
+  c.num_symbols = (size_t)h.num_symbols;
+  c.num_active = (size_t)h.num_active;
+  c.symbols = (int32_t*)copy_bytes(sym, c.num_symbols * sizeof(int32_t));
+  c.offsets = copy_u64(off, c.vocab_size);
+  c.lengths = (uint32_t*)copy_bytes(len, c.vocab_size * sizeof(uint32_t));
+  c.word_counts = (uint64_t*)copy_bytes(cnt, c.vocab_size * sizeof(uint64_t));
+  c.active = copy_u64(act, c.num_active);
+  merges = (PairKey*)malloc(((size_t)h.num_merges + trainer->config.target_vocab_size + 1) * sizeof(PairKey));
+  if (!c.symbols || !c.offsets || !c.lengths || !c.word_counts || !c.active || !merges) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of resumed corpus\n");
+    goto fail;
+  }
+  for (size_t wi = 0; wi < c.vocab_size; wi++) {
+    if (c.offsets[wi] > c.num_symbols || c.lengths[wi] > c.num_symbols - c.offsets[wi]) goto invalid;
+  }
+  for (size_t a = 0; a < c.num_active; a++) {
+    if (c.active[a] >= c.vocab_size) goto invalid;
+  }
+  if (h.num_merges) memcpy(merges, mrg, (size_t)h.num_merges * sizeof(PairKey));
+
+  {
+    // swapping the restored state in
+    free(trainer->corpus.symbols);
+    free(trainer->corpus.offsets);
+    free(trainer->corpus.lengths);
+    free(trainer->corpus.word_counts);
+    free(trainer->corpus.active);
+    free(trainer->merge_ops);
+    trainer->corpus = c;
+    trainer->merge_ops = merges;
+    trainer->num_merges = (size_t)h.num_merges;
+    trainer->config.unk_id = h.unk_id;
+    trainer->config.character_coverage = h.character_coverage;
+    trainer->config.min_pair_freq = h.min_pair_freq;
+
+    // pair table in its stored slot order, so every pair keeps its BIMap index & heap slot
+    BIMap* map = &trainer->bigram_map;
+    uint64_t min_freq = trainer->config.min_pair_freq;
+    int32_t unk_id = trainer->config.unk_id;
+    bimap_free(map);
+    bimap_init(map, (size_t)h.num_pairs);
+    for (size_t i = 0; i < (size_t)h.num_pairs; i++) {
+      PairKey key;
+      memcpy(&key, pkeys + i * sizeof(PairKey), sizeof(key));
+      Info* info = bimap_get(map, key);
+      memcpy(&info->freq, pfreqs + i * sizeof(uint64_t), sizeof(uint64_t));
+      memcpy(&info->version, pvers + i * sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    // occurrence lists of the pairs that can still be merged, from one pass over the active words
+    const Corpus* corpus = &trainer->corpus;
+    for (size_t a = 0; a < corpus->num_active; a++) {
+      size_t wi = corpus->active[a];
+      const int32_t* ids = corpus->symbols + corpus->offsets[wi];
+      for (uint32_t i = 0; i + 1 < corpus->lengths[wi]; i++) {
+        if (ids[i] == unk_id || ids[i + 1] == unk_id) continue;
+        PairKey key = { ids[i], ids[i + 1] };
+        Info* info = bimap_find(map, key);
+        if (info && info->freq >= min_freq) wordlist_push(&info->words, wi);
+      }
+    }
+
+    // heap of the mergeable pairs
+    HeapEntry* entries = (HeapEntry*)malloc((map->size + 1) * sizeof(HeapEntry));
+    if (!entries) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of heap entries\n");
+      exit(EXIT_FAILURE);
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < map->size; i++) {
+      if (map->infos[i].freq < min_freq) continue;
+      entries[n].key = map->keys[i];
+      entries[n].freq = map->infos[i].freq;
+      entries[n].version = 0;
+      entries[n].slot = (uint32_t)i;
+      n++;
+    }
+    heap_build(&trainer->heap, entries, n);
+    free(entries);
+    printf("[INFO]\t Resumed from %s: %zu merges, %zu words (%zu active), %zu pairs (%zu queued)\n",
+           path, trainer->num_merges, corpus->vocab_size, corpus->num_active, map->size, n);
+  }
+  rc = 0;
+  goto done;
+
+invalid:
+  fprintf(stderr, "[ERROR]\t Invalid or incompatible checkpoint file: %s\n", path);
+fail:
+  free(c.symbols);
+  free(c.offsets);
+  free(c.lengths);
+  free(c.word_counts);
+  free(c.active);
+  free(merges);
+done:
+#ifndef _WIN32
+  munmap((void*)base, size);
+#else
+  free((void*)base);
+#endif
+  return rc;
+}
+
+/**
+ @brief Makes `bpe_train` write a checkpoint to `path` every `every` merges.
+ * On POSIX systems a running `bpe_train` also writes one when it receives SIGUSR1, and
+ * on SIGTERM, after which the signal is re-raised with the previous handler restored.
+ * Snapshots are only taken between merge batches.
+ @param trainer Pointer to the trainer.
+ @param path Checkpoint file path (copied), NULL to turn checkpointing off.
+ @param every Merge interval, 0 to only checkpoint on signals.
+*/
+void bpe_set_checkpoint(Trainer* trainer, const char* path, int every) {
+  if (!trainer) {
+    fprintf(stderr, "[ERROR]\t Trainer pointer is NULL!\n");
+    return;
+  }
+  free(trainer->ckpt_path);
+  trainer->ckpt_path = NULL;
+  trainer->ckpt_every = every > 0 ? every : 0;
+  if (!path) return;
+  size_t len = strlen(path);
+  trainer->ckpt_path = (char*)malloc(len + 1);
+  if (!trainer->ckpt_path) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of checkpoint path\n");
+    return;
+  }
+  memcpy(trainer->ckpt_path, path, len + 1);
+}
+
+#ifndef _WIN32
+static volatile sig_atomic_t ckpt_signal = 0;   // last checkpoint signal received, 0 if none
+static struct sigaction prev_usr1, prev_term;
+
+static void on_ckpt_signal(int sig) {
+  ckpt_signal = sig;
+}
+#endif
+
+void checkpoint_watch(Trainer* trainer, bool on) {
+  if (!trainer->ckpt_path) return;
+#ifndef _WIN32
+  if (on) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_ckpt_signal;
+    sigemptyset(&sa.sa_mask);
+    ckpt_signal = 0;
+    sigaction(SIGUSR1, &sa, &prev_usr1);
+    sigaction(SIGTERM, &sa, &prev_term);
+  } else {
+    sigaction(SIGUSR1, &prev_usr1, NULL);
+    sigaction(SIGTERM, &prev_term, NULL);
+  }
+#endif
+}
+
+void checkpoint_poll(Trainer* trainer, size_t prev_merges) {
+  if (!trainer->ckpt_path) return;
+  size_t every = (size_t)trainer->ckpt_every;
+  bool due = every > 0 && trainer->num_merges / every != prev_merges / every;
+  int sig = 0;
+#ifndef _WIN32
+  sig = ckpt_signal;
+  ckpt_signal = 0;
+#endif
+  if (!due && !sig) return;
+  bpe_checkpoint(trainer, trainer->ckpt_path);
+#ifndef _WIN32
+  if (sig == SIGTERM) {
+    printf("[INFO]\t SIGTERM received, stopping after checkpoint\n");
+    fflush(stdout);
+    checkpoint_watch(trainer, false);
+    raise(SIGTERM);
+  }
+#endif
+}
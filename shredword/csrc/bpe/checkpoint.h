@@ -0,0 +1,59 @@
+/**
+  @file checkpoint.h
+  @brief On-disk snapshots of a training run.
+
+  * A checkpoint holds everything `bpe_train` needs to carry on exactly where it
+    stopped: the config, the corpus' current symbol runs, word counts & active list,
+    the merge list and the pair table (keys, counts, versions in slot order).
+  * Layout: a fixed `CkptHeader` followed by sections, each starting on a CKPT_ALIGN
+    boundary at the offset recorded in the header, so the file can be mapped & sliced
+    directly. Integers are stored in host byte order, `size_t` arrays as uint64.
+  * Occurrence lists and the heap aren't stored; resuming rebuilds them from the
+    restored pair table with one pass over the active words.
+*/
+
+#ifndef __CHECKPOINT__H__
+#define __CHECKPOINT__H__
+
+#include <stdint.h>
+#include "bpe.h"
+
+#define  CKPT_MAGIC  "SHRDCKPT"
+#define  CKPT_VERSION  1
+#define  CKPT_ALIGN  64   // alignment of every section in the file
+
+typedef enum CkptSection {
+  CKPT_SYMBOLS,   // int32  x num_symbols
+  CKPT_OFFSETS,   // uint64 x vocab_size
+  CKPT_LENGTHS,   // uint32 x vocab_size
+  CKPT_COUNTS,    // uint64 x vocab_size
+  CKPT_ACTIVE,    // uint64 x num_active
+  CKPT_MERGES,    // PairKey x num_merges
+  CKPT_PAIR_KEYS,   // PairKey x num_pairs
+  CKPT_PAIR_FREQS,  // uint64 x num_pairs
+  CKPT_PAIR_VERSIONS,   // uint32 x num_pairs
+  CKPT_NUM_SECTIONS
+} CkptSection;
+
+typedef struct CkptHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;   // sizeof(CkptHeader) of the writer
+  uint64_t target_vocab_size;
+  uint64_t min_pair_freq;
+  int32_t unk_id;
+  float character_coverage;
+  uint64_t num_merges;
+  uint64_t vocab_size;
+  uint64_t num_symbols;
+  uint64_t num_active;
+  uint64_t num_pairs;
+  uint64_t sections[CKPT_NUM_SECTIONS];   // byte offset of each section
+  uint64_t file_size;
+} CkptHeader;
+
+// hooks used by `bpe_train` while a checkpoint path is set
+void checkpoint_watch(Trainer* trainer, bool on);  // (un)installs the SIGUSR1/SIGTERM handlers
+void checkpoint_poll(Trainer* trainer, size_t prev_merges);  // writes a snapshot if one is due
+
+#endif  //!__CHECKPOINT__H__
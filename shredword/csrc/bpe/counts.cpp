@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hash.h"
+#include "counts.h"
+
+#define  VARINT_MAX_BYTES  10   // a uint64 takes at most 10 LEB128 bytes
+
+// LEB128: 7 bits per byte, low groups first, high bit set on all but the last byte
+static size_t varint_put(unsigned char* out, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (unsigned char)v;
+  return n;
+}
+
+// decodes one varint from [*p, end), false if it runs past the end or overflows 64 bits
+static bool varint_get(const unsigned char** p, const unsigned char* end, uint64_t* v) {
+  uint64_t x = 0;
+  for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+    unsigned char b = *(*p)++;
+    x |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      *v = x;
+      return true;
+    }
+  }
+  return false;
+}
+
+// writes a word for the text layout, escaping `\\`, tab, newline, carriage return & NUL
+bool counts_put_escaped(FILE* fp, const char* word, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    char c = word[i];
+    const char* esc = c == '\\' ? "\\\\" : c == '\t' ? "\\t" : c == '\n' ? "\\n" : c == '\r' ? "\\r" : c == '\0' ? "\\0" : NULL;
+    if (esc ? fputs(esc, fp) < 0 : putc(c, fp) == EOF) return false;
+  }
+  return true;
+}
+
+// undoes `counts_put_escaped` in place, returns the unescaped length or -1 on a bad escape
+static long unescape(char* word, size_t len) {
+  size_t out = 0;
+  for (size_t i = 0; i < len; i++) {
+    char c = word[i];
+    if (c == '\\') {
+      if (++i == len) return -1;
+      switch (word[i]) {
+        case '\\': c = '\\'; break;
+        case 't': c = '\t'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case '0': c = '\0'; break;
+        default: return -1;
+      }
+    }
+    word[out++] = c;
+  }
+  return (long)out;
+}
+
+/**
+ @brief Writes a word table as a count file.
+ *
+ * The file is written next to `path` first and renamed into place, so a failed or interrupted
+ * write never leaves a half-written count file behind under the final name.
+ *
+ @param table Words & counts to store, written in table order.
+ @param path Output path.
+ @param as_text Writes `word<TAB>count` lines instead of the binary layout.
+ @return 0 on success, -1 on failure.
+*/
+int counts_write(const WordTable* table, const char* path, bool as_text) {
+  size_t plen = strlen(path);
+  char* tmp = (char*)malloc(plen + 5);
+  if (!tmp) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of count file path\n");
+    return -1;
+  }
+  memcpy(tmp, path, plen);
+  memcpy(tmp + plen, ".tmp", 5);
+  FILE* fp = fopen(tmp, as_text ? "w" : "wb");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]\t Couldn't open file for writing: %s\n", tmp);
+    free(tmp);
+    return -1;
+  }
+
+  bool ok = true;
+  if (as_text) {
+    for (size_t i = 0; i < table->size && ok; i++) {
+      const WordEntry* e = &table->entries[i];
+      ok = counts_put_escaped(fp, wordtable_key(table, i), e->len) && fprintf(fp, "\t%llu\n", (unsigned long long)e->count) > 0;
+    }
+  } else {
+    CountsHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, COUNTS_MAGIC, sizeof(h.magic));
+    h.version = COUNTS_VERSION;
+    h.num_words = table->size;
+    for (size_t i = 0; i < table->size; i++) h.num_bytes += table->entries[i].len;
+    ok = fwrite(&h, sizeof(h), 1, fp) == 1;
+    for (size_t i = 0; i < table->size && ok; i++) {
+      const WordEntry* e = &table->entries[i];
+      unsigned char head[2 * VARINT_MAX_BYTES];
+      size_t n = varint_put(head, e->count);
+      n += varint_put(head + n, e->len);
+      ok = fwrite(head, 1, n, fp) == n && fwrite(wordtable_key(table, i), 1, e->len, fp) == e->len;
+    }
+  }
+  if (fclose(fp) != 0) ok = false;
+  if (!ok || rename(tmp, path) != 0) {
+    fprintf(stderr, "[ERROR]\t Couldn't write count file: %s\n", path);
+    remove(tmp);
+    free(tmp);
+    return -1;
+  }
+  free(tmp);
+  return 0;
+}
+
+// binary records after the header, read in one go & checked against the header's word & byte totals
+static int read_binary(WordTable* table, FILE* fp, const CountsHeader* h, const char* path) {
+  if (h->version != COUNTS_VERSION) {
+    fprintf(stderr, "[ERROR]\t Unsupported count file version %u: %s\n", h->version, path);
+    return -1;
+  }
+  long pos = ftell(fp);
+  if (pos < 0 || fseek(fp, 0, SEEK_END) != 0) {
+    fprintf(stderr, "[ERROR]\t Couldn't read count file: %s\n", path);
+    return -1;
+  }
+  long file_end = ftell(fp);
+  fseek(fp, pos, SEEK_SET);
+  size_t size = file_end > pos ? (size_t)(file_end - pos) : 0;
+  unsigned char* data = (unsigned char*)malloc(size ? size : 1);
+  if (!data) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of count file buffer\n");
+    exit(EXIT_FAILURE);
+  }
+  if (fread(data, 1, size, fp) != size) {
+    fprintf(stderr, "[ERROR]\t Couldn't read count file: %s\n", path);
+    free(data);
+    return -1;
+  }
+
+  const unsigned char* p = data;
+  const unsigned char* end = data + size;
+  uint64_t num_bytes = 0;
+  bool ok = true;
+  for (uint64_t w = 0; w < h->num_words && ok; w++) {
+    uint64_t count, len;
+    ok = varint_get(&p, end, &count) && varint_get(&p, end, &len) && len > 0 && len <= (uint64_t)(end - p);
+    if (!ok) break;
+    if (count) wordtable_add(table, (const char*)p, (size_t)len, count);
+    p += len;
+    num_bytes += len;
+  }
+  free(data);
+  if (!ok || p != end || num_bytes != h->num_bytes) {
+    fprintf(stderr, "[ERROR]\t Truncated or malformed count file: %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+// `word<TAB>count` lines with escaped words, blank lines are skipped
+static int read_text(WordTable* table, FILE* fp, const char* path) {
+  size_t line_cap = COUNTS_LINE_BUFFER;
+  char* line = (char*)malloc(line_cap);
+  if (!line) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of count file buffer\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t lineno = 0;
+  while (fgets(line, (int)line_cap, fp)) {
+    size_t len = strlen(line);
+    while (len == line_cap - 1 && line[len - 1] != '\n') {
+      line_cap *= 2;
+      char* grown = (char*)realloc(line, line_cap);
+      if (!grown) {
+        fprintf(stderr, "[ERROR]\t Failed allocation of count file buffer\n");
+        exit(EXIT_FAILURE);
+      }
+      line = grown;
+      if (!fgets(line + len, (int)(line_cap - len), fp)) break;
+      len = strlen(line);
+    }
+    lineno++;
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+    if (len == 0) continue;
+
+    char* tab = strchr(line, '\t');
+    char* end = NULL;
+    unsigned long long count = tab ? strtoull(tab + 1, &end, 10) : 0;
+    long wlen = tab ? unescape(line, (size_t)(tab - line)) : -1;
+    if (wlen <= 0 || end == tab + 1 || *end != '\0' || tab[1] == '-') {
+      fprintf(stderr, "[ERROR]\t Malformed line %zu in count file: %s\n", lineno, path);
+      free(line);
+      return -1;
+    }
+    if (count) wordtable_add(table, line, (size_t)wlen, (uint64_t)count);
+  }
+  bool failed = ferror(fp) != 0;
+  free(line);
+  if (failed) {
+    fprintf(stderr, "[ERROR]\t Couldn't read count file: %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ @brief Adds the words of a count file to `table`, summing the counts of words it already holds.
+ * The format is told apart by the binary magic; anything else is read as text.
+ @return 0 on success, -1 if the file can't be read or is malformed (table may hold part of it).
+*/
+int counts_read(WordTable* table, const char* path) {
+  FILE* fp = fopen(path, "rb");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]\t Couldn't open file: %s\n", path);
+    return -1;
+  }
+  CountsHeader h;
+  int status;
+  if (fread(&h, sizeof(h), 1, fp) == 1 && memcmp(h.magic, COUNTS_MAGIC, sizeof(h.magic)) == 0) {
+    status = read_binary(table, fp, &h, path);
+  } else {
+    rewind(fp);
+    status = read_text(table, fp, path);
+  }
+  fclose(fp);
+  return status;
+}
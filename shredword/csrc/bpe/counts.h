@@ -0,0 +1,41 @@
+/**
+  @file counts.h
+  @brief Word-count files: the counted corpus, saved so it never has to be counted again.
+
+  * Only the word -> count table of a corpus matters for training, so it can be stored
+    once and reloaded for every run with other settings; tables of several shards
+    are merged by summing the counts of equal words.
+  * Binary layout: a fixed `CountsHeader` (host byte order), then one record per word:
+    count & length as LEB128 varints, then the word bytes (no terminator). Most words
+    are short & rare, so a record is usually just the word plus two or three bytes.
+  * Text layout: one `word<TAB>count` line per word. Words split by the GPT pre-tokenizers
+    may hold whitespace, so backslash, tab, newline, carriage return & NUL are written
+    as `\\`, `\t`, `\n`, `\r` & `\0`, which keeps every line unambiguous.
+*/
+
+#ifndef __COUNTS__H__
+#define __COUNTS__H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include "hash.h"
+
+#define  COUNTS_MAGIC  "SHRDWCNT"
+#define  COUNTS_VERSION  1
+#define  COUNTS_LINE_BUFFER  4096   // initial line buffer of the text reader
+
+typedef struct CountsHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t num_words;   // no of records that follow
+  uint64_t num_bytes;   // total word bytes, checked after reading the records
+} CountsHeader;
+
+extern "C" {
+  int counts_write(const WordTable* table, const char* path, bool as_text);  // 0 on success, -1 on failure
+  int counts_read(WordTable* table, const char* path);  // adds the file's counts to table, binary or text
+  bool counts_put_escaped(FILE* fp, const char* word, size_t len);  // text-layout escaping, also used by the vocab file
+}
+
+#endif  //!__COUNTS__H__
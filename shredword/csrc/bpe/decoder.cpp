@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "decoder.h"
+#include "encoder.h"
+#include "bpe.h"
+
+#define  DECODER_MAX_BYTES  ((size_t)1 << 32)   // token blob limit, merges nesting deeper are rejected
+
+/**
+ @brief Builds the token byte table of a merge list.
+ *
+ * Merged tokens are laid out in rank order, so both halves of a merge are already in the
+ * blob when it's copied together from them.
+ *
+ @param merges Merges in rank order, merge `m` makes token `256 + m` from two earlier ids.
+ @param num_merges No of merges.
+ @return New decoder, or NULL if a merge refers to a later id or the tokens get too long.
+*/
+Decoder* decoder_build(const PairKey* merges, size_t num_merges) {
+  if (!merges && num_merges > 0) {
+    fprintf(stderr, "[ERROR]\t NULL merges pointer\n");
+    return NULL;
+  }
+  size_t V = INITIAL_VOCAB_SIZE + num_merges;
+  Decoder* dec = (Decoder*)calloc(1, sizeof(Decoder));
+  size_t* offsets = dec ? (size_t*)malloc((V + 1) * sizeof(size_t)) : NULL;
+  if (!dec || !offsets) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of decoder\n");
+    exit(EXIT_FAILURE);
+  }
+  dec->offsets = offsets;
+  dec->vocab_size = V;
+  dec->max_token_bytes = 1;
+
+  // lengths first, so the blob is allocated once
+  for (size_t i = 0; i <= INITIAL_VOCAB_SIZE; i++) offsets[i] = i;
+  for (size_t m = 0; m < num_merges; m++) {
+    int32_t a = merges[m].first, b = merges[m].second;
+    size_t id = INITIAL_VOCAB_SIZE + m;
+    if (a < 0 || b < 0 || (size_t)a >= id || (size_t)b >= id) {
+      fprintf(stderr, "[ERROR]\t Malformed merge %zu: (%d, %d)\n", m, a, b);
+      decoder_destroy(dec);
+      return NULL;
+    }
+    size_t len = (offsets[a + 1] - offsets[a]) + (offsets[b + 1] - offsets[b]);
+    if (len > DECODER_MAX_BYTES - offsets[id]) {
+      fprintf(stderr, "[ERROR]\t Token bytes of the model exceed %zu bytes\n", DECODER_MAX_BYTES);
+      decoder_destroy(dec);
+      return NULL;
+    }
+    offsets[id + 1] = offsets[id] + len;
+    if (len > dec->max_token_bytes) dec->max_token_bytes = len;
+  }
+
+  dec->bytes = (char*)malloc(offsets[V]);
+  if (!dec->bytes) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of %zu token bytes\n", offsets[V]);
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < INITIAL_VOCAB_SIZE; i++) dec->bytes[i] = (char)i;
+  for (size_t m = 0; m < num_merges; m++) {
+    int32_t a = merges[m].first, b = merges[m].second;
+    char* dst = dec->bytes + offsets[INITIAL_VOCAB_SIZE + m];
+    size_t la = offsets[a + 1] - offsets[a];
+    memcpy(dst, dec->bytes + offsets[a], la);
+    memcpy(dst + la, dec->bytes + offsets[b], offsets[b + 1] - offsets[b]);
+  }
+  return dec;
+}
+
+/**
+ @brief Loads a model written by `bpe_save` into a new decoder.
+ @param model_path Path of the binary merges file (int32 triples `left, right, new_id`).
+ @return New decoder, or NULL if the file is missing or malformed.
+*/
+Decoder* decoder_create(const char* model_path) {
+  size_t M;
+  PairKey* merges = encoder_read_model(model_path, &M);
+  if (!merges) return NULL;
+  Decoder* dec = decoder_build(merges, M);
+  free(merges);
+  if (dec) printf("[INFO]\t Loaded %zu tokens (%zu bytes) from %s\n", dec->vocab_size, dec->offsets[dec->vocab_size], model_path);
+  return dec;
+}
+
+void decoder_destroy(Decoder* dec) {
+  if (!dec) return;
+  free(dec->bytes);
+  free(dec->offsets);
+  free(dec);
+}
+
+size_t decoder_vocab_size(const Decoder* dec) {
+  return dec ? dec->vocab_size : 0;
+}
+
+// total bytes of the ids, or -1 (reported) if one is outside the vocab
+static int64_t decoded_length(const Decoder* dec, const int32_t* ids, size_t n) {
+  const size_t* off = dec->offsets;
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    if ((uint32_t)ids[i] >= dec->vocab_size) {
+      fprintf(stderr, "[ERROR]\t Token id %d out of range for vocab size %zu\n", ids[i], dec->vocab_size);
+      return -1;
+    }
+    total += off[ids[i] + 1] - off[ids[i]];
+  }
+  return (int64_t)total;
+}
+
+// copies the bytes of ids already checked by `decoded_length`, returns the end of the output
+static char* decode_ids(const Decoder* dec, const int32_t* ids, size_t n, char* out) {
+  const size_t* off = dec->offsets;
+  for (size_t i = 0; i < n; i++) {
+    size_t k = off[ids[i] + 1] - off[ids[i]];
+    memcpy(out, dec->bytes + off[ids[i]], k);
+    out += k;
+  }
+  return out;
+}
+
+/**
+ @brief Decodes ids into their bytes.
+ *
+ * The length is summed up first, so a too small buffer is left untouched & the caller can
+ * retry with the returned size.
+ *
+ @param out Output buffer of `cap` bytes.
+ @return No of decoded bytes (written only if <= cap), or -1 if an id is outside the vocab.
+*/
+int64_t decoder_decode(const Decoder* dec, const int32_t* ids, size_t n, char* out, size_t cap) {
+  if (!dec || (!ids && n > 0)) {
+    fprintf(stderr, "[ERROR]\t NULL decoder or id pointers\n");
+    return -1;
+  }
+  int64_t total = decoded_length(dec, ids, n);
+  if (total >= 0 && (size_t)total <= cap) decode_ids(dec, ids, n, out);
+  return total;
+}
+
+/**
+ @brief Decodes many id sequences into one byte buffer.
+ @param ids Ids of every sequence, back to back.
+ @param offsets n + 1 entries, sequence i owns ids[offsets[i], offsets[i + 1]).
+ @param n No of sequences.
+ @return Decoded bytes & byte offsets (free with `decoder_batch_free`), or NULL if an id is outside the vocab.
+*/
+DecodeBatch* decoder_decode_batch(const Decoder* dec, const int32_t* ids, const size_t* offsets, size_t n) {
+  if (!dec || !offsets || (!ids && offsets[n] > offsets[0])) {
+    fprintf(stderr, "[ERROR]\t NULL decoder, id or offset pointers\n");
+    return NULL;
+  }
+  DecodeBatch* batch = (DecodeBatch*)malloc(sizeof(DecodeBatch));
+  size_t* out_offsets = batch ? (size_t*)malloc((n + 1) * sizeof(size_t)) : NULL;
+  if (!batch || !out_offsets) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of decode batch\n");
+    exit(EXIT_FAILURE);
+  }
+  out_offsets[0] = 0;
+  for (size_t i = 0; i < n; i++) {
+    int64_t len = offsets[i + 1] >= offsets[i] ? decoded_length(dec, ids + offsets[i], offsets[i + 1] - offsets[i]) : -1;
+    if (len < 0) {
+      fprintf(stderr, "[ERROR]\t Can't decode sequence %zu of the batch\n", i);
+      free(out_offsets);
+      free(batch);
+      return NULL;
+    }
+    out_offsets[i + 1] = out_offsets[i] + (size_t)len;
+  }
+  batch->bytes = (char*)malloc(out_offsets[n] ? out_offsets[n] : 1);
+  if (!batch->bytes) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of %zu decoded bytes\n", out_offsets[n]);
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) decode_ids(dec, ids + offsets[i], offsets[i + 1] - offsets[i], batch->bytes + out_offsets[i]);
+  batch->offsets = out_offsets;
+  batch->num_bytes = out_offsets[n];
+  batch->num_texts = n;
+  return batch;
+}
+
+void decoder_batch_free(DecodeBatch* batch) {
+  if (!batch) return;
+  free(batch->bytes);
+  free(batch->offsets);
+  free(batch);
+}
+
+DecodeStream* decoder_stream_create(const Decoder* dec) {
+  if (!dec) {
+    fprintf(stderr, "[ERROR]\t NULL decoder pointer\n");
+    return NULL;
+  }
+  DecodeStream* stream = (DecodeStream*)calloc(1, sizeof(DecodeStream));
+  if (stream) stream->buf = (char*)malloc(stream->cap = 64);
+  if (!stream || !stream->buf) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of decode stream\n");
+    exit(EXIT_FAILURE);
+  }
+  stream->dec = dec;
+  return stream;
+}
+
+void decoder_stream_destroy(DecodeStream* stream) {
+  if (!stream) return;
+  free(stream->buf);
+  free(stream);
+}
+
+// length of the longest prefix of whole UTF-8 sequences, leaving out a sequence the last bytes only start
+static size_t utf8_complete(const char* s, size_t len) {
+  size_t stop = len > 3 ? len - 3 : 0;
+  for (size_t i = len; i > stop; i--) {
+    unsigned char c = (unsigned char)s[i - 1];
+    if ((c & 0xC0) == 0x80) continue;   // continuation byte, look further back for its lead
+    size_t need = (c >= 0xF0 && c <= 0xF4) ? 4 : (c >= 0xE0 && c < 0xF0) ? 3 : (c >= 0xC2 && c < 0xE0) ? 2 : 1;
+    return i - 1 + need > len ? i - 1 : len;
+  }
+  return len;   // no lead byte among the last 3, anything left over can't be completed
+}
+
+/**
+ @brief Decodes the next ids of a stream.
+ *
+ * Bytes of a UTF-8 sequence the ids leave unfinished are kept back & handed out in front of
+ * the next ids' bytes, so every call returns whole characters only.
+ *
+ @param len Set to the no of bytes handed out, possibly 0.
+ @return The stream's bytes, valid until the next push or flush, or NULL if an id is outside the vocab (the stream is left as it was).
+*/
+const char* decoder_stream_push(DecodeStream* stream, const int32_t* ids, size_t n, size_t* len) {
+  if (!stream || !len || (!ids && n > 0)) {
+    fprintf(stderr, "[ERROR]\t NULL stream, id or length pointers\n");
+    return NULL;
+  }
+  *len = 0;
+  if (stream->emitted > 0) {
+    memmove(stream->buf, stream->buf + stream->emitted, stream->held);
+    stream->emitted = 0;
+  }
+  int64_t total = decoded_length(stream->dec, ids, n);
+  if (total < 0) return NULL;
+  size_t size = stream->held + (size_t)total;
+  if (size > stream->cap) {
+    while (stream->cap < size) stream->cap *= 2;
+    stream->buf = (char*)realloc(stream->buf, stream->cap);
+    if (!stream->buf) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of decode stream buffer\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  decode_ids(stream->dec, ids, n, stream->buf + stream->held);
+  stream->emitted = utf8_complete(stream->buf, size);
+  stream->held = size - stream->emitted;
+  *len = stream->emitted;
+  return stream->buf;
+}
+
+/**
+ @brief Hands out the bytes a stream holds back (an unfinished UTF-8 sequence) & starts it over.
+ @param len Set to the no of bytes, 0 to 3.
+ @return The bytes, valid until the next push or flush.
+*/
+const char* decoder_stream_flush(DecodeStream* stream, size_t* len) {
+  if (!stream || !len) {
+    fprintf(stderr, "[ERROR]\t NULL stream or length pointers\n");
+    return NULL;
+  }
+  if (stream->emitted > 0) memmove(stream->buf, stream->buf + stream->emitted, stream->held);
+  *len = stream->held;
+  stream->emitted = stream->held;
+  stream->held = 0;
+  return stream->buf;
+}
@@ -0,0 +1,61 @@
+/**
+  @file decoder.h
+  @brief Decodes token ids of a model written by `bpe_save` back into bytes.
+
+  * The bytes of every token are built once, from the merges in rank order, into a single blob:
+    token `i` owns `bytes[offsets[i], offsets[i + 1])`. Decoding is then one offsets lookup &
+    one `memcpy` per id, with no per-token allocation or string scan.
+  * `decoder_decode_batch` decodes a flat id array split by offsets (as `encoder_encode_batch`
+    returns them) into one byte buffer plus byte offsets.
+  * A `DecodeStream` decodes ids as they come, e.g. token by token during generation, and only
+    hands out whole UTF-8 sequences: the bytes of a character split across tokens are held back
+    (3 at most) until the token completing it arrives. Bytes that can't start or continue a
+    valid sequence are passed through as they are, so nothing is ever lost.
+  * A decoder is read-only once built and can be shared by threads; a stream belongs to one.
+*/
+
+#ifndef __DECODER__H__
+#define __DECODER__H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hash.h"
+
+typedef struct Decoder {
+  char* bytes;   // bytes of every token, back to back
+  size_t* offsets;   // vocab_size + 1 entries, token i owns bytes[offsets[i], offsets[i + 1])
+  size_t vocab_size;
+  size_t max_token_bytes;   // length of the longest token
+} Decoder;
+
+typedef struct DecodeBatch {
+  char* bytes;   // bytes of every text, back to back
+  size_t* offsets;   // text i owns bytes[offsets[i], offsets[i + 1])
+  size_t num_bytes;
+  size_t num_texts;
+} DecodeBatch;
+
+typedef struct DecodeStream {
+  const Decoder* dec;
+  char* buf;   // bytes handed out by the last push, followed by the held ones
+  size_t cap;
+  size_t emitted;   // bytes at the front of `buf` the last push handed out
+  size_t held;   // bytes after those, an unfinished UTF-8 sequence
+} DecodeStream;
+
+extern "C" {
+  Decoder* decoder_build(const PairKey* merges, size_t num_merges);
+  Decoder* decoder_create(const char* model_path);
+  void decoder_destroy(Decoder* dec);
+  size_t decoder_vocab_size(const Decoder* dec);
+  int64_t decoder_decode(const Decoder* dec, const int32_t* ids, size_t n, char* out, size_t cap);  // decoded length, bytes written only if it fits in `cap`, -1 on a bad id
+  DecodeBatch* decoder_decode_batch(const Decoder* dec, const int32_t* ids, const size_t* offsets, size_t n);
+  void decoder_batch_free(DecodeBatch* batch);
+
+  DecodeStream* decoder_stream_create(const Decoder* dec);
+  void decoder_stream_destroy(DecodeStream* stream);
+  const char* decoder_stream_push(DecodeStream* stream, const int32_t* ids, size_t n, size_t* len);  // complete UTF-8 so far, valid until the next call
+  const char* decoder_stream_flush(DecodeStream* stream, size_t* len);  // held bytes, resets the stream
+}
+
+#endif  //!__DECODER__H__
@@ -0,0 +1,724 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encoder.h"
+#include "bpe.h"
+#include "pretok.h"
+#include "scan.h"
+
+#define  NO_NODE  0xFFFFFFFFu   // end of a word's symbol list
+
+// per-call working memory for `encode_word`, grown to the longest word seen
+typedef struct EncodeScratch {
+  int32_t* sym;   // symbol of each node, -1 once merged into its left neighbour
+  uint32_t* prev;   // linked list over the nodes, NO_NODE at either end
+  uint32_t* next;
+  uint64_t* heap;   // min-heap of (rank << 32 | left node)
+  size_t cap;   // nodes covered by the arrays (heap holds 3 * cap)
+} EncodeScratch;
+
+static void scratch_reserve(EncodeScratch* s, size_t n) {
+  if (n <= s->cap) return;
+  size_t cap = s->cap ? s->cap : 64;
+  while (cap < n) cap *= 2;
+  s->sym = (int32_t*)realloc(s->sym, cap * sizeof(int32_t));
+  s->prev = (uint32_t*)realloc(s->prev, cap * sizeof(uint32_t));
+  s->next = (uint32_t*)realloc(s->next, cap * sizeof(uint32_t));
+  s->heap = (uint64_t*)realloc(s->heap, 3 * cap * sizeof(uint64_t));   // n - 1 initial pairs + 2 per merge
+  if (!s->sym || !s->prev || !s->next || !s->heap) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of encoder scratch\n");
+    exit(EXIT_FAILURE);
+  }
+  s->cap = cap;
+}
+
+static void scratch_free(EncodeScratch* s) {
+  free(s->sym);
+  free(s->prev);
+  free(s->next);
+  free(s->heap);
+  memset(s, 0, sizeof(*s));
+}
+
+static inline uint64_t rank_hash(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// rank of the merge joining a & b, ENCODER_NO_RANK if the model has none
+static inline uint32_t rank_find(const Encoder* enc, int32_t a, int32_t b) {
+  PairKey pk = { a, b };
+  uint64_t key = pair_pack(pk);
+  size_t mask = enc->nslots - 1;
+  for (size_t i = rank_hash(key) & mask;; i = (i + 1) & mask) {
+    const RankSlot* slot = &enc->slots[i];
+    if (slot->rank == ENCODER_NO_RANK || slot->key == key) return slot->rank;
+  }
+}
+
+static inline void heap_up(uint64_t* heap, size_t i) {
+  uint64_t v = heap[i];
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (heap[parent] <= v) break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = v;
+}
+
+static inline uint64_t heap_take(uint64_t* heap, size_t* size) {
+  uint64_t top = heap[0], v = heap[--*size];
+  size_t n = *size, i = 0;
+  for (;;) {
+    size_t c = 2 * i + 1;
+    if (c >= n) break;
+    if (c + 1 < n && heap[c + 1] < heap[c]) c++;
+    if (v <= heap[c]) break;
+    heap[i] = heap[c];
+    i = c;
+  }
+  if (n) heap[i] = v;
+  return top;
+}
+
+// encodes one piece of at most ENCODER_MAX_WORD bytes, returns the no of ids written
+static size_t encode_piece(const Encoder* enc, EncodeScratch* s, const unsigned char* word, size_t n, int32_t* out) {
+  if (n == 1) {
+    out[0] = word[0];
+    return 1;
+  }
+  scratch_reserve(s, n);
+  int32_t* sym = s->sym;
+  uint32_t *prev = s->prev, *next = s->next;
+  uint64_t* heap = s->heap;
+  size_t hsize = 0;
+  for (size_t i = 0; i < n; i++) {
+    sym[i] = word[i];
+    prev[i] = i ? (uint32_t)(i - 1) : NO_NODE;
+    next[i] = i + 1 < n ? (uint32_t)(i + 1) : NO_NODE;
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    uint32_t rank = rank_find(enc, sym[i], sym[i + 1]);
+    if (rank != ENCODER_NO_RANK) {
+      heap[hsize] = (uint64_t)rank << 32 | i;
+      heap_up(heap, hsize++);
+    }
+  }
+
+  while (hsize) {
+    uint64_t top = heap_take(heap, &hsize);
+    uint32_t rank = (uint32_t)(top >> 32), i = (uint32_t)top;
+    uint32_t j = next[i];
+    // stale if the left node was merged away or either side changed since the push
+    if (sym[i] < 0 || j == NO_NODE || rank_find(enc, sym[i], sym[j]) != rank) continue;
+    sym[i] = (int32_t)(INITIAL_VOCAB_SIZE + rank);
+    sym[j] = -1;
+    next[i] = next[j];
+    if (next[j] != NO_NODE) prev[next[j]] = i;
+    if (prev[i] != NO_NODE) {
+      uint32_t r = rank_find(enc, sym[prev[i]], sym[i]);
+      if (r != ENCODER_NO_RANK) {
+        heap[hsize] = (uint64_t)r << 32 | prev[i];
+        heap_up(heap, hsize++);
+      }
+    }
+    if (next[i] != NO_NODE) {
+      uint32_t r = rank_find(enc, sym[i], sym[next[i]]);
+      if (r != ENCODER_NO_RANK) {
+        heap[hsize] = (uint64_t)r << 32 | i;
+        heap_up(heap, hsize++);
+      }
+    }
+  }
+
+  // node 0 is never merged away, so the list always starts there
+  size_t count = 0;
+  for (uint32_t i = 0; i != NO_NODE; i = next[i]) out[count++] = sym[i];
+  return count;
+}
+
+// FNV-1a over the word bytes: low 32 bits are the entry tag, the rest picks the set
+static inline uint64_t word_hash(const char* p, size_t n) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < n; i++) h = (h ^ (unsigned char)p[i]) * 0x100000001b3ULL;
+  return h ^ (h >> 29);
+}
+
+// copies the cached ids of a word to `out`, returns their count or 0 if the word isn't cached
+static size_t cache_get(EncodeCache* cache, uint64_t h, const char* word, size_t len, int32_t* out) {
+  size_t set = (size_t)(h >> 32) & (cache->nsets - 1);
+  CacheLock* lock = &cache->locks[set % ENCODER_CACHE_LOCKS];
+  CacheEntry* ways = cache->entries + set * ENCODER_CACHE_WAYS;
+  size_t n = 0;
+  pthread_mutex_lock(&lock->mutex);
+  for (int w = 0; w < ENCODER_CACHE_WAYS && ways[w].len; w++) {
+    CacheEntry* e = &ways[w];
+    if (e->hash == (uint32_t)h && e->len == len && memcmp(e->word, word, len) == 0) {
+      n = e->nids;
+      memcpy(out, e->ids, n * sizeof(int32_t));
+      if (e->uses < UINT8_MAX) e->uses++;
+      break;
+    }
+  }
+  if (n) lock->hits++;
+  else lock->misses++;
+  pthread_mutex_unlock(&lock->mutex);
+  return n;
+}
+
+// caches a word's ids, evicting the least used entry of a full set; false if it was cached already
+static bool cache_put(EncodeCache* cache, uint64_t h, const char* word, size_t len, const int32_t* ids, size_t n) {
+  size_t set = (size_t)(h >> 32) & (cache->nsets - 1);
+  CacheLock* lock = &cache->locks[set % ENCODER_CACHE_LOCKS];
+  CacheEntry* ways = cache->entries + set * ENCODER_CACHE_WAYS;
+  pthread_mutex_lock(&lock->mutex);
+  CacheEntry* victim = NULL;
+  for (int w = 0; w < ENCODER_CACHE_WAYS; w++) {
+    CacheEntry* e = &ways[w];
+    if (!e->len) {   // entries are never freed one by one, so the rest of the set is empty too
+      victim = e;
+      break;
+    }
+    if (e->hash == (uint32_t)h && e->len == len && memcmp(e->word, word, len) == 0) {   // another thread was first
+      pthread_mutex_unlock(&lock->mutex);
+      return false;
+    }
+    if (!victim || e->uses < victim->uses) victim = e;
+  }
+  if (victim->len) {
+    for (int w = 0; w < ENCODER_CACHE_WAYS; w++) ways[w].uses >>= 1;
+  } else {
+    lock->size++;
+  }
+  victim->hash = (uint32_t)h;
+  victim->len = (uint8_t)len;
+  victim->nids = (uint8_t)n;
+  victim->uses = 1;
+  memcpy(victim->word, word, len);
+  memcpy(victim->ids, ids, n * sizeof(int32_t));
+  pthread_mutex_unlock(&lock->mutex);
+  return true;
+}
+
+static size_t encode_word(const Encoder* enc, EncodeScratch* s, const char* word, size_t len, int32_t* out) {
+  EncodeCache* cache = enc->cache;
+  if (cache && len > 1 && len <= ENCODER_CACHE_WORD) {
+    uint64_t h = word_hash(word, len);
+    size_t n = cache_get(cache, h, word, len, out);
+    if (n) return n;
+    n = encode_piece(enc, s, (const unsigned char*)word, len, out);
+    if (n <= ENCODER_CACHE_IDS) cache_put(cache, h, word, len, out, n);
+    return n;
+  }
+  size_t count = 0;
+  for (size_t off = 0; off < len; off += ENCODER_MAX_WORD) {
+    size_t n = len - off < ENCODER_MAX_WORD ? len - off : ENCODER_MAX_WORD;
+    count += encode_piece(enc, s, (const unsigned char*)word + off, n, out + count);
+  }
+  return count;
+}
+
+// splits text with the encoder's pre-tokenizer & encodes every word
+static size_t encode_text(const Encoder* enc, EncodeScratch* s, const char* text, size_t len, int32_t* out) {
+  const char *p = text, *end = text + len;
+  size_t count = 0;
+  if (enc->pre_tokenizer == PRETOK_WHITESPACE) {
+    while (p < end) {
+      size_t w = scan_to_delim(p, (size_t)(end - p));
+      if (w == 0) {
+        out[count++] = (unsigned char)*p++;   // delimiters stay single bytes
+        continue;
+      }
+      count += encode_word(enc, s, p, w, out + count);
+      p += w;
+    }
+  } else {
+    while (p < end) {
+      size_t w = pretok_next(enc->pre_tokenizer, p, end);
+      count += encode_word(enc, s, p, w, out + count);
+      p += w;
+    }
+  }
+  return count;
+}
+
+typedef struct EncodeShard {
+  const Encoder* enc;
+  const char* const* texts;
+  const size_t* lengths;
+  size_t begin, end;   // texts [begin, end) of the batch
+  size_t* offsets;   // batch offsets, filled relative to this shard's `ids` for [begin + 1, end]
+  int32_t* ids;   // ids of the shard's texts, back to back
+  size_t count, cap;
+} EncodeShard;
+
+static void encode_shard_task(void* arg, int tid) {
+  EncodeShard* shard = &((EncodeShard*)arg)[tid];
+  EncodeScratch s = {};
+  for (size_t i = shard->begin; i < shard->end; i++) {
+    size_t len = shard->lengths[i];
+    if (shard->count + len > shard->cap) {   // never more ids than bytes
+      size_t cap = shard->cap ? shard->cap : 1024;
+      while (cap < shard->count + len) cap *= 2;
+      shard->ids = (int32_t*)realloc(shard->ids, cap * sizeof(int32_t));
+      if (!shard->ids) {
+        fprintf(stderr, "[ERROR]\t Failed allocation of batch ids\n");
+        exit(EXIT_FAILURE);
+      }
+      shard->cap = cap;
+    }
+    shard->count += encode_text(shard->enc, &s, shard->texts[i], len, shard->ids + shard->count);
+    shard->offsets[i + 1] = shard->count;
+  }
+  scratch_free(&s);
+}
+
+/**
+ @brief Reads the merges of a model written by `bpe_save`, checking that every merge builds
+ * on earlier ids and produces the next one.
+ *
+ @param model_path Path of the binary merges file (int32 triples `left, right, new_id`).
+ @param num_merges Set to the no of merges read.
+ @return Merges in rank order (caller frees), or NULL if the file is missing or malformed.
+*/
+PairKey* encoder_read_model(const char* model_path, size_t* num_merges) {
+  if (!model_path || !num_merges) {
+    fprintf(stderr, "[ERROR]\t NULL model path or merge count pointers\n");
+    return NULL;
+  }
+  FILE* fp = fopen(model_path, "rb");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]\t Cannot open model file: %s\n", model_path);
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  size_t triple = 3 * sizeof(int32_t);
+  if (size < 0 || (size_t)size % triple != 0 || (size_t)size / triple >= ENCODER_NO_RANK - INITIAL_VOCAB_SIZE) {
+    fprintf(stderr, "[ERROR]\t Malformed model file: %s\n", model_path);
+    fclose(fp);
+    return NULL;
+  }
+  size_t M = (size_t)size / triple;
+  int32_t* raw = (int32_t*)malloc((size_t)size + triple);
+  if (!raw || fread(raw, triple, M, fp) != M) {
+    fprintf(stderr, "[ERROR]\t Cannot read model file: %s\n", model_path);
+    free(raw);
+    fclose(fp);
+    return NULL;
+  }
+  fclose(fp);
+
+  // packed in place: merge m's pair never overlaps the triples still to be read
+  PairKey* merges = (PairKey*)raw;
+  for (size_t m = 0; m < M; m++) {
+    int32_t a = raw[3 * m], b = raw[3 * m + 1], id = raw[3 * m + 2];
+    int32_t expected = (int32_t)(INITIAL_VOCAB_SIZE + m);
+    if (id != expected || a < 0 || b < 0 || a >= expected || b >= expected) {
+      fprintf(stderr, "[ERROR]\t Malformed merge %zu in model file: %s\n", m, model_path);
+      free(raw);
+      return NULL;
+    }
+    merges[m].first = a;
+    merges[m].second = b;
+  }
+  *num_merges = M;
+  return merges;
+}
+
+/**
+ @brief Loads the merges of a model written by `bpe_save` into a new encoder.
+ *
+ * The model file doesn't record how its corpus was split, so `pre_tokenizer` has to be the
+ * one the trainer was configured with; a mismatch still encodes losslessly, just into ids
+ * the model wasn't trained on.
+ *
+ @param model_path Path of the binary merges file (int32 triples `left, right, new_id`).
+ @param pre_tokenizer `PreTokenizer` to split text with.
+ @param num_threads Threads for `encoder_encode_batch`, <= 0 for all available cores.
+ @return New encoder, or NULL if the file is missing or malformed.
+*/
+Encoder* encoder_create(const char* model_path, int pre_tokenizer, int num_threads) {
+  if (pre_tokenizer < PRETOK_WHITESPACE || pre_tokenizer > PRETOK_GPT4) {
+    fprintf(stderr, "[ERROR]\t Unknown pre-tokenizer: %d\n", pre_tokenizer);
+    return NULL;
+  }
+  size_t M;
+  PairKey* merges = encoder_read_model(model_path, &M);
+  if (!merges) return NULL;
+
+  Encoder* enc = (Encoder*)calloc(1, sizeof(Encoder));
+  size_t nslots = 16;
+  while (nslots < 2 * M) nslots *= 2;   // load stays at or below one half
+  RankSlot* slots = enc ? (RankSlot*)malloc(nslots * sizeof(RankSlot)) : NULL;
+  if (!enc || !slots) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of encoder\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < nslots; i++) slots[i].rank = ENCODER_NO_RANK;
+  enc->slots = slots;
+  enc->nslots = nslots;
+  enc->num_merges = M;
+  enc->pre_tokenizer = pre_tokenizer;
+  enc->num_threads = num_threads;
+  pthread_mutex_init(&enc->batch_mutex, NULL);
+
+  for (size_t m = 0; m < M; m++) {
+    uint64_t key = pair_pack(merges[m]);
+    size_t i = rank_hash(key) & (nslots - 1);
+    while (slots[i].rank != ENCODER_NO_RANK && slots[i].key != key) i = (i + 1) & (nslots - 1);
+    if (slots[i].rank == ENCODER_NO_RANK) {   // a repeated pair keeps its first (effective) rank
+      slots[i].key = key;
+      slots[i].rank = (uint32_t)m;
+    }
+  }
+  free(merges);
+  printf("[INFO]\t Loaded %zu merges from %s\n", M, model_path);
+  return enc;
+}
+
+void encoder_destroy(Encoder* enc) {
+  if (!enc) return;
+  if (enc->pool) threadpool_destroy(enc->pool);
+  encoder_set_cache(enc, 0);
+  pthread_mutex_destroy(&enc->batch_mutex);
+  free(enc->slots);
+  free(enc);
+}
+
+size_t encoder_vocab_size(const Encoder* enc) {
+  return enc ? INITIAL_VOCAB_SIZE + enc->num_merges : 0;
+}
+
+/**
+ @brief Encodes a single word as is, without pre-tokenizing it.
+ @param out Room for `len` ids, never more ids than bytes are written.
+ @return No of ids written.
+*/
+size_t encoder_encode_word(const Encoder* enc, const char* word, size_t len, int32_t* out) {
+  if (!enc || (!word && len)) return 0;
+  EncodeScratch s = {};
+  size_t count = encode_word(enc, &s, word, len, out);
+  scratch_free(&s);
+  return count;
+}
+
+/**
+ @brief Pre-tokenizes `text` & encodes every word of it.
+ @param out Room for `len` ids, never more ids than bytes are written.
+ @return No of ids written.
+*/
+size_t encoder_encode(const Encoder* enc, const char* text, size_t len, int32_t* out) {
+  if (!enc || (!text && len)) return 0;
+  EncodeScratch s = {};
+  size_t count = encode_text(enc, &s, text, len, out);
+  scratch_free(&s);
+  return count;
+}
+
+/**
+ @brief Encodes a batch of texts on the encoder's thread pool.
+ *
+ * The texts are split into contiguous runs of about equal bytes, one per thread (batches under
+ * `MIN_SHARD_BYTES` per thread use fewer), and every thread encodes its run into its own buffer.
+ * The buffers are then joined in text order, so the result doesn't depend on the thread count.
+ *
+ @param texts Texts to encode; they are only read, so they can point into caller-owned buffers.
+ @param lengths Byte length of each text.
+ @param n No of texts.
+ @return Batch owning its ids & offsets (free with `encoder_batch_free`), or NULL on bad arguments.
+*/
+EncodeBatch* encoder_encode_batch(Encoder* enc, const char* const* texts, const size_t* lengths, size_t n) {
+  if (!enc || (n && (!texts || !lengths))) {
+    fprintf(stderr, "[ERROR]\t NULL encoder or text pointers\n");
+    return NULL;
+  }
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (!texts[i] && lengths[i]) {
+      fprintf(stderr, "[ERROR]\t NULL text %zu in batch\n", i);
+      return NULL;
+    }
+    total += lengths[i];
+  }
+
+  EncodeBatch* batch = (EncodeBatch*)calloc(1, sizeof(EncodeBatch));
+  size_t* offsets = (size_t*)malloc((n + 1) * sizeof(size_t));
+  if (!batch || !offsets) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of encode batch\n");
+    exit(EXIT_FAILURE);
+  }
+  offsets[0] = 0;
+
+  // one run of texts per thread, cut where the byte total crosses the next share
+  pthread_mutex_lock(&enc->batch_mutex);
+  if (!enc->pool) enc->pool = threadpool_create(resolve_threads(enc->num_threads));
+  size_t nshards = (size_t)threadpool_size(enc->pool);
+  if (nshards > total / MIN_SHARD_BYTES) nshards = total / MIN_SHARD_BYTES;
+  if (nshards > n) nshards = n;
+  if (nshards < 1) nshards = 1;
+  EncodeShard* shards = (EncodeShard*)calloc(nshards, sizeof(EncodeShard));
+  if (!shards) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of encode shards\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t i = 0, seen = 0;
+  for (size_t t = 0; t < nshards; t++) {
+    size_t share = t + 1 == nshards ? total : total / nshards * (t + 1);
+    shards[t].enc = enc;
+    shards[t].texts = texts;
+    shards[t].lengths = lengths;
+    shards[t].offsets = offsets;
+    shards[t].begin = i;
+    while (i < n && (seen < share || t + 1 == nshards)) seen += lengths[i++];
+    shards[t].end = i;
+  }
+  if (nshards == 1) encode_shard_task(shards, 0);
+  else threadpool_run(enc->pool, (int)nshards, encode_shard_task, shards);
+
+  // joining the shards: the first buffer grows to hold the rest
+  size_t num_ids = 0;
+  for (size_t t = 0; t < nshards; t++) num_ids += shards[t].count;
+  int32_t* ids = (int32_t*)realloc(shards[0].ids, (num_ids ? num_ids : 1) * sizeof(int32_t));
+  if (!ids) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of batch ids\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t base = shards[0].count;
+  for (size_t t = 1; t < nshards; t++) {
+    memcpy(ids + base, shards[t].ids, shards[t].count * sizeof(int32_t));
+    for (size_t k = shards[t].begin; k < shards[t].end; k++) offsets[k + 1] += base;
+    base += shards[t].count;
+    free(shards[t].ids);
+  }
+  free(shards);
+  pthread_mutex_unlock(&enc->batch_mutex);
+
+  batch->ids = ids;
+  batch->offsets = offsets;
+  batch->num_ids = num_ids;
+  batch->num_texts = n;
+  return batch;
+}
+
+void encoder_batch_free(EncodeBatch* batch) {
+  if (!batch) return;
+  free(batch->ids);
+  free(batch->offsets);
+  free(batch);
+}
+
+/**
+ @brief Replaces the encoder's word cache with an empty one, hit & miss counts start over.
+ *
+ * Must not be called while the encoder is in use on other threads.
+ *
+ @param capacity Words the cache can hold, rounded up to whole sets of `ENCODER_CACHE_WAYS`
+                 (& a power of two of them); 0 turns the cache off.
+ @return 0 on success, -1 for a NULL encoder.
+*/
+int encoder_set_cache(Encoder* enc, size_t capacity) {
+  if (!enc) {
+    fprintf(stderr, "[ERROR]\t NULL encoder pointer\n");
+    return -1;
+  }
+  EncodeCache* cache = enc->cache;
+  if (cache) {
+    for (int i = 0; i < ENCODER_CACHE_LOCKS; i++) pthread_mutex_destroy(&cache->locks[i].mutex);
+    free(cache->entries);
+    free(cache);
+    enc->cache = NULL;
+  }
+  if (capacity == 0) return 0;
+
+  size_t nsets = 1;
+  while (nsets * ENCODER_CACHE_WAYS < capacity) nsets *= 2;
+  cache = (EncodeCache*)calloc(1, sizeof(EncodeCache));
+  CacheEntry* entries = cache ? (CacheEntry*)calloc(nsets * ENCODER_CACHE_WAYS, sizeof(CacheEntry)) : NULL;
+  if (!cache || !entries) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of encode cache\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < ENCODER_CACHE_LOCKS; i++) pthread_mutex_init(&cache->locks[i].mutex, NULL);
+  cache->entries = entries;
+  cache->nsets = nsets;
+  enc->cache = cache;
+  return 0;
+}
+
+// hits & misses count lookups of words short enough to be cached; all zero if the cache is off
+void encoder_cache_stats(const Encoder* enc, uint64_t* hits, uint64_t* misses, size_t* size) {
+  uint64_t h = 0, m = 0;
+  size_t n = 0;
+  EncodeCache* cache = enc ? enc->cache : NULL;
+  for (int i = 0; cache && i < ENCODER_CACHE_LOCKS; i++) {
+    CacheLock* lock = &cache->locks[i];
+    pthread_mutex_lock(&lock->mutex);
+    h += lock->hits;
+    m += lock->misses;
+    n += lock->size;
+    pthread_mutex_unlock(&lock->mutex);
+  }
+  if (hits) *hits = h;
+  if (misses) *misses = m;
+  if (size) *size = n;
+}
+
+typedef struct WarmWord {
+  uint64_t count;
+  size_t offset;   // word bytes in the candidate buffer (or the pending table's arena)
+  size_t len;
+  const char* base;
+} WarmWord;
+
+static int warmword_cmp(const void* a, const void* b) {
+  const WarmWord *x = (const WarmWord*)a, *y = (const WarmWord*)b;
+  if (x->count != y->count) return x->count > y->count ? -1 : 1;
+  if (x->len != y->len) return x->len < y->len ? -1 : 1;
+  return memcmp(x->base + x->offset, y->base + y->offset, x->len);
+}
+
+static void warm_push(WarmWord** words, size_t* n, size_t* cap, WarmWord w) {
+  if (*n == *cap) {
+    *cap = *cap ? *cap * 2 : 1024;
+    *words = (WarmWord*)realloc(*words, *cap * sizeof(WarmWord));
+    if (!*words) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of warm-up words\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  (*words)[(*n)++] = w;
+}
+
+/**
+ @brief Fills the cache with the most frequent words a trainer has counted.
+ *
+ * Reads the pending word counts if the corpus isn't built yet (after `bpe_count_files`,
+ * `bpe_feed` or `bpe_load_counts`), otherwise the corpus words, rebuilt from their ids.
+ * Corpus words holding characters that `character_coverage` mapped to `unk_id` are skipped,
+ * their bytes are lost. Words are encoded with this encoder, so the trainer may hold any model.
+ *
+ @param max_words Most words to cache, 0 for as many as the cache holds.
+ @return No of words cached, or -1 if the cache is off or the trainer holds no words.
+*/
+long encoder_warm(Encoder* enc, const Trainer* trainer, size_t max_words) {
+  if (!enc || !trainer) {
+    fprintf(stderr, "[ERROR]\t NULL encoder or trainer pointers\n");
+    return -1;
+  }
+  if (!enc->cache) {
+    fprintf(stderr, "[ERROR]\t Encode cache is off, nothing to warm\n");
+    return -1;
+  }
+  WarmWord* words = NULL;
+  size_t n = 0, cap = 0;
+  char* bytes = NULL;   // rebuilt corpus words, back to back
+
+  WordTable merged;   // pending tables combined, a word counted by several threads holds its total
+  bool own_merged = false;
+
+  if (trainer->pending) {
+    const WordTable* table = &trainer->pending[0];
+    if (trainer->npending > 1) {
+      wordtable_init(&merged, INITIAL_STR_BUFFER);
+      for (size_t t = 0; t < trainer->npending; t++) wordtable_merge(&merged, &trainer->pending[t]);
+      table = &merged;
+      own_merged = true;
+    }
+    for (size_t i = 0; i < table->size; i++) {
+      const WordEntry* e = &table->entries[i];
+      if (e->len < 2 || e->len > ENCODER_CACHE_WORD) continue;
+      WarmWord w = { e->count, e->offset, e->len, table->arena };
+      warm_push(&words, &n, &cap, w);
+    }
+  } else if (trainer->corpus.symbols) {
+    // bytes of every token, the merges build on earlier ids
+    const Corpus* corpus = &trainer->corpus;
+    size_t T = INITIAL_VOCAB_SIZE + trainer->num_merges;
+    size_t* tok_off = (size_t*)malloc(T * sizeof(size_t));
+    size_t* tok_len = (size_t*)malloc(T * sizeof(size_t));
+    size_t blob_size = INITIAL_VOCAB_SIZE;
+    for (size_t i = 0; tok_len && i < T; i++) {
+      tok_len[i] = i < INITIAL_VOCAB_SIZE ? 1 : tok_len[trainer->merge_ops[i - INITIAL_VOCAB_SIZE].first] + tok_len[trainer->merge_ops[i - INITIAL_VOCAB_SIZE].second];
+      if (i >= INITIAL_VOCAB_SIZE) blob_size += tok_len[i];
+    }
+    char* blob = (char*)malloc(blob_size);
+    if (!tok_off || !tok_len || !blob) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of warm-up words\n");
+      exit(EXIT_FAILURE);
+    }
+    size_t pos = 0;
+    for (size_t i = 0; i < T; i++) {
+      tok_off[i] = pos;
+      if (i < INITIAL_VOCAB_SIZE) {
+        blob[pos] = (char)i;
+      } else {
+        PairKey op = trainer->merge_ops[i - INITIAL_VOCAB_SIZE];
+        memcpy(blob + pos, blob + tok_off[op.first], tok_len[op.first]);
+        memcpy(blob + pos + tok_len[op.first], blob + tok_off[op.second], tok_len[op.second]);
+      }
+      pos += tok_len[i];
+    }
+
+    size_t used = 0, bytes_cap = 0;
+    for (size_t wi = 0; wi < corpus->vocab_size; wi++) {
+      if (used + ENCODER_CACHE_WORD > bytes_cap) {
+        bytes_cap = bytes_cap ? bytes_cap * 2 : 1 << 16;
+        bytes = (char*)realloc(bytes, bytes_cap);
+        if (!bytes) {
+          fprintf(stderr, "[ERROR]\t Failed allocation of warm-up words\n");
+          exit(EXIT_FAILURE);
+        }
+      }
+      const int32_t* ids = corpus->symbols + corpus->offsets[wi];
+      size_t len = 0;
+      bool ok = true;
+      for (uint32_t k = 0; ok && k < corpus->lengths[wi]; k++) {
+        int32_t id = ids[k];
+        ok = id != trainer->config.unk_id && id >= 0 && (size_t)id < T && len + tok_len[id] <= ENCODER_CACHE_WORD;
+        if (ok) {
+          memcpy(bytes + used + len, blob + tok_off[id], tok_len[id]);
+          len += tok_len[id];
+        }
+      }
+      if (!ok || len < 2) continue;
+      WarmWord w = { corpus->word_counts[wi], used, len, NULL };
+      warm_push(&words, &n, &cap, w);
+      used += len;
+    }
+    for (size_t i = 0; i < n; i++) words[i].base = bytes;
+    free(tok_off);
+    free(tok_len);
+    free(blob);
+  } else {
+    fprintf(stderr, "[ERROR]\t Trainer holds no word counts to warm the cache with\n");
+    return -1;
+  }
+
+  // the least frequent go in first, so a full set evicts them before the hotter words
+  qsort(words, n, sizeof(WarmWord), warmword_cmp);
+  size_t limit = enc->cache->nsets * ENCODER_CACHE_WAYS;
+  if (max_words && max_words < limit) limit = max_words;
+  if (n > limit) n = limit;
+  EncodeScratch s = {};
+  int32_t out[ENCODER_CACHE_WORD];
+  long cached = 0;
+  for (size_t i = n; i-- > 0; ) {
+    const char* word = words[i].base + words[i].offset;
+    size_t k = encode_piece(enc, &s, (const unsigned char*)word, words[i].len, out);
+    if (k > ENCODER_CACHE_IDS) continue;
+    if (cache_put(enc->cache, word_hash(word, words[i].len), word, words[i].len, out, k)) cached++;
+  }
+  scratch_free(&s);
+  free(words);
+  free(bytes);
+  if (own_merged) wordtable_free(&merged);
+  printf("[INFO]\t Warmed the encode cache with %ld words\n", cached);
+  return cached;
+}
@@ -0,0 +1,105 @@
+/**
+  @file encoder.h
+  @brief Encodes text into the token ids of a model written by `bpe_save`.
+
+  * The model's merges are loaded into a rank table: an open-addressing table from the
+    packed pair to its rank, i.e. its index in the model file; merge `rank` makes token
+    `256 + rank`. A pair merged more than once keeps its first rank, as in `bpe_load_merges`.
+  * A word starts out as its bytes, held in a linked list. The adjacent pairs with a rank are
+    queued in a min-heap by (rank, position); the lowest-ranked pair is merged & the pairs it
+    forms with its neighbours are queued. Entries that an earlier merge made stale are skipped
+    when popped. That is O(n log n) for a word of n bytes & gives the same ids as applying the
+    merges one after another in rank order, as training did.
+  * Text is cut into words by the pre-tokenizer the model was trained with (see pretok.h).
+    In whitespace mode the delimiters belong to no word, so each one becomes its own byte id:
+    every input byte is covered & the ids decode back to the exact text.
+  * `encoder_encode_batch` splits a batch of texts into contiguous runs of about equal bytes,
+    one per pool thread, and joins the results into one id array plus an offsets array, in
+    the order of the texts. An encoder runs one batch at a time: batches from several threads
+    wait on its batch mutex, since the pool runs one task at a time.
+  * Natural text repeats the same words over & over, so words up to ENCODER_CACHE_WORD bytes
+    that encode into at most ENCODER_CACHE_IDS ids can be kept in a bounded cache. It is
+    set-associative: a word's hash picks a set of ENCODER_CACHE_WAYS entries, guarded by one of
+    ENCODER_CACHE_LOCKS striped mutexes, and a full set evicts its least used entry (use counts
+    are halved on every eviction, so words that stopped showing up age out). The cache can be
+    warmed with the most frequent words of a trainer's word table.
+*/
+
+#ifndef __ENCODER__H__
+#define __ENCODER__H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "hash.h"
+#include "../threads.h"
+
+#define  ENCODER_NO_RANK  0xFFFFFFFFu   // rank of a pair that isn't merged, marks free table slots
+#define  ENCODER_MAX_WORD  (1 << 20)   // longer words are encoded in pieces of this many bytes
+#define  ENCODER_CACHE_WORD  29   // longest cached word in bytes, sized so an entry fills 64 bytes
+#define  ENCODER_CACHE_IDS  7   // most ids a cached word may encode into
+#define  ENCODER_CACHE_WAYS  8   // entries per cache set
+#define  ENCODER_CACHE_LOCKS  64   // mutexes striped over the cache sets
+
+typedef struct RankSlot {
+  uint64_t key;   // packed pair, see `pair_pack`
+  uint32_t rank;   // merge index, ENCODER_NO_RANK when the slot is free
+} RankSlot;
+
+typedef struct Trainer Trainer;  // see bpe.h, source of the words `encoder_warm` caches
+
+typedef struct CacheEntry {
+  uint32_t hash;   // low bits of the word hash
+  uint8_t len;   // word length in bytes, 0 when the entry is free
+  uint8_t nids;
+  uint8_t uses;   // saturating use count, halved on every eviction from the set
+  char word[ENCODER_CACHE_WORD];
+  int32_t ids[ENCODER_CACHE_IDS];
+} CacheEntry;
+
+typedef struct CacheLock {
+  pthread_mutex_t mutex;   // guards the sets `s` with s % ENCODER_CACHE_LOCKS == this stripe
+  uint64_t hits, misses;   // lookups of those sets
+  size_t size;   // entries held in those sets
+} CacheLock;
+
+typedef struct EncodeCache {
+  CacheEntry* entries;   // nsets * ENCODER_CACHE_WAYS entries, set by set
+  size_t nsets;   // always a power of two
+  CacheLock locks[ENCODER_CACHE_LOCKS];
+} EncodeCache;
+
+typedef struct Encoder {
+  RankSlot* slots;   // rank table (linear probing)
+  size_t nslots;   // table capacity, always a power of two
+  size_t num_merges;
+  int32_t pre_tokenizer;   // `PreTokenizer` the text is split with
+  int32_t num_threads;   // batch encoding threads, <= 0 -> all available cores
+  ThreadPool* pool;   // created on the first batch
+  pthread_mutex_t batch_mutex;   // held by the running batch, from pool creation to the shard join
+  EncodeCache* cache;   // word -> ids cache, NULL if off
+} Encoder;
+
+typedef struct EncodeBatch {
+  int32_t* ids;   // ids of every text, back to back
+  size_t* offsets;   // text i owns ids[offsets[i], offsets[i + 1])
+  size_t num_ids;
+  size_t num_texts;
+} EncodeBatch;
+
+extern "C" {
+  PairKey* encoder_read_model(const char* model_path, size_t* num_merges);  // checked merges of a model file, NULL on error
+  Encoder* encoder_create(const char* model_path, int pre_tokenizer, int num_threads);
+  void encoder_destroy(Encoder* enc);
+  size_t encoder_vocab_size(const Encoder* enc);
+  size_t encoder_encode_word(const Encoder* enc, const char* word, size_t len, int32_t* out);  // one word, no pre-tokenization
+  size_t encoder_encode(const Encoder* enc, const char* text, size_t len, int32_t* out);  // `out` holds `len` ids, returns the id count
+  EncodeBatch* encoder_encode_batch(Encoder* enc, const char* const* texts, const size_t* lengths, size_t n);
+  void encoder_batch_free(EncodeBatch* batch);
+
+  int encoder_set_cache(Encoder* enc, size_t capacity);  // (re)creates the cache with room for `capacity` words, 0 turns it off
+  void encoder_cache_stats(const Encoder* enc, uint64_t* hits, uint64_t* misses, size_t* size);
+  long encoder_warm(Encoder* enc, const Trainer* trainer, size_t max_words);  // caches the trainer's most frequent words
+}
+
+#endif  //!__ENCODER__H__
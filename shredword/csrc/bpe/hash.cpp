@@ -4,15 +4,35 @@
 #include <stdio.h>
 #include "hash.h"
 
-static uint32_t hash_pair(PairKey key) {
-  // using FNV-1a hash for better distribution
-  uint32_t hash = 2166136261u;
-  uint8_t* bytes = (uint8_t*)&key;
-  for (size_t i = 0; i < sizeof(PairKey); i++) {
-    hash ^= bytes[i];
-    hash *= 16777619u;
+// 64-bit finalizer (murmur3 fmix64)
+static inline uint64_t mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb3fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// spreads packed pair keys over the probe table
+static inline uint64_t hash_pair(uint64_t packed) {
+  return mix64(packed);
+}
+
+// hashes key bytes eight at a time, finishing with mix64
+static inline uint64_t hash_bytes(const char* key, size_t len) {
+  uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)len;
+  while (len >= 8) {
+    uint64_t v;
+    memcpy(&v, key, 8);
+    h = (h ^ v) * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 31;
+    key += 8;
+    len -= 8;
   }
-  return hash;
+  uint64_t v = 0;
+  memcpy(&v, key, len);
+  return mix64(h ^ v);
 }
 
 // --- Initialize a string map with given bucket count (power of two) ---
@@ -23,6 +43,7 @@ void strmap_init(StrMap* map, size_t nbuckets) {
   }
   map->nbuckets = nbuckets;
   map->buckets = (StrEntry**)calloc(nbuckets, sizeof(StrEntry*));
+  map->arena = NULL;
 }
 
 // --- Increment the count for key (creates if missing) ---
@@ -31,27 +52,99 @@ void strmap_increment(StrMap* map, const char* key) {
     fprintf(stderr, "Pointer to Map not found!\n");
     exit(EXIT_FAILURE);
   }
-  // djb2 hash
+  strmap_increment_n(map, key, strlen(key));
+}
+
+// djb2 hash over a (pointer, length) key
+static size_t hash_str(const char* key, size_t len) {
   size_t h = 5381;
-  for (const unsigned char* s = (const unsigned char*)key; *s; s++) {
-    h = ((h << 5) + h) + *s;
+  const unsigned char* s = (const unsigned char*)key;
+  for (size_t i = 0; i < len; i++) {
+    h = ((h << 5) + h) + s[i];
   }
-  size_t idx = h & (map->nbuckets - 1);
+  return h;
+}
+
+/**
+ @brief Increment the count for a key given as a (pointer, length) view.
+ * The key need not be NUL-terminated, e.g. a token inside a memory-mapped
+ * file. Bytes are only copied (and terminated) when the key is first inserted.
+ @param map The map
+ @param key Start of the key bytes
+ @param len Number of bytes in the key
+*/
+void strmap_increment_n(StrMap* map, const char* key, size_t len) {
+  strmap_add_n(map, key, len, 1);
+}
+
+// --- Add `count` to the value of a (pointer, length) key (creates if missing) ---
+void strmap_add_n(StrMap* map, const char* key, size_t len, uint64_t count) {
+  if (!map) {
+    fprintf(stderr, "Pointer to Map not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t idx = hash_str(key, len) & (map->nbuckets - 1);
   StrEntry** p = &map->buckets[idx];
   while (*p) {
-    if (strcmp((*p)->key, key) == 0) {
-      (*p)->value++;
+    if ((*p)->len == len && memcmp((*p)->key, key, len) == 0) {
+      (*p)->value += count;
       return;
     }
     p = &(*p)->next;
   }
-  StrEntry* e = (StrEntry*)malloc(sizeof(StrEntry));
-  e->key = strdup(key);
-  e->value = 1;
+  StrEntry* e;
+  if (map->arena) {
+    e = (StrEntry*)arena_alloc(map->arena, sizeof(StrEntry));
+    e->key = (char*)arena_alloc(map->arena, len + 1);
+  } else {
+    e = (StrEntry*)malloc(sizeof(StrEntry));
+    e->key = (char*)malloc(len + 1);
+  }
+  memcpy(e->key, key, len);
+  e->key[len] = '\0';
+  e->len = len;
+  e->value = count;
   e->next = NULL;
   *p = e;
 }
 
+/**
+ @brief Merge all counts of `src` into `dst`, leaving `src` empty.
+ * Entries missing from `dst` are relinked rather than copied, so both maps
+ * must draw from the same arena (or both from malloc).
+ @param dst Map receiving the counts
+ @param src Map to drain (still needs `strmap_free`)
+*/
+void strmap_merge(StrMap* dst, StrMap* src) {
+  if (!dst || !src) {
+    fprintf(stderr, "Pointer to Map not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < src->nbuckets; i++) {
+    StrEntry* e = src->buckets[i];
+    while (e) {
+      StrEntry* n = e->next;
+      size_t idx = hash_str(e->key, e->len) & (dst->nbuckets - 1);
+      StrEntry** p = &dst->buckets[idx];
+      while (*p && !((*p)->len == e->len && memcmp((*p)->key, e->key, e->len) == 0)) {
+        p = &(*p)->next;
+      }
+      if (*p) {
+        (*p)->value += e->value;
+        if (!src->arena) {
+          free(e->key);
+          free(e);
+        }
+      } else {
+        e->next = NULL;
+        *p = e;
+      }
+      e = n;
+    }
+    src->buckets[i] = NULL;
+  }
+}
+
 /**
  @brief Iterate over all entries in the map.
  * @param m The map
@@ -71,13 +164,13 @@ void strmap_iter(StrMap* map, void(*func)(const char*, uint64_t, void*), void* u
   }
 }
 
-// --- Free all resources held by the map ---
+// --- Free all resources held by the map (arena-backed entries go with their arena) ---
 void strmap_free(StrMap *map) {
   if (!map) {
     fprintf(stderr, "Pointer to Map not found!\n");
     exit(EXIT_FAILURE);
   }
-  for (size_t i = 0; i < map->nbuckets; i++) {
+  for (size_t i = 0; i < map->nbuckets && !map->arena; i++) {
     StrEntry* e = map->buckets[i];
     while (e) {
       StrEntry *n = e->next;
@@ -90,70 +183,328 @@ void strmap_free(StrMap *map) {
   map->buckets = NULL;
 }
 
-// --- Initialize bigram info map. ---
-void bimap_init(BIMap* map, size_t nbuckets) {
+// --- Initialize a word table sized for roughly `capacity` unique words. ---
+void wordtable_init(WordTable* table, size_t capacity) {
+  if (!table) {
+    fprintf(stderr, "Pointer to WordTable not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t nslots = 16;
+  while (nslots * WORDTABLE_MAX_LOAD < capacity) nslots <<= 1;
+  table->nslots = nslots;
+  table->slots = (WordSlot*)malloc(nslots * sizeof(WordSlot));
+  table->cap = capacity > 0 ? capacity : 16;
+  table->entries = (WordEntry*)malloc(table->cap * sizeof(WordEntry));
+  table->arena_cap = table->cap * 8;
+  table->arena = (char*)malloc(table->arena_cap);
+  if (!table->slots || !table->entries || !table->arena) {
+    fprintf(stderr, "Memory allocation failed for WordTable!\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < nslots; i++) table->slots[i].idx = WORDTABLE_EMPTY;
+  table->size = 0;
+  table->arena_size = 0;
+}
+
+// doubles the probe table, reusing the cached hashes
+static void wordtable_grow_slots(WordTable* table) {
+  size_t nslots = table->nslots << 1;
+  WordSlot* slots = (WordSlot*)malloc(nslots * sizeof(WordSlot));
+  if (!slots) {
+    fprintf(stderr, "Memory reallocation failed for WordTable!\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < nslots; i++) slots[i].idx = WORDTABLE_EMPTY;
+  size_t mask = nslots - 1;
+  for (size_t i = 0; i < table->size; i++) {
+    size_t pos = table->entries[i].hash & mask;
+    while (slots[pos].idx != WORDTABLE_EMPTY) pos = (pos + 1) & mask;
+    slots[pos].idx = (uint32_t)i;
+    slots[pos].tag = (uint32_t)(table->entries[i].hash >> 32);
+  }
+  free(table->slots);
+  table->slots = slots;
+  table->nslots = nslots;
+}
+
+// copies a key into the arena (NUL-terminated) and returns its offset
+static size_t wordtable_intern(WordTable* table, const char* key, size_t len) {
+  if (table->arena_size + len + 1 > table->arena_cap) {
+    size_t new_cap = table->arena_cap * 2;
+    while (table->arena_size + len + 1 > new_cap) new_cap *= 2;
+    char* arena = (char*)realloc(table->arena, new_cap);
+    if (!arena) {
+      fprintf(stderr, "Memory reallocation failed for WordTable arena!\n");
+      exit(EXIT_FAILURE);
+    }
+    table->arena = arena;
+    table->arena_cap = new_cap;
+  }
+  size_t offset = table->arena_size;
+  memcpy(table->arena + offset, key, len);
+  table->arena[offset + len] = '\0';
+  table->arena_size += len + 1;
+  return offset;
+}
+
+// adds `count` to a key whose hash is already known
+static void wordtable_add_hashed(WordTable* table, const char* key, size_t len, uint64_t h, uint64_t count) {
+  uint32_t tag = (uint32_t)(h >> 32);
+  size_t mask = table->nslots - 1;
+  size_t pos = h & mask;
+  while (table->slots[pos].idx != WORDTABLE_EMPTY) {
+    if (table->slots[pos].tag == tag) {
+      WordEntry* e = &table->entries[table->slots[pos].idx];
+      if (e->hash == h && e->len == len && memcmp(table->arena + e->offset, key, len) == 0) {
+        e->count += count;
+        return;
+      }
+    }
+    pos = (pos + 1) & mask;
+  }
+
+  if (table->size == table->cap) {
+    size_t new_cap = table->cap * 2;
+    WordEntry* entries = (WordEntry*)realloc(table->entries, new_cap * sizeof(WordEntry));
+    if (!entries) {
+      fprintf(stderr, "Memory reallocation failed for WordTable!\n");
+      exit(EXIT_FAILURE);
+    }
+    table->entries = entries;
+    table->cap = new_cap;
+  }
+  size_t idx = table->size++;
+  WordEntry* e = &table->entries[idx];
+  e->hash = h;
+  e->offset = wordtable_intern(table, key, len);
+  e->len = len;
+  e->count = count;
+  table->slots[pos].idx = (uint32_t)idx;
+  table->slots[pos].tag = tag;
+  if (table->size > table->nslots * WORDTABLE_MAX_LOAD) wordtable_grow_slots(table);
+}
+
+/**
+ @brief Add `count` occurrences of a (pointer, length) key, interning it if new.
+ * Keys are copied into the table's arena only on first insertion; lookups
+ * compare the cached hash and length before touching the key bytes.
+ @param table The word table
+ @param key Start of the key bytes (need not be NUL-terminated)
+ @param len Number of bytes in the key
+ @param count Occurrences to add
+*/
+void wordtable_add(WordTable* table, const char* key, size_t len, uint64_t count) {
+  if (!table) {
+    fprintf(stderr, "Pointer to WordTable not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  wordtable_add_hashed(table, key, len, hash_bytes(key, len), count);
+}
+
+// --- Add every word count of `src` into `dst`, following src's insertion order ---
+void wordtable_merge(WordTable* dst, const WordTable* src) {
+  for (size_t i = 0; i < src->size; i++) {
+    const WordEntry* e = &src->entries[i];
+    wordtable_add_hashed(dst, src->arena + e->offset, e->len, e->hash, e->count);
+  }
+}
+
+/**
+ @brief Iterate over all words in insertion order.
+ * @param table The word table
+ * @param func Callback(key, len, count, user) for each word
+ * @param user Passed through to callback
+*/
+void wordtable_iter(const WordTable* table, void(*func)(const char*, size_t, uint64_t, void*), void* user) {
+  for (size_t i = 0; i < table->size; i++) {
+    const WordEntry* e = &table->entries[i];
+    func(table->arena + e->offset, e->len, e->count, user);
+  }
+}
+
+// --- Free all resources held by the word table ---
+void wordtable_free(WordTable* table) {
+  if (!table) return;
+  free(table->slots);
+  free(table->entries);
+  free(table->arena);
+  table->slots = NULL;
+  table->entries = NULL;
+  table->arena = NULL;
+  table->nslots = table->size = table->cap = 0;
+  table->arena_size = table->arena_cap = 0;
+}
+
+// --- Initialize bigram info map, sized for roughly `capacity` pairs. ---
+void bimap_init(BIMap* map, size_t capacity) {
   if (!map) {
     fprintf(stderr, "Pointer to Map not found!\n");
     exit(EXIT_FAILURE);
   }
-  map->nbuckets = nbuckets;
-  map->buckets = (BIEntry**)calloc(nbuckets, sizeof(BIEntry*));
+  size_t nslots = 16;
+  while (nslots * BIMAP_MAX_LOAD < capacity) nslots <<= 1;
+  map->nslots = nslots;
+  map->slots = (BISlot*)malloc(nslots * sizeof(BISlot));
+  map->cap = capacity > 0 ? capacity : 16;
+  map->keys = (PairKey*)malloc(map->cap * sizeof(PairKey));
+  map->infos = (Info*)malloc(map->cap * sizeof(Info));
+  if (!map->slots || !map->keys || !map->infos) {
+    fprintf(stderr, "Memory allocation failed for bigram map!\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < nslots; i++) map->slots[i].idx = BIMAP_EMPTY;
+  map->size = 0;
 }
 
-// --- Retrieve or create an Info* for a given bigram key ---
+// doubles the probe table and reinserts every dense index
+static void bimap_grow_slots(BIMap* map) {
+  size_t nslots = map->nslots << 1;
+  BISlot* slots = (BISlot*)malloc(nslots * sizeof(BISlot));
+  if (!slots) {
+    fprintf(stderr, "Memory reallocation failed for bigram map!\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < nslots; i++) slots[i].idx = BIMAP_EMPTY;
+  size_t mask = nslots - 1;
+  for (size_t i = 0; i < map->nslots; i++) {
+    if (map->slots[i].idx == BIMAP_EMPTY) continue;
+    size_t pos = hash_pair(map->slots[i].key) & mask;
+    while (slots[pos].idx != BIMAP_EMPTY) pos = (pos + 1) & mask;
+    slots[pos] = map->slots[i];
+  }
+  free(map->slots);
+  map->slots = slots;
+  map->nslots = nslots;
+}
+
+/**
+ @brief Retrieve or create the Info for a given bigram key.
+ * New entries are zero-initialized. The probe table and the dense arrays grow
+ * on demand, so the returned pointer stays valid only until the next insertion.
+*/
 Info* bimap_get(BIMap* map, PairKey key) {
   if (!map) {
     fprintf(stderr, "Pointer to Map not found!\n");
     exit(EXIT_FAILURE);
   }
-  uint32_t h = hash_pair(key); 
-  size_t idx = h & (map->nbuckets - 1);
+  uint64_t packed = pair_pack(key);
+  size_t mask = map->nslots - 1;
+  size_t pos = hash_pair(packed) & mask;
+  while (map->slots[pos].idx != BIMAP_EMPTY) {
+    if (map->slots[pos].key == packed) return &map->infos[map->slots[pos].idx];
+    pos = (pos + 1) & mask;
+  }
 
-  // walk chain looking for existing entry
-  BIEntry **bucket = &map->buckets[idx];
-  while (*bucket) {
-    if ((*bucket)->key.first  == key.first &&
-        (*bucket)->key.second == key.second) {
-      return &(*bucket)->info;
+  // not found -> append to the dense arrays and claim the free slot
+  if (map->size == map->cap) {
+    size_t new_cap = map->cap * 2;
+    PairKey* keys = (PairKey*)realloc(map->keys, new_cap * sizeof(PairKey));
+    Info* infos = (Info*)realloc(map->infos, new_cap * sizeof(Info));
+    if (!keys || !infos) {
+      fprintf(stderr, "Memory reallocation failed for bigram map!\n");
+      exit(EXIT_FAILURE);
     }
-    bucket = &(*bucket)->next;
+    map->keys = keys;
+    map->infos = infos;
+    map->cap = new_cap;
   }
-
-  // not found -> allocate and link new entry
-  BIEntry *entry = (BIEntry*)calloc(1, sizeof(BIEntry));  // zeros all fields
-  entry->key.first = key.first;
-  entry->key.second = key.second;
-  entry->next = NULL;
-
-  *bucket = entry;
-  return &entry->info;
+  size_t idx = map->size++;
+  map->slots[pos].key = packed;
+  map->slots[pos].idx = (uint32_t)idx;
+  map->keys[idx] = key;
+  memset(&map->infos[idx], 0, sizeof(Info));
+  if (map->size > map->nslots * BIMAP_MAX_LOAD) bimap_grow_slots(map);
+  return &map->infos[idx];
 }
 
-// --- Return the current version for a key (0 if missing) ---
-uint32_t bimap_version(const BIMap* map, PairKey key) {
+// --- Look up the Info for a key without inserting (NULL if missing) ---
+Info* bimap_find(const BIMap* map, PairKey key) {
   if (!map) {
     fprintf(stderr, "Pointer to Map not found!\n");
     exit(EXIT_FAILURE);
   }
-  uint32_t h = hash_pair(key); 
-  size_t idx = h & (map->nbuckets - 1);
-  for (BIEntry *e = map->buckets[idx]; e; e = e->next) {
-    if (e->key.first == key.first && e->key.second == key.second)
-      return e->info.version;
+  uint64_t packed = pair_pack(key);
+  size_t mask = map->nslots - 1;
+  for (size_t pos = hash_pair(packed) & mask; map->slots[pos].idx != BIMAP_EMPTY; pos = (pos + 1) & mask) {
+    if (map->slots[pos].key == packed) return &map->infos[map->slots[pos].idx];
   }
-  return 0;
+  return NULL;
+}
+
+// --- Return the current version for a key (0 if missing) ---
+uint32_t bimap_version(const BIMap* map, PairKey key) {
+  const Info* info = bimap_find(map, key);
+  return info ? info->version : 0;
 }
 
 // --- Free all resources held by the bigram map. ---
 void bimap_free(BIMap *map) {
-  for (size_t i = 0; i < map->nbuckets; i++) {
-    BIEntry *e = map->buckets[i];
-    while (e) {
-      BIEntry *n = e->next;
-      free(e);
-      e = n;
+  if (!map) return;
+  for (size_t i = 0; i < map->size; i++) {
+    wordlist_free(&map->infos[i].words);
+  }
+  free(map->slots);
+  free(map->keys);
+  free(map->infos);
+  map->slots = NULL;
+  map->keys = NULL;
+  map->infos = NULL;
+  map->nslots = map->size = map->cap = 0;
+}
+
+/**
+ @brief Record that a pair occurs in the given word.
+ * Consecutive pushes of the same word are collapsed, so a word holding the
+ * pair several times is stored once. Entries are never removed when a pair
+ * disappears from a word; readers must tolerate such stale indices.
+ @param list Occurrence list of the pair.
+ @param word_index Index of the word in the corpus.
+*/
+void wordlist_push(WordList* list, size_t word_index) {
+  if (!list) {
+    fprintf(stderr, "Pointer to WordList not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  if (list->size > 0 && list->idx[list->size - 1] == word_index) return;
+  if (list->size == list->cap) {
+    size_t new_cap = list->cap ? list->cap * 2 : 4;
+    size_t* new_idx = (size_t*)realloc(list->idx, new_cap * sizeof(size_t));
+    if (!new_idx) {
+      fprintf(stderr, "Memory reallocation failed for WordList!\n");
+      exit(EXIT_FAILURE);
     }
+    list->idx = new_idx;
+    list->cap = new_cap;
   }
-  free(map->buckets);
-  map->buckets = NULL;
+  list->idx[list->size++] = word_index;
+}
+
+// --- Append all indices of `src` to `dst` (used to reduce per-thread lists in order). ---
+void wordlist_append(WordList* dst, const WordList* src) {
+  if (!dst || !src) {
+    fprintf(stderr, "Pointer to WordList not found!\n");
+    exit(EXIT_FAILURE);
+  }
+  if (src->size == 0) return;
+  if (dst->size + src->size > dst->cap) {
+    size_t new_cap = dst->cap ? dst->cap : 4;
+    while (new_cap < dst->size + src->size) new_cap *= 2;
+    size_t* new_idx = (size_t*)realloc(dst->idx, new_cap * sizeof(size_t));
+    if (!new_idx) {
+      fprintf(stderr, "Memory reallocation failed for WordList!\n");
+      exit(EXIT_FAILURE);
+    }
+    dst->idx = new_idx;
+    dst->cap = new_cap;
+  }
+  memcpy(dst->idx + dst->size, src->idx, src->size * sizeof(size_t));
+  dst->size += src->size;
+}
+
+// --- Free the indices held by an occurrence list. ---
+void wordlist_free(WordList* list) {
+  if (!list) return;
+  free(list->idx);
+  list->idx = NULL;
+  list->size = list->cap = 0;
 }
\ No newline at end of file
@@ -3,7 +3,8 @@
  @brief hasmap implementation for particularly training BPE merges
 
  * string -> int value hashmap, maintaining version info, etc.
- * separate hashing for Bigram related task.
+ * separate hashing for Bigram related task: an open-addressing table over packed
+   64-bit pair keys, with the pairs' Info stored densely in insertion order.
 */
 
 #ifndef __HASH_H__
@@ -12,9 +13,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include "arena.h"
 
 typedef struct StrEntry {
   char* key;  // string or character
+  size_t len;   // length of key in bytes
   uint64_t value;   // int64 value of its
   struct StrEntry* next;    // linked to the next pair
 } StrEntry;
@@ -22,40 +25,117 @@ typedef struct StrEntry {
 typedef struct StrMap {
   StrEntry** buckets;
   size_t nbuckets;
+  Arena* arena;   // if set, entries & keys are carved from it and released with it
 } StrMap;
 
+#define  WORDTABLE_EMPTY  0xFFFFFFFFu   // marks a free slot in the WordTable probe table
+#define  WORDTABLE_MAX_LOAD  0.7   // probe table grows beyond this fill ratio
+
+typedef struct WordEntry {
+  uint64_t hash;   // cached hash of the key bytes
+  size_t offset;   // key offset into the interning arena
+  size_t len;   // key length in bytes
+  uint64_t count;   // no of occurrences
+} WordEntry;
+
+typedef struct WordSlot {
+  uint32_t idx;   // index into `entries`, WORDTABLE_EMPTY when free
+  uint32_t tag;   // high hash bits, rejects most mismatches without touching the entry
+} WordSlot;
+
+typedef struct WordTable {
+  WordSlot* slots;   // open-addressing probe table (linear probing)
+  size_t nslots;   // probe table capacity, always a power of two
+  WordEntry* entries;   // dense entries, in insertion order
+  size_t size;   // no of unique words
+  size_t cap;   // capacity of `entries`
+  char* arena;   // interned key bytes, each key NUL-terminated
+  size_t arena_size;   // bytes used in the arena
+  size_t arena_cap;   // arena capacity
+} WordTable;
+
 typedef struct PairKey {
   int32_t first, second;
 } PairKey;
 
+typedef struct WordList {
+  size_t* idx;  // indices of words the pair occurs in (may hold stale entries)
+  size_t size;  // no of stored indices
+  size_t cap;   // allocation capacity
+} WordList;
+
 typedef struct Info {
   uint64_t freq;   // frequency of a particular pair
   uint32_t version;   // version for lazy validation
+  WordList words;   // occurrence index -> words containing this pair
 } Info;
 
-typedef struct BIEntry {
-  PairKey key;
-  Info info;
-  struct BIEntry *next;
-} BIEntry;
+#define  BIMAP_EMPTY  0xFFFFFFFFu   // marks a free slot in the BIMap probe table
+#define  BIMAP_MAX_LOAD  0.7   // probe table grows beyond this fill ratio
 
-typedef struct {
-  BIEntry **buckets;
-  size_t nbuckets;
+typedef struct BISlot {
+  uint64_t key;   // packed pair key, (first << 32) | second
+  uint32_t idx;   // index into the dense arrays, BIMAP_EMPTY when free
+} BISlot;
+
+typedef struct BIMap {
+  BISlot* slots;   // open-addressing probe table (linear probing)
+  size_t nslots;   // probe table capacity, always a power of two
+  PairKey* keys;   // dense pair keys, in insertion order
+  Info* infos;   // dense pair info, parallel to `keys`
+  size_t size;   // no of stored pairs
+  size_t cap;   // capacity of the dense arrays
 } BIMap;
 
+// key bytes of the i-th word, valid until the next insertion
+static inline const char* wordtable_key(const WordTable* table, size_t i) {
+  return table->arena + table->entries[i].offset;
+}
+
+// dense index of an Info inside the bigram map, stable for the map's lifetime
+static inline uint32_t bimap_slot(const BIMap* map, const Info* info) {
+  return (uint32_t)(info - map->infos);
+}
+
+// packs a pair into the 64-bit key used by the bigram map
+static inline uint64_t pair_pack(PairKey key) {
+  return ((uint64_t)(uint32_t)key.first << 32) | (uint64_t)(uint32_t)key.second;
+}
+
+// inverse of pair_pack
+static inline PairKey pair_unpack(uint64_t packed) {
+  PairKey key = {(int32_t)(uint32_t)(packed >> 32), (int32_t)(uint32_t)(packed & 0xFFFFFFFFu)};
+  return key;
+}
+
 extern "C" {
   // StrMap related functions ----
   void strmap_init(StrMap* map, size_t nbuckets);
   void strmap_increment(StrMap* map, const char* key);
+  void strmap_increment_n(StrMap* map, const char* key, size_t len);
+  void strmap_add_n(StrMap* map, const char* key, size_t len, uint64_t count);
+  void strmap_merge(StrMap* dst, StrMap* src);
   void strmap_iter(StrMap* map, void(*func)(const char*, uint64_t, void*), void* user);
   void strmap_free(StrMap* map);
 
+  // WordTable related functions ----
+  void wordtable_init(WordTable* table, size_t capacity);
+  void wordtable_add(WordTable* table, const char* key, size_t len, uint64_t count);
+  void wordtable_merge(WordTable* dst, const WordTable* src);
+  void wordtable_iter(const WordTable* table, void(*func)(const char*, size_t, uint64_t, void*), void* user);
+  void wordtable_free(WordTable* table);
+
   // BiGram Hash related functions ----
-  void bimap_init(BIMap *m, size_t nbuckets);
+  void bimap_init(BIMap *m, size_t capacity);
   Info* bimap_get(BIMap *m, PairKey key);
+  Info* bimap_find(const BIMap* m, PairKey key);
   uint32_t bimap_version(const BIMap* map, PairKey key);
   void bimap_free(BIMap *map);
+
+  // Pair occurrence index related functions ----
+  void wordlist_push(WordList* list, size_t word_index);
+  void wordlist_append(WordList* dst, const WordList* src);
+  void wordlist_free(WordList* list);
 }
 
 #endif
\ No newline at end of file
@@ -7,15 +7,64 @@
 #include "hash.h"
 
 /**
-  @brief Swap two heap entries in-place.
+  @brief Heap order: higher frequency first, ties go to the smaller packed pair key.
   * @param x  Pointer to the first entry.
   * @param y  Pointer to the second entry.
+  * @return Non-zero if `x` must sit above `y`.
  */
-static void he_swap(HeapEntry* x, HeapEntry* y) {
-  assert(x && y);
-  HeapEntry tmp = *x;
-  *x = *y;
-  *y = tmp;
+static inline int he_before(const HeapEntry* x, const HeapEntry* y) {
+  if (x->freq != y->freq) return x->freq > y->freq;
+  return pair_pack(x->key) < pair_pack(y->key);
+}
+
+/**
+  @brief Store an entry at `idx`, keeping the slot index in sync.
+  * @param h  Pointer to the heap.
+  * @param idx  Destination position in `data`.
+  * @param e  Entry to store.
+ */
+static inline void he_place(MaxHeap* h, size_t idx, const HeapEntry* e) {
+  h->data[idx] = *e;
+  if (h->pos && e->slot < h->pos_cap) h->pos[e->slot] = idx;
+}
+
+// moves the entry at idx towards the root until its parent comes before it
+static void he_sift_up(MaxHeap* h, size_t idx) {
+  HeapEntry e = h->data[idx];
+  while (idx > 0) {
+    size_t p = (idx - 1) >> 1;
+    if (!he_before(&e, &h->data[p])) break;
+    he_place(h, idx, &h->data[p]);
+    idx = p;
+  }
+  he_place(h, idx, &e);
+}
+
+// moves the entry at idx towards the leaves until both children come after it
+static void he_sift_down(MaxHeap* h, size_t idx) {
+  HeapEntry e = h->data[idx];
+  while (true) {
+    size_t left = (idx << 1) + 1, right = left + 1, best = left;
+    if (left >= h->size) break;
+    if (right < h->size && he_before(&h->data[right], &h->data[left])) best = right;
+    if (!he_before(&h->data[best], &e)) break;
+    he_place(h, idx, &h->data[best]);
+    idx = best;
+  }
+  he_place(h, idx, &e);
+}
+
+// grows the entry array when full
+static void he_reserve(MaxHeap* h) {
+  if (h->size < h->cap) return;
+  size_t new_cap = h->cap * 2;
+  HeapEntry* new_data = (HeapEntry*)realloc(h->data, sizeof(HeapEntry) * new_cap);
+  if (!new_data) {
+    fprintf(stderr, "Memory reallocation failed!\n");
+    exit(EXIT_FAILURE);
+  }
+  h->data = new_data;
+  h->cap = new_cap;
 }
 
 /**
@@ -40,6 +89,8 @@ void heap_init(MaxHeap* h, size_t capacity) {
   }
   h->size = 0;
   h->cap = capacity;
+  h->pos = NULL;
+  h->pos_cap = 0;
 }
 
 /**
@@ -55,28 +106,14 @@ void heap_push(MaxHeap* h, PairKey key, uint64_t freq, uint32_t version) {
     fprintf(stderr, "Error: Heap pointer is NULL.\n");
     exit(EXIT_FAILURE);
   }
-  // grow if needed
-  if (h->size == h->cap) {
-    size_t new_cap = h->cap * 2;
-    HeapEntry* new_data = (HeapEntry*)realloc(h->data, sizeof(HeapEntry) * new_cap);
-    if (!new_data) {
-      fprintf(stderr, "Memory reallocation failed!\n");
-      exit(EXIT_FAILURE);
-    }
-    h->data = new_data;
-    h->cap = new_cap;
-  }  
+  he_reserve(h);
   // insert at end and sift up
   size_t idx = h->size++;
   h->data[idx].key = key;
   h->data[idx].freq = freq;
   h->data[idx].version = version;
-  while (idx > 0) {
-    size_t p = (idx - 1) >> 1;
-    if (h->data[p].freq >= h->data[idx].freq) break;
-    he_swap(&h->data[p], &h->data[idx]);
-    idx = p;
-  }
+  h->data[idx].slot = HEAP_NO_SLOT;
+  he_sift_up(h, idx);
 }
 
 /**
@@ -95,21 +132,11 @@ HeapEntry heap_pop(MaxHeap* h) {
     exit(EXIT_FAILURE);
   }
   HeapEntry top = h->data[0];
-  h->data[0] = h->data[--h->size];
-
-  size_t idx = 0;
-  while (true) {
-    size_t left = (idx << 1) + 1, right = left + 1, best = idx;
-    if (left < h->size && h->data[left].freq > h->data[best].freq)
-      best = left;
-    if (right < h->size && h->data[right].freq > h->data[best].freq)
-      best = right;
-    if (best == idx)
-      break;
-    he_swap(&h->data[idx], &h->data[best]);
-    idx = best;
+  if (h->pos && top.slot < h->pos_cap) h->pos[top.slot] = HEAP_NO_POS;
+  if (--h->size > 0) {
+    he_place(h, 0, &h->data[h->size]);
+    he_sift_down(h, 0);
   }
-
   return top;
 }
 
@@ -136,6 +163,109 @@ void heap_free(MaxHeap* h) {
     exit(EXIT_FAILURE);
   }
   free(h->data);
+  free(h->pos);
   h->data = NULL;
-  h->size = h->cap = 0;
+  h->pos = NULL;
+  h->size = h->cap = h->pos_cap = 0;
+}
+
+// makes `pos` cover `slot`, marking new slots as absent
+static void he_reserve_slot(MaxHeap* h, uint32_t slot) {
+  if (slot < h->pos_cap) return;
+  size_t new_cap = h->pos_cap ? h->pos_cap : 1024;
+  while (new_cap <= slot) new_cap *= 2;
+  size_t* new_pos = (size_t*)realloc(h->pos, sizeof(size_t) * new_cap);
+  if (!new_pos) {
+    fprintf(stderr, "Memory reallocation failed for heap index!\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = h->pos_cap; i < new_cap; i++) new_pos[i] = HEAP_NO_POS;
+  h->pos = new_pos;
+  h->pos_cap = new_cap;
+}
+
+/**
+  @brief Insert a slot's entry, or change its frequency in place if already queued.
+  @param h Pointer to the heap.
+  @param slot Stable id owning the entry (e.g. the pair's BIMap index).
+  @param key Pair stored in the entry.
+  @param freq New frequency used for ordering.
+ */
+void heap_update(MaxHeap* h, uint32_t slot, PairKey key, uint64_t freq) {
+  if (h == NULL) {
+    fprintf(stderr, "Error: Heap pointer is NULL.\n");
+    exit(EXIT_FAILURE);
+  }
+  he_reserve_slot(h, slot);
+  size_t idx = h->pos[slot];
+  if (idx == HEAP_NO_POS) {
+    he_reserve(h);
+    idx = h->size++;
+    h->data[idx].key = key;
+    h->data[idx].freq = freq;
+    h->data[idx].version = 0;
+    h->data[idx].slot = slot;
+    h->pos[slot] = idx;
+    he_sift_up(h, idx);
+    return;
+  }
+  uint64_t old = h->data[idx].freq;
+  h->data[idx].freq = freq;
+  if (freq > old) he_sift_up(h, idx);
+  else if (freq < old) he_sift_down(h, idx);
+}
+
+/**
+  @brief Remove a slot's entry from the heap, if present.
+  @param h Pointer to the heap.
+  @param slot Stable id owning the entry.
+ */
+void heap_remove(MaxHeap* h, uint32_t slot) {
+  if (h == NULL) {
+    fprintf(stderr, "Error: Heap pointer is NULL.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (!heap_contains(h, slot)) return;
+  size_t idx = h->pos[slot];
+  h->pos[slot] = HEAP_NO_POS;
+  if (idx == --h->size) return;
+  he_place(h, idx, &h->data[h->size]);
+  if (idx > 0 && he_before(&h->data[idx], &h->data[(idx - 1) >> 1])) he_sift_up(h, idx);
+  else he_sift_down(h, idx);
+}
+
+// --- Check whether a slot currently has an entry in the heap ---
+int heap_contains(const MaxHeap* h, uint32_t slot) {
+  return h && h->pos && slot < h->pos_cap && h->pos[slot] != HEAP_NO_POS;
+}
+
+/**
+  @brief Replace the heap's contents with `entries` and heapify them bottom-up in O(n).
+  * Entries carrying a slot id (anything but HEAP_NO_SLOT) become addressable
+  * through `heap_update`/`heap_remove`, exactly as if they had been inserted one by one.
+  @param h Pointer to the heap.
+  @param entries Entries to load, copied into the heap.
+  @param n Number of entries.
+ */
+void heap_build(MaxHeap* h, const HeapEntry* entries, size_t n) {
+  if (h == NULL) {
+    fprintf(stderr, "Error: Heap pointer is NULL.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < h->pos_cap; i++) h->pos[i] = HEAP_NO_POS;
+  if (n > h->cap) {
+    HeapEntry* new_data = (HeapEntry*)realloc(h->data, sizeof(HeapEntry) * n);
+    if (!new_data) {
+      fprintf(stderr, "Memory reallocation failed!\n");
+      exit(EXIT_FAILURE);
+    }
+    h->data = new_data;
+    h->cap = n;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (entries[i].slot != HEAP_NO_SLOT) he_reserve_slot(h, entries[i].slot);
+  }
+  h->size = n;
+  for (size_t i = 0; i < n; i++) he_place(h, i, &entries[i]);
+  for (size_t i = n / 2; i-- > 0; ) he_sift_down(h, i);
 }
\ No newline at end of file
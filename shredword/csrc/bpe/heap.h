@@ -5,6 +5,14 @@
  * This heap is used in the BPE merge process to always pop the
  * highest‑frequency symbol pair. Keys are C‑strings (heap owns them),
  * and must be freed after use. 
+
+ * Two ways of using it:
+ * - lazy: `heap_push` a fresh entry on every change and drop stale ones by version.
+ * - indexed: every pair owns one slot id (e.g. its BIMap index); `heap_update`
+     and `heap_remove` change that slot's entry in place, so the heap never holds
+     more than one entry per live pair.
+ * Ties on frequency are broken by the smaller packed pair key, so the pop order
+   doesn't depend on the order of updates.
 */
 
 #ifndef __HEAP__H__
@@ -14,16 +22,22 @@
 #include <stddef.h>
 #include "hash.h"
 
+#define  HEAP_NO_SLOT  0xFFFFFFFFu   // slot id of entries added through `heap_push`
+#define  HEAP_NO_POS  ((size_t)-1)   // position of a slot that isn't in the heap
+
 typedef struct HeapEntry {
   PairKey key;
   uint64_t freq;
   uint32_t version;
+  uint32_t slot;   // owner slot id in indexed mode, HEAP_NO_SLOT otherwise
 } HeapEntry; // An entry in the heap
 
 typedef struct MaxHeap {
   HeapEntry* data;  // array of heap entries
   size_t size;   // current no of elements
   size_t cap;    // allocation capacity MaxHeap
+  size_t* pos;   // indexed mode: position of each slot in `data`, HEAP_NO_POS if absent
+  size_t pos_cap;   // no of slots covered by `pos`
 } MaxHeap;  // A simple max-heap over HeapEntry
 
 extern "C" {
@@ -33,6 +47,12 @@ extern "C" {
   HeapEntry heap_pop(MaxHeap* h); // removes & returns top
   int heap_empty(MaxHeap* h);
   void heap_free(MaxHeap* h);
+
+  // indexed (addressable) heap functions
+  void heap_update(MaxHeap* h, uint32_t slot, PairKey key, uint64_t freq);  // insert or re-prioritize in place
+  void heap_remove(MaxHeap* h, uint32_t slot);  // no-op if the slot isn't queued
+  int heap_contains(const MaxHeap* h, uint32_t slot);
+  void heap_build(MaxHeap* h, const HeapEntry* entries, size_t n);  // replaces contents, O(n) heapify
 }
 
 #endif  //!__HEAP__H__
\ No newline at end of file
@@ -4,32 +4,29 @@
 #include "bpe.h"
 #include "hash.h"
 
-void build_symbol_cb(const char* w, uint64_t count, void* u) {
+void build_symbol_cb(const char* w, size_t len, uint64_t count, void* u) {
   BuildCtx* ctx = (BuildCtx*)u;
   Trainer* trainer = ctx->trainer;
-  size_t pos = *(ctx->idx);
+  size_t idx = *(ctx->idx);
+  size_t pos = *(ctx->pos);
 
-  Symbol *head = NULL, *prev = NULL;
-  for (const unsigned char* p = (const unsigned char*)w; *p; ++p) {
-    Symbol* s = (Symbol*)malloc(sizeof(Symbol));
-    int32_t id = ctx->keep_char[*p] ? (int32_t)*p : trainer->config.unk_id;
-
-    s->id = id;
-    s->prev = prev;
-    s->next = NULL;
-    if (prev) prev->next = s;
-    else head = s;
-    prev = s;
+  int32_t* ids = trainer->corpus.symbols + pos;
+  const unsigned char* p = (const unsigned char*)w;
+  for (size_t i = 0; i < len; ++i) {
+    ids[i] = ctx->keep_char[p[i]] ? (int32_t)p[i] : trainer->config.unk_id;
   }
-  trainer->corpus.words[pos] = head;
-  trainer->corpus.word_counts[pos] = count;
+  trainer->corpus.offsets[idx] = pos;
+  trainer->corpus.lengths[idx] = (uint32_t)len;
+  trainer->corpus.word_counts[idx] = count;
+  *(ctx->pos) = pos + len;
   (*(ctx->idx))++;
 }
 
 // callback to build char histogram from each word
-void char_hist(const char* word, uint64_t wcount, void* u) {
+void char_hist(const char* word, size_t len, uint64_t wcount, void* u) {
   StrMap *cmap = (StrMap*)u;
-  for (const unsigned char *p = (const unsigned char*)word; *p; ++p) {
+  const unsigned char* end = (const unsigned char*)word + len;
+  for (const unsigned char *p = (const unsigned char*)word; p < end; ++p) {
     char tmp[2] = { (char)*p, 0 };
     strmap_increment(cmap, tmp);
   }
@@ -51,23 +48,3 @@ int charcount_cmp(const void *a, const void *b) {
   if (cb->count < ca->count) return -1;
   return 0;
 }
-
-// --- helper called for each (key, count) --- 
-void load_entry(const char* key, uint64_t val, void* user) {
-  struct load_ctx* ctx = (struct load_ctx*)user;
-  Symbol *head = NULL, *prev = NULL;
-  
-  // build linked list of raw bytes
-  for (const unsigned char* p = (const unsigned char*)key; *p; ++p) {
-    Symbol* s = (Symbol*)malloc(sizeof(Symbol));
-    s->id = (int32_t)*p;
-    s->prev = prev, s->next = NULL;
-    if (prev) prev->next = s;
-    else head = s;
-    prev = s;
-  }
-  // store into corpus
-  ctx->trainer->corpus.words[ctx->idx] = head;
-  ctx->trainer->corpus.word_counts[ctx->idx] = val;
-  ctx->idx++;
-}
\ No newline at end of file
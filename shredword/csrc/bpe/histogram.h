@@ -1,16 +1,16 @@
 /**
   @file histogram.h
-  @brief Histogram and symbol chain utilities for BPE training.
+  @brief Histogram and symbol construction utilities for BPE training.
   * This module handles preprocessing utilities required during corpus loading,
    including:
   * - Building a character-level histogram from the corpus to estimate which characters
      should be retained based on a configured character coverage threshold.
-  * - Generating a symbol chain (linked list of Symbol structs) for each word, using either
-     the original character ID or a fallback UNK token for rare characters.
+  * - Writing each word's symbols (a run of int32 ids in the corpus' contiguous buffer), using
+     either the original character ID or a fallback UNK token for rare characters.
   * - Sorting characters by frequency to determine inclusion into the vocabulary.
-  * - Providing helper callbacks for StrMap iteration (word frequency, character histogram, etc.).
+  * - Providing helper callbacks for WordTable/StrMap iteration (word frequency, character histogram, etc.).
 
-  * This file decouples symbol chain construction and histogram logic from the main trainer module,
+  * This file decouples symbol construction and histogram logic from the main trainer module,
   * making it easier to maintain and reuse for different subword algorithms.
 */
 
@@ -20,16 +20,11 @@
 #include "hash.h"
 
 typedef struct Trainer Trainer;   // forward declaration
-typedef struct Symbol Symbol;   // forward declaration
-
-struct load_ctx {
-  Trainer* trainer;
-  size_t idx;
-};
 
 typedef struct {
   Trainer* trainer;
-  size_t* idx;
+  size_t* idx;   // next word index
+  size_t* pos;   // next free slot in `corpus.symbols`
   bool* keep_char;
 } BuildCtx;
 
@@ -44,11 +39,10 @@ typedef struct {
 } CharCountCtx;
 
 extern "C" {
-  void build_symbol_cb(const char* w, uint64_t count, void* u);
-  void char_hist(const char* word, uint64_t wcount, void* u);
+  void build_symbol_cb(const char* w, size_t len, uint64_t count, void* u);
+  void char_hist(const char* word, size_t len, uint64_t wcount, void* u);
   void collect_char(const char* kc, uint64_t vc, void* u);
   int charcount_cmp(const void *a, const void *b);
-  void load_entry(const char* key, uint64_t val, void* user);
 }
 
 #endif  //!__HISTOGRAM__H__
\ No newline at end of file
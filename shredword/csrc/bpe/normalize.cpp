@@ -1,10 +1,10 @@
-#include <ctype.h>
 #include <string.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include "normalize.h"
+#include "scan.h"
 
 // UTF-8 sequence for U+2581 (▁)
 static const unsigned char u2581[] = {0xE2, 0x96, 0x81};
@@ -21,6 +21,16 @@ static inline int is_space_marker(const char* p) {
          (unsigned char)p[2] == 0x81;
 }
 
+// appends the space marker unless the last thing written was one; false if it doesn't fit
+static inline bool put_marker(char** out, char* out_end, int* in_space) {
+  if (*in_space) return true;
+  if (*out + 3 > out_end) return false;
+  memcpy(*out, u2581, 3);
+  *out += 3;
+  *in_space = 1;
+  return true;
+}
+
 int normalize_line(const char* input, char* output, size_t output_size) {
   if (!input || !output || output_size == 0) {
     return -1;
@@ -31,23 +41,44 @@ int normalize_line(const char* input, char* output, size_t output_size) {
   char* out_end = output + output_size - 1; // Reserve space for null terminator
   int in_space = 1; // Treat start as space
 
-  while (*in && out < out_end) {
-    if (is_whitespace(*in)) {
-      if (!in_space) {
-        // Check if we have space for the 3-byte UTF-8 sequence
-        if (out + 3 > out_end) {
-          break;
+  if (!scan_simd()) {
+    while (*in && out < out_end) {
+      if (is_whitespace(*in)) {
+        if (!put_marker(&out, out_end, &in_space)) break;
+      } else {
+        char c = *in;
+        *out++ = (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : c;
+        in_space = 0;
+      }
+      ++in;
+    }
+  } else {
+    // 64 bytes at a time: one whitespace mask & one lowercased copy per block, then runs are copied out
+    const char* in_end = input + strlen(input);
+    char lower[SCAN_BLOCK];
+    bool full = false;
+    while (in < in_end && !full) {
+      size_t n = (size_t)(in_end - in) < SCAN_BLOCK ? (size_t)(in_end - in) : SCAN_BLOCK;
+      uint64_t spaces = n == SCAN_BLOCK ? scan_kernels.delim_mask(in) : scan_delim_mask_tail(in, n);
+      scan_kernels.lower_copy(lower, in, n);
+      size_t i = 0;
+      while (i < n) {
+        uint64_t rest = spaces >> i;  // bits past n are set, so a run of non-whitespace ends by n
+        if (rest & 1) {
+          if (!put_marker(&out, out_end, &in_space)) { full = true; break; }
+          i += ~rest ? (size_t)scan_ctz64(~rest) : n - i;
+        } else {
+          size_t run = rest ? (size_t)scan_ctz64(rest) : n - i;
+          if (run > (size_t)(out_end - out)) { run = (size_t)(out_end - out); full = true; }
+          memcpy(out, lower + i, run);
+          out += run;
+          i += run;
+          in_space = 0;
+          if (full) break;
         }
-        *out++ = u2581[0];
-        *out++ = u2581[1];
-        *out++ = u2581[2];
-        in_space = 1;
       }
-    } else {
-      *out++ = tolower((unsigned char)*in);
-      in_space = 0;
+      in += n;
     }
-    ++in;
   }
   // removing trailing space symbol if present
   if (out >= output + 3 && is_space_marker(out - 3)) {
@@ -25,7 +25,7 @@ typedef struct VocabTable {
 } VocabTable;
 
 extern "C" {
-  // replaces all spaces with U+2581 (▁) and lowercases the string
+  // replaces all spaces with U+2581 (▁) and lowercases the string (ASCII letters, UTF-8 bytes are kept)
   // returns the length of the output string, or -1 on error
   int normalize_line(const char* input, char* output, size_t output_size);
   VocabTable* create_vocab(size_t initial_capacity);    // Fixed parameter type
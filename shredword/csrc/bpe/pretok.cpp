@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "reader.h"
+#include "pretok.h"
+#include "scan.h"
+
+typedef enum CharClass {
+  UC_OTHER = 0,   // punctuation, symbols, controls & invalid bytes
+  UC_LETTER,  // \p{L}
+  UC_NUMBER,  // \p{N}
+  UC_SPACE    // \s
+} CharClass;
+
+typedef struct ClassRange {
+  uint32_t first, last;
+  uint8_t cls;
+} ClassRange;
+
+// ASCII classes, indexed by byte
+static const uint8_t ascii_class[128] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 3, 3, 3, 0, 0,  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0
+};
+
+// non-ASCII letter, number & whitespace code points, sorted; anything outside is UC_OTHER
+// generated from the `regex` module's \p{L}, \p{N} & \s (the classes `apply_regex` sees)
+static const ClassRange class_ranges[] = {
+  {0x00085, 0x00085, UC_SPACE}, {0x000A0, 0x000A0, UC_SPACE}, {0x000AA, 0x000AA, UC_LETTER},
+  {0x000B2, 0x000B3, UC_NUMBER}, {0x000B5, 0x000B5, UC_LETTER}, {0x000B9, 0x000B9, UC_NUMBER},
+  {0x000BA, 0x000BA, UC_LETTER}, {0x000BC, 0x000BE, UC_NUMBER}, {0x000C0, 0x000D6, UC_LETTER},
+  {0x000D8, 0x000F6, UC_LETTER}, {0x000F8, 0x002C1, UC_LETTER}, {0x002C6, 0x002D1, UC_LETTER},
+  {0x002E0, 0x002E4, UC_LETTER}, {0x002EC, 0x002EC, UC_LETTER}, {0x002EE, 0x002EE, UC_LETTER},
+  {0x00370, 0x00374, UC_LETTER}, {0x00376, 0x00377, UC_LETTER}, {0x0037A, 0x0037D, UC_LETTER},
+  {0x0037F, 0x0037F, UC_LETTER}, {0x00386, 0x00386, UC_LETTER}, {0x00388, 0x0038A, UC_LETTER},
+  {0x0038C, 0x0038C, UC_LETTER}, {0x0038E, 0x003A1, UC_LETTER}, {0x003A3, 0x003F5, UC_LETTER},
+  {0x003F7, 0x00481, UC_LETTER}, {0x0048A, 0x0052F, UC_LETTER}, {0x00531, 0x00556, UC_LETTER},
+  {0x00558, 0x00559, UC_LETTER}, {0x00560, 0x00588, UC_LETTER}, {0x0058B, 0x0058C, UC_LETTER},
+  {0x005D0, 0x005EA, UC_LETTER}, {0x005EF, 0x005F2, UC_LETTER}, {0x00620, 0x0064A, UC_LETTER},
+  {0x00660, 0x00669, UC_NUMBER}, {0x0066E, 0x0066F, UC_LETTER}, {0x00671, 0x006D3, UC_LETTER},
+  {0x006D5, 0x006D5, UC_LETTER}, {0x006E5, 0x006E6, UC_LETTER}, {0x006EE, 0x006EF, UC_LETTER},
+  {0x006F0, 0x006F9, UC_NUMBER}, {0x006FA, 0x006FC, UC_LETTER}, {0x006FF, 0x006FF, UC_LETTER},
+  {0x00710, 0x00710, UC_LETTER}, {0x00712, 0x0072F, UC_LETTER}, {0x0074D, 0x007A5, UC_LETTER},
+  {0x007B1, 0x007B1, UC_LETTER}, {0x007C0, 0x007C9, UC_NUMBER}, {0x007CA, 0x007EA, UC_LETTER},
+  {0x007F4, 0x007F5, UC_LETTER}, {0x007FA, 0x007FA, UC_LETTER}, {0x00800, 0x00815, UC_LETTER},
+  {0x0081A, 0x0081A, UC_LETTER}, {0x00824, 0x00824, UC_LETTER}, {0x00828, 0x00828, UC_LETTER},
+  {0x00840, 0x00858, UC_LETTER}, {0x00860, 0x0086A, UC_LETTER}, {0x00870, 0x00887, UC_LETTER},
+  {0x00889, 0x0088F, UC_LETTER}, {0x008A0, 0x008C9, UC_LETTER}, {0x00904, 0x00939, UC_LETTER},
+  {0x0093D, 0x0093D, UC_LETTER}, {0x00950, 0x00950, UC_LETTER}, {0x00958, 0x00961, UC_LETTER},
+  {0x00966, 0x0096F, UC_NUMBER}, {0x00971, 0x00980, UC_LETTER}, {0x00985, 0x0098C, UC_LETTER},
+  {0x0098F, 0x00990, UC_LETTER}, {0x00993, 0x009A8, UC_LETTER}, {0x009AA, 0x009B0, UC_LETTER},
+  {0x009B2, 0x009B2, UC_LETTER}, {0x009B6, 0x009B9, UC_LETTER}, {0x009BD, 0x009BD, UC_LETTER},
+  {0x009CE, 0x009CE, UC_LETTER}, {0x009DC, 0x009DD, UC_LETTER}, {0x009DF, 0x009E1, UC_LETTER},
+  {0x009E6, 0x009EF, UC_NUMBER}, {0x009F0, 0x009F1, UC_LETTER}, {0x009F4, 0x009F9, UC_NUMBER},
+  {0x009FC, 0x009FC, UC_LETTER}, {0x00A05, 0x00A0A, UC_LETTER}, {0x00A0F, 0x00A10, UC_LETTER},
+  {0x00A13, 0x00A28, UC_LETTER}, {0x00A2A, 0x00A30, UC_LETTER}, {0x00A32, 0x00A33, UC_LETTER},
+  {0x00A35, 0x00A36, UC_LETTER}, {0x00A38, 0x00A39, UC_LETTER}, {0x00A59, 0x00A5C, UC_LETTER},
+  {0x00A5E, 0x00A5E, UC_LETTER}, {0x00A66, 0x00A6F, UC_NUMBER}, {0x00A72, 0x00A74, UC_LETTER},
+  {0x00A85, 0x00A8D, UC_LETTER}, {0x00A8F, 0x00A91, UC_LETTER}, {0x00A93, 0x00AA8, UC_LETTER},
+  {0x00AAA, 0x00AB0, UC_LETTER}, {0x00AB2, 0x00AB3, UC_LETTER}, {0x00AB5, 0x00AB9, UC_LETTER},
+  {0x00ABD, 0x00ABD, UC_LETTER}, {0x00AD0, 0x00AD0, UC_LETTER}, {0x00AE0, 0x00AE1, UC_LETTER},
+  {0x00AE6, 0x00AEF, UC_NUMBER}, {0x00AF9, 0x00AF9, UC_LETTER}, {0x00B05, 0x00B0C, UC_LETTER},
+  {0x00B0F, 0x00B10, UC_LETTER}, {0x00B13, 0x00B28, UC_LETTER}, {0x00B2A, 0x00B30, UC_LETTER},
+  {0x00B32, 0x00B33, UC_LETTER}, {0x00B35, 0x00B39, UC_LETTER}, {0x00B3D, 0x00B3D, UC_LETTER},
+  {0x00B5C, 0x00B5D, UC_LETTER}, {0x00B5F, 0x00B61, UC_LETTER}, {0x00B66, 0x00B6F, UC_NUMBER},
+  {0x00B71, 0x00B71, UC_LETTER}, {0x00B72, 0x00B77, UC_NUMBER}, {0x00B83, 0x00B83, UC_LETTER},
+  {0x00B85, 0x00B8A, UC_LETTER}, {0x00B8E, 0x00B90, UC_LETTER}, {0x00B92, 0x00B95, UC_LETTER},
+  {0x00B99, 0x00B9A, UC_LETTER}, {0x00B9C, 0x00B9C, UC_LETTER}, {0x00B9E, 0x00B9F, UC_LETTER},
+  {0x00BA3, 0x00BA4, UC_LETTER}, {0x00BA8, 0x00BAA, UC_LETTER}, {0x00BAE, 0x00BB9, UC_LETTER},
+  {0x00BD0, 0x00BD0, UC_LETTER}, {0x00BE6, 0x00BF2, UC_NUMBER}, {0x00C05, 0x00C0C, UC_LETTER},
+  {0x00C0E, 0x00C10, UC_LETTER}, {0x00C12, 0x00C28, UC_LETTER}, {0x00C2A, 0x00C39, UC_LETTER},
+  {0x00C3D, 0x00C3D, UC_LETTER}, {0x00C58, 0x00C5A, UC_LETTER}, {0x00C5C, 0x00C5D, UC_LETTER},
+  {0x00C60, 0x00C61, UC_LETTER}, {0x00C66, 0x00C6F, UC_NUMBER}, {0x00C78, 0x00C7E, UC_NUMBER},
+  {0x00C80, 0x00C80, UC_LETTER}, {0x00C85, 0x00C8C, UC_LETTER}, {0x00C8E, 0x00C90, UC_LETTER},
+  {0x00C92, 0x00CA8, UC_LETTER}, {0x00CAA, 0x00CB3, UC_LETTER}, {0x00CB5, 0x00CB9, UC_LETTER},
+  {0x00CBD, 0x00CBD, UC_LETTER}, {0x00CDC, 0x00CDE, UC_LETTER}, {0x00CE0, 0x00CE1, UC_LETTER},
+  {0x00CE6, 0x00CEF, UC_NUMBER}, {0x00CF1, 0x00CF2, UC_LETTER}, {0x00D04, 0x00D0C, UC_LETTER},
+  {0x00D0E, 0x00D10, UC_LETTER}, {0x00D12, 0x00D3A, UC_LETTER}, {0x00D3D, 0x00D3D, UC_LETTER},
+  {0x00D4E, 0x00D4E, UC_LETTER}, {0x00D54, 0x00D56, UC_LETTER}, {0x00D58, 0x00D5E, UC_NUMBER},
+  {0x00D5F, 0x00D61, UC_LETTER}, {0x00D66, 0x00D78, UC_NUMBER}, {0x00D7A, 0x00D7F, UC_LETTER},
+  {0x00D85, 0x00D96, UC_LETTER}, {0x00D9A, 0x00DB1, UC_LETTER}, {0x00DB3, 0x00DBB, UC_LETTER},
+  {0x00DBD, 0x00DBD, UC_LETTER}, {0x00DC0, 0x00DC6, UC_LETTER}, {0x00DE6, 0x00DEF, UC_NUMBER},
+  {0x00E01, 0x00E30, UC_LETTER}, {0x00E32, 0x00E33, UC_LETTER}, {0x00E40, 0x00E46, UC_LETTER},
+  {0x00E50, 0x00E59, UC_NUMBER}, {0x00E81, 0x00E82, UC_LETTER}, {0x00E84, 0x00E84, UC_LETTER},
+  {0x00E86, 0x00E8A, UC_LETTER}, {0x00E8C, 0x00EA3, UC_LETTER}, {0x00EA5, 0x00EA5, UC_LETTER},
+  {0x00EA7, 0x00EB0, UC_LETTER}, {0x00EB2, 0x00EB3, UC_LETTER}, {0x00EBD, 0x00EBD, UC_LETTER},
+  {0x00EC0, 0x00EC4, UC_LETTER}, {0x00EC6, 0x00EC6, UC_LETTER}, {0x00ED0, 0x00ED9, UC_NUMBER},
+  {0x00EDC, 0x00EDF, UC_LETTER}, {0x00F00, 0x00F00, UC_LETTER}, {0x00F20, 0x00F33, UC_NUMBER},
+  {0x00F40, 0x00F47, UC_LETTER}, {0x00F49, 0x00F6C, UC_LETTER}, {0x00F88, 0x00F8C, UC_LETTER},
+  {0x01000, 0x0102A, UC_LETTER}, {0x0103F, 0x0103F, UC_LETTER}, {0x01040, 0x01049, UC_NUMBER},
+  {0x01050, 0x01055, UC_LETTER}, {0x0105A, 0x0105D, UC_LETTER}, {0x01061, 0x01061, UC_LETTER},
+  {0x01065, 0x01066, UC_LETTER}, {0x0106E, 0x01070, UC_LETTER}, {0x01075, 0x01081, UC_LETTER},
+  {0x0108E, 0x0108E, UC_LETTER}, {0x01090, 0x01099, UC_NUMBER}, {0x010A0, 0x010C5, UC_LETTER},
+  {0x010C7, 0x010C7, UC_LETTER}, {0x010CD, 0x010CD, UC_LETTER}, {0x010D0, 0x010FA, UC_LETTER},
+  {0x010FC, 0x01248, UC_LETTER}, {0x0124A, 0x0124D, UC_LETTER}, {0x01250, 0x01256, UC_LETTER},
+  {0x01258, 0x01258, UC_LETTER}, {0x0125A, 0x0125D, UC_LETTER}, {0x01260, 0x01288, UC_LETTER},
+  {0x0128A, 0x0128D, UC_LETTER}, {0x01290, 0x012B0, UC_LETTER}, {0x012B2, 0x012B5, UC_LETTER},
+  {0x012B8, 0x012BE, UC_LETTER}, {0x012C0, 0x012C0, UC_LETTER}, {0x012C2, 0x012C5, UC_LETTER},
+  {0x012C8, 0x012D6, UC_LETTER}, {0x012D8, 0x01310, UC_LETTER}, {0x01312, 0x01315, UC_LETTER},
+  {0x01318, 0x0135A, UC_LETTER}, {0x01369, 0x0137C, UC_NUMBER}, {0x01380, 0x0138F, UC_LETTER},
+  {0x013A0, 0x013F5, UC_LETTER}, {0x013F8, 0x013FD, UC_LETTER}, {0x01401, 0x0166C, UC_LETTER},
+  {0x0166F, 0x0167F, UC_LETTER}, {0x01680, 0x01680, UC_SPACE}, {0x01681, 0x0169A, UC_LETTER},
+  {0x016A0, 0x016EA, UC_LETTER}, {0x016EE, 0x016F0, UC_NUMBER}, {0x016F1, 0x016F8, UC_LETTER},
+  {0x01700, 0x01711, UC_LETTER}, {0x0171F, 0x01731, UC_LETTER}, {0x01740, 0x01751, UC_LETTER},
+  {0x01760, 0x0176C, UC_LETTER}, {0x0176E, 0x01770, UC_LETTER}, {0x01780, 0x017B3, UC_LETTER},
+  {0x017D7, 0x017D7, UC_LETTER}, {0x017DC, 0x017DC, UC_LETTER}, {0x017E0, 0x017E9, UC_NUMBER},
+  {0x017F0, 0x017F9, UC_NUMBER}, {0x01810, 0x01819, UC_NUMBER}, {0x01820, 0x01878, UC_LETTER},
+  {0x01880, 0x01884, UC_LETTER}, {0x01887, 0x018A8, UC_LETTER}, {0x018AA, 0x018AA, UC_LETTER},
+  {0x018B0, 0x018F5, UC_LETTER}, {0x01900, 0x0191E, UC_LETTER}, {0x01946, 0x0194F, UC_NUMBER},
+  {0x01950, 0x0196D, UC_LETTER}, {0x01970, 0x01974, UC_LETTER}, {0x01980, 0x019AB, UC_LETTER},
+  {0x019B0, 0x019C9, UC_LETTER}, {0x019D0, 0x019DA, UC_NUMBER}, {0x01A00, 0x01A16, UC_LETTER},
+  {0x01A20, 0x01A54, UC_LETTER}, {0x01A80, 0x01A89, UC_NUMBER}, {0x01A90, 0x01A99, UC_NUMBER},
+  {0x01AA7, 0x01AA7, UC_LETTER}, {0x01B05, 0x01B33, UC_LETTER}, {0x01B45, 0x01B4C, UC_LETTER},
+  {0x01B50, 0x01B59, UC_NUMBER}, {0x01B83, 0x01BA0, UC_LETTER}, {0x01BAE, 0x01BAF, UC_LETTER},
+  {0x01BB0, 0x01BB9, UC_NUMBER}, {0x01BBA, 0x01BE5, UC_LETTER}, {0x01C00, 0x01C23, UC_LETTER},
+  {0x01C40, 0x01C49, UC_NUMBER}, {0x01C4D, 0x01C4F, UC_LETTER}, {0x01C50, 0x01C59, UC_NUMBER},
+  {0x01C5A, 0x01C7D, UC_LETTER}, {0x01C80, 0x01C8A, UC_LETTER}, {0x01C90, 0x01CBA, UC_LETTER},
+  {0x01CBD, 0x01CBF, UC_LETTER}, {0x01CE9, 0x01CEC, UC_LETTER}, {0x01CEE, 0x01CF3, UC_LETTER},
+  {0x01CF5, 0x01CF6, UC_LETTER}, {0x01CFA, 0x01CFA, UC_LETTER}, {0x01D00, 0x01DBF, UC_LETTER},
+  {0x01E00, 0x01F15, UC_LETTER}, {0x01F18, 0x01F1D, UC_LETTER}, {0x01F20, 0x01F45, UC_LETTER},
+  {0x01F48, 0x01F4D, UC_LETTER}, {0x01F50, 0x01F57, UC_LETTER}, {0x01F59, 0x01F59, UC_LETTER},
+  {0x01F5B, 0x01F5B, UC_LETTER}, {0x01F5D, 0x01F5D, UC_LETTER}, {0x01F5F, 0x01F7D, UC_LETTER},
+  {0x01F80, 0x01FB4, UC_LETTER}, {0x01FB6, 0x01FBC, UC_LETTER}, {0x01FBE, 0x01FBE, UC_LETTER},
+  {0x01FC2, 0x01FC4, UC_LETTER}, {0x01FC6, 0x01FCC, UC_LETTER}, {0x01FD0, 0x01FD3, UC_LETTER},
+  {0x01FD6, 0x01FDB, UC_LETTER}, {0x01FE0, 0x01FEC, UC_LETTER}, {0x01FF2, 0x01FF4, UC_LETTER},
+  {0x01FF6, 0x01FFC, UC_LETTER}, {0x02000, 0x0200A, UC_SPACE}, {0x02028, 0x02029, UC_SPACE},
+  {0x0202F, 0x0202F, UC_SPACE}, {0x0205F, 0x0205F, UC_SPACE}, {0x02070, 0x02070, UC_NUMBER},
+  {0x02071, 0x02071, UC_LETTER}, {0x02074, 0x02079, UC_NUMBER}, {0x0207F, 0x0207F, UC_LETTER},
+  {0x02080, 0x02089, UC_NUMBER}, {0x0208F, 0x0209F, UC_LETTER}, {0x02102, 0x02102, UC_LETTER},
+  {0x02107, 0x02107, UC_LETTER}, {0x0210A, 0x02113, UC_LETTER}, {0x02115, 0x02115, UC_LETTER},
+  {0x02119, 0x0211D, UC_LETTER}, {0x02124, 0x02124, UC_LETTER}, {0x02126, 0x02126, UC_LETTER},
+  {0x02128, 0x02128, UC_LETTER}, {0x0212A, 0x0212D, UC_LETTER}, {0x0212F, 0x02139, UC_LETTER},
+  {0x0213C, 0x0213F, UC_LETTER}, {0x02145, 0x02149, UC_LETTER}, {0x0214E, 0x0214E, UC_LETTER},
+  {0x02150, 0x02182, UC_NUMBER}, {0x02183, 0x02184, UC_LETTER}, {0x02185, 0x02189, UC_NUMBER},
+  {0x02460, 0x0249B, UC_NUMBER}, {0x024EA, 0x024FF, UC_NUMBER}, {0x02776, 0x02793, UC_NUMBER},
+  {0x02C00, 0x02CE4, UC_LETTER}, {0x02CEB, 0x02CEE, UC_LETTER}, {0x02CF2, 0x02CF3, UC_LETTER},
+  {0x02CFD, 0x02CFD, UC_NUMBER}, {0x02D00, 0x02D25, UC_LETTER}, {0x02D27, 0x02D27, UC_LETTER},
+  {0x02D2D, 0x02D2D, UC_LETTER}, {0x02D30, 0x02D67, UC_LETTER}, {0x02D6F, 0x02D6F, UC_LETTER},
+  {0x02D80, 0x02D96, UC_LETTER}, {0x02DA0, 0x02DA6, UC_LETTER}, {0x02DA8, 0x02DAE, UC_LETTER},
+  {0x02DB0, 0x02DB6, UC_LETTER}, {0x02DB8, 0x02DBE, UC_LETTER}, {0x02DC0, 0x02DC6, UC_LETTER},
+  {0x02DC8, 0x02DCE, UC_LETTER}, {0x02DD0, 0x02DD6, UC_LETTER}, {0x02DD8, 0x02DDE, UC_LETTER},
+  {0x02E2F, 0x02E2F, UC_LETTER}, {0x03000, 0x03000, UC_SPACE}, {0x03005, 0x03006, UC_LETTER},
+  {0x03007, 0x03007, UC_NUMBER}, {0x03021, 0x03029, UC_NUMBER}, {0x03031, 0x03035, UC_LETTER},
+  {0x03038, 0x0303A, UC_NUMBER}, {0x0303B, 0x0303C, UC_LETTER}, {0x03041, 0x03096, UC_LETTER},
+  {0x0309D, 0x0309F, UC_LETTER}, {0x030A1, 0x030FA, UC_LETTER}, {0x030FC, 0x030FF, UC_LETTER},
+  {0x03105, 0x0312F, UC_LETTER}, {0x03131, 0x0318E, UC_LETTER}, {0x03192, 0x03195, UC_NUMBER},
+  {0x031A0, 0x031BF, UC_LETTER}, {0x031F0, 0x031FF, UC_LETTER}, {0x03220, 0x03229, UC_NUMBER},
+  {0x03248, 0x0324F, UC_NUMBER}, {0x03251, 0x0325F, UC_NUMBER}, {0x03280, 0x03289, UC_NUMBER},
+  {0x032B1, 0x032BF, UC_NUMBER}, {0x03400, 0x04DBF, UC_LETTER}, {0x04E00, 0x0A48C, UC_LETTER},
+  {0x0A4D0, 0x0A4FD, UC_LETTER}, {0x0A500, 0x0A60C, UC_LETTER}, {0x0A610, 0x0A61F, UC_LETTER},
+  {0x0A620, 0x0A629, UC_NUMBER}, {0x0A62A, 0x0A62B, UC_LETTER}, {0x0A640, 0x0A66E, UC_LETTER},
+  {0x0A67F, 0x0A69D, UC_LETTER}, {0x0A6A0, 0x0A6E5, UC_LETTER}, {0x0A6E6, 0x0A6EF, UC_NUMBER},
+  {0x0A717, 0x0A71F, UC_LETTER}, {0x0A722, 0x0A788, UC_LETTER}, {0x0A78B, 0x0A7DD, UC_LETTER},
+  {0x0A7E2, 0x0A7E2, UC_LETTER}, {0x0A7F1, 0x0A801, UC_LETTER}, {0x0A803, 0x0A805, UC_LETTER},
+  {0x0A807, 0x0A80A, UC_LETTER}, {0x0A80C, 0x0A822, UC_LETTER}, {0x0A830, 0x0A835, UC_NUMBER},
+  {0x0A840, 0x0A873, UC_LETTER}, {0x0A882, 0x0A8B3, UC_LETTER}, {0x0A8D0, 0x0A8D9, UC_NUMBER},
+  {0x0A8F2, 0x0A8F7, UC_LETTER}, {0x0A8FB, 0x0A8FB, UC_LETTER}, {0x0A8FD, 0x0A8FE, UC_LETTER},
+  {0x0A900, 0x0A909, UC_NUMBER}, {0x0A90A, 0x0A925, UC_LETTER}, {0x0A930, 0x0A946, UC_LETTER},
+  {0x0A960, 0x0A97C, UC_LETTER}, {0x0A984, 0x0A9B2, UC_LETTER}, {0x0A9CF, 0x0A9CF, UC_LETTER},
+  {0x0A9D0, 0x0A9D9, UC_NUMBER}, {0x0A9E0, 0x0A9E4, UC_LETTER}, {0x0A9E6, 0x0A9EF, UC_LETTER},
+  {0x0A9F0, 0x0A9F9, UC_NUMBER}, {0x0A9FA, 0x0A9FE, UC_LETTER}, {0x0AA00, 0x0AA28, UC_LETTER},
+  {0x0AA40, 0x0AA42, UC_LETTER}, {0x0AA44, 0x0AA4B, UC_LETTER}, {0x0AA50, 0x0AA59, UC_NUMBER},
+  {0x0AA60, 0x0AA76, UC_LETTER}, {0x0AA7A, 0x0AA7A, UC_LETTER}, {0x0AA7E, 0x0AAAF, UC_LETTER},
+  {0x0AAB1, 0x0AAB1, UC_LETTER}, {0x0AAB5, 0x0AAB6, UC_LETTER}, {0x0AAB9, 0x0AABD, UC_LETTER},
+  {0x0AAC0, 0x0AAC0, UC_LETTER}, {0x0AAC2, 0x0AAC2, UC_LETTER}, {0x0AADB, 0x0AADD, UC_LETTER},
+  {0x0AAE0, 0x0AAEA, UC_LETTER}, {0x0AAF2, 0x0AAF4, UC_LETTER}, {0x0AB01, 0x0AB06, UC_LETTER},
+  {0x0AB09, 0x0AB0E, UC_LETTER}, {0x0AB11, 0x0AB16, UC_LETTER}, {0x0AB20, 0x0AB26, UC_LETTER},
+  {0x0AB28, 0x0AB2E, UC_LETTER}, {0x0AB30, 0x0AB5A, UC_LETTER}, {0x0AB5C, 0x0AB69, UC_LETTER},
+  {0x0AB6C, 0x0AB6D, UC_LETTER}, {0x0AB70, 0x0ABE2, UC_LETTER}, {0x0ABF0, 0x0ABF9, UC_NUMBER},
+  {0x0AC00, 0x0D7A3, UC_LETTER}, {0x0D7B0, 0x0D7C6, UC_LETTER}, {0x0D7CB, 0x0D7FB, UC_LETTER},
+  {0x0F900, 0x0FA6D, UC_LETTER}, {0x0FA70, 0x0FAD9, UC_LETTER}, {0x0FB00, 0x0FB06, UC_LETTER},
+  {0x0FB13, 0x0FB17, UC_LETTER}, {0x0FB1D, 0x0FB1D, UC_LETTER}, {0x0FB1F, 0x0FB28, UC_LETTER},
+  {0x0FB2A, 0x0FB36, UC_LETTER}, {0x0FB38, 0x0FB3C, UC_LETTER}, {0x0FB3E, 0x0FB3E, UC_LETTER},
+  {0x0FB40, 0x0FB41, UC_LETTER}, {0x0FB43, 0x0FB44, UC_LETTER}, {0x0FB46, 0x0FBB1, UC_LETTER},
+  {0x0FBD3, 0x0FD3D, UC_LETTER}, {0x0FD50, 0x0FD8F, UC_LETTER}, {0x0FD92, 0x0FDC7, UC_LETTER},
+  {0x0FDF0, 0x0FDFB, UC_LETTER}, {0x0FE70, 0x0FE74, UC_LETTER}, {0x0FE76, 0x0FEFC, UC_LETTER},
+  {0x0FF10, 0x0FF19, UC_NUMBER}, {0x0FF21, 0x0FF3A, UC_LETTER}, {0x0FF41, 0x0FF5A, UC_LETTER},
+  {0x0FF66, 0x0FFBE, UC_LETTER}, {0x0FFC2, 0x0FFC7, UC_LETTER}, {0x0FFCA, 0x0FFCF, UC_LETTER},
+  {0x0FFD2, 0x0FFD7, UC_LETTER}, {0x0FFDA, 0x0FFDC, UC_LETTER}, {0x10000, 0x1000B, UC_LETTER},
+  {0x1000D, 0x10026, UC_LETTER}, {0x10028, 0x1003A, UC_LETTER}, {0x1003C, 0x1003D, UC_LETTER},
+  {0x1003F, 0x1004D, UC_LETTER}, {0x10050, 0x1005D, UC_LETTER}, {0x10080, 0x100FA, UC_LETTER},
+  {0x10107, 0x10133, UC_NUMBER}, {0x10140, 0x10178, UC_NUMBER}, {0x1018A, 0x1018B, UC_NUMBER},
+  {0x10280, 0x1029C, UC_LETTER}, {0x102A0, 0x102D0, UC_LETTER}, {0x102E1, 0x102FB, UC_NUMBER},
+  {0x10300, 0x1031F, UC_LETTER}, {0x10320, 0x10323, UC_NUMBER}, {0x1032D, 0x10340, UC_LETTER},
+  {0x10341, 0x10341, UC_NUMBER}, {0x10342, 0x10349, UC_LETTER}, {0x1034A, 0x1034A, UC_NUMBER},
+  {0x10350, 0x10375, UC_LETTER}, {0x10380, 0x1039D, UC_LETTER}, {0x103A0, 0x103C3, UC_LETTER},
+  {0x103C8, 0x103CF, UC_LETTER}, {0x103D1, 0x103D5, UC_NUMBER}, {0x10400, 0x1049D, UC_LETTER},
+  {0x104A0, 0x104A9, UC_NUMBER}, {0x104B0, 0x104D3, UC_LETTER}, {0x104D8, 0x104FB, UC_LETTER},
+  {0x10500, 0x10527, UC_LETTER}, {0x10530, 0x10563, UC_LETTER}, {0x10570, 0x1057A, UC_LETTER},
+  {0x1057C, 0x1058A, UC_LETTER}, {0x1058C, 0x10592, UC_LETTER}, {0x10594, 0x10595, UC_LETTER},
+  {0x10597, 0x105A1, UC_LETTER}, {0x105A3, 0x105B1, UC_LETTER}, {0x105B3, 0x105B9, UC_LETTER},
+  {0x105BB, 0x105BC, UC_LETTER}, {0x105C0, 0x105F3, UC_LETTER}, {0x10600, 0x10736, UC_LETTER},
+  {0x10740, 0x10755, UC_LETTER}, {0x10760, 0x10767, UC_LETTER}, {0x10780, 0x10785, UC_LETTER},
+  {0x10787, 0x107B0, UC_LETTER}, {0x107B2, 0x107BF, UC_LETTER}, {0x10800, 0x10805, UC_LETTER},
+  {0x10808, 0x10808, UC_LETTER}, {0x1080A, 0x10835, UC_LETTER}, {0x10837, 0x10838, UC_LETTER},
+  {0x1083C, 0x1083C, UC_LETTER}, {0x1083F, 0x10855, UC_LETTER}, {0x10858, 0x1085F, UC_NUMBER},
+  {0x10860, 0x10876, UC_LETTER}, {0x10879, 0x1087F, UC_NUMBER}, {0x10880, 0x1089E, UC_LETTER},
+  {0x108A7, 0x108AF, UC_NUMBER}, {0x108E0, 0x108F2, UC_LETTER}, {0x108F4, 0x108F5, UC_LETTER},
+  {0x108FB, 0x108FF, UC_NUMBER}, {0x10900, 0x10915, UC_LETTER}, {0x10916, 0x1091B, UC_NUMBER},
+  {0x10920, 0x10939, UC_LETTER}, {0x10940, 0x10959, UC_LETTER}, {0x10980, 0x109B7, UC_LETTER},
+  {0x109BC, 0x109BD, UC_NUMBER}, {0x109BE, 0x109BF, UC_LETTER}, {0x109C0, 0x109CF, UC_NUMBER},
+  {0x109D2, 0x109FF, UC_NUMBER}, {0x10A00, 0x10A00, UC_LETTER}, {0x10A10, 0x10A13, UC_LETTER},
+  {0x10A15, 0x10A17, UC_LETTER}, {0x10A19, 0x10A35, UC_LETTER}, {0x10A40, 0x10A48, UC_NUMBER},
+  {0x10A60, 0x10A7C, UC_LETTER}, {0x10A7D, 0x10A7E, UC_NUMBER}, {0x10A80, 0x10A9C, UC_LETTER},
+  {0x10A9D, 0x10A9F, UC_NUMBER}, {0x10AC0, 0x10AC7, UC_LETTER}, {0x10AC9, 0x10AE4, UC_LETTER},
+  {0x10AEB, 0x10AEF, UC_NUMBER}, {0x10B00, 0x10B35, UC_LETTER}, {0x10B40, 0x10B55, UC_LETTER},
+  {0x10B58, 0x10B5F, UC_NUMBER}, {0x10B60, 0x10B72, UC_LETTER}, {0x10B78, 0x10B7F, UC_NUMBER},
+  {0x10B80, 0x10B91, UC_LETTER}, {0x10BA9, 0x10BAF, UC_NUMBER}, {0x10C00, 0x10C48, UC_LETTER},
+  {0x10C80, 0x10CB2, UC_LETTER}, {0x10CC0, 0x10CF2, UC_LETTER}, {0x10CFA, 0x10CFF, UC_NUMBER},
+  {0x10D00, 0x10D23, UC_LETTER}, {0x10D30, 0x10D39, UC_NUMBER}, {0x10D40, 0x10D49, UC_NUMBER},
+  {0x10D4A, 0x10D65, UC_LETTER}, {0x10D6F, 0x10D85, UC_LETTER}, {0x10E60, 0x10E7E, UC_NUMBER},
+  {0x10E80, 0x10EA9, UC_LETTER}, {0x10EB0, 0x10EB1, UC_LETTER}, {0x10EC2, 0x10EC7, UC_LETTER},
+  {0x10ED9, 0x10EEE, UC_LETTER}, {0x10F00, 0x10F1C, UC_LETTER}, {0x10F1D, 0x10F26, UC_NUMBER},
+  {0x10F27, 0x10F27, UC_LETTER}, {0x10F30, 0x10F45, UC_LETTER}, {0x10F51, 0x10F54, UC_NUMBER},
+  {0x10F70, 0x10F81, UC_LETTER}, {0x10FB0, 0x10FC4, UC_LETTER}, {0x10FC5, 0x10FCB, UC_NUMBER},
+  {0x10FE0, 0x10FF6, UC_LETTER}, {0x11003, 0x11037, UC_LETTER}, {0x11052, 0x1106F, UC_NUMBER},
+  {0x11071, 0x11072, UC_LETTER}, {0x11075, 0x11075, UC_LETTER}, {0x11083, 0x110AF, UC_LETTER},
+  {0x110D0, 0x110E8, UC_LETTER}, {0x110F0, 0x110F9, UC_NUMBER}, {0x11103, 0x11126, UC_LETTER},
+  {0x11136, 0x1113F, UC_NUMBER}, {0x11144, 0x11144, UC_LETTER}, {0x11147, 0x11147, UC_LETTER},
+  {0x11150, 0x11172, UC_LETTER}, {0x11176, 0x11176, UC_LETTER}, {0x11183, 0x111B2, UC_LETTER},
+  {0x111C1, 0x111C4, UC_LETTER}, {0x111D0, 0x111D9, UC_NUMBER}, {0x111DA, 0x111DA, UC_LETTER},
+  {0x111DC, 0x111DC, UC_LETTER}, {0x111E1, 0x111F4, UC_NUMBER}, {0x11200, 0x11211, UC_LETTER},
+  {0x11213, 0x1122B, UC_LETTER}, {0x1123F, 0x11240, UC_LETTER}, {0x11280, 0x11286, UC_LETTER},
+  {0x11288, 0x11288, UC_LETTER}, {0x1128A, 0x1128D, UC_LETTER}, {0x1128F, 0x1129D, UC_LETTER},
+  {0x1129F, 0x112A8, UC_LETTER}, {0x112B0, 0x112DE, UC_LETTER}, {0x112F0, 0x112F9, UC_NUMBER},
+  {0x11305, 0x1130C, UC_LETTER}, {0x1130F, 0x11310, UC_LETTER}, {0x11313, 0x11328, UC_LETTER},
+  {0x1132A, 0x11330, UC_LETTER}, {0x11332, 0x11333, UC_LETTER}, {0x11335, 0x11339, UC_LETTER},
+  {0x1133D, 0x1133D, UC_LETTER}, {0x11350, 0x11350, UC_LETTER}, {0x1135D, 0x11361, UC_LETTER},
+  {0x11380, 0x11389, UC_LETTER}, {0x1138B, 0x1138B, UC_LETTER}, {0x1138E, 0x1138E, UC_LETTER},
+  {0x11390, 0x113B5, UC_LETTER}, {0x113B7, 0x113B7, UC_LETTER}, {0x113D1, 0x113D1, UC_LETTER},
+  {0x113D3, 0x113D3, UC_LETTER}, {0x11400, 0x11434, UC_LETTER}, {0x11447, 0x1144A, UC_LETTER},
+  {0x11450, 0x11459, UC_NUMBER}, {0x1145F, 0x11461, UC_LETTER}, {0x11480, 0x114AF, UC_LETTER},
+  {0x114C4, 0x114C5, UC_LETTER}, {0x114C7, 0x114C7, UC_LETTER}, {0x114D0, 0x114D9, UC_NUMBER},
+  {0x11580, 0x115AE, UC_LETTER}, {0x115D8, 0x115DB, UC_LETTER}, {0x11600, 0x1162F, UC_LETTER},
+  {0x11644, 0x11644, UC_LETTER}, {0x11650, 0x11659, UC_NUMBER}, {0x11680, 0x116AA, UC_LETTER},
+  {0x116B8, 0x116B8, UC_LETTER}, {0x116C0, 0x116C9, UC_NUMBER}, {0x116D0, 0x116E3, UC_NUMBER},
+  {0x11700, 0x1171A, UC_LETTER}, {0x11730, 0x1173B, UC_NUMBER}, {0x11740, 0x11746, UC_LETTER},
+  {0x11800, 0x1182B, UC_LETTER}, {0x118A0, 0x118DF, UC_LETTER}, {0x118E0, 0x118F2, UC_NUMBER},
+  {0x118FF, 0x11906, UC_LETTER}, {0x11909, 0x11909, UC_LETTER}, {0x1190C, 0x11913, UC_LETTER},
+  {0x11915, 0x11916, UC_LETTER}, {0x11918, 0x1192F, UC_LETTER}, {0x1193F, 0x1193F, UC_LETTER},
+  {0x11941, 0x11941, UC_LETTER}, {0x11950, 0x11959, UC_NUMBER}, {0x119A0, 0x119A7, UC_LETTER},
+  {0x119AA, 0x119D0, UC_LETTER}, {0x119E1, 0x119E1, UC_LETTER}, {0x119E3, 0x119E3, UC_LETTER},
+  {0x11A00, 0x11A00, UC_LETTER}, {0x11A0B, 0x11A32, UC_LETTER}, {0x11A3A, 0x11A3A, UC_LETTER},
+  {0x11A50, 0x11A50, UC_LETTER}, {0x11A5C, 0x11A89, UC_LETTER}, {0x11A9D, 0x11A9D, UC_LETTER},
+  {0x11AB0, 0x11AF8, UC_LETTER}, {0x11B0A, 0x11B0A, UC_LETTER}, {0x11BC0, 0x11BE0, UC_LETTER},
+  {0x11BF0, 0x11BF9, UC_NUMBER}, {0x11C00, 0x11C08, UC_LETTER}, {0x11C0A, 0x11C2E, UC_LETTER},
+  {0x11C40, 0x11C40, UC_LETTER}, {0x11C50, 0x11C6C, UC_NUMBER}, {0x11C72, 0x11C8F, UC_LETTER},
+  {0x11D00, 0x11D06, UC_LETTER}, {0x11D08, 0x11D09, UC_LETTER}, {0x11D0B, 0x11D30, UC_LETTER},
+  {0x11D46, 0x11D46, UC_LETTER}, {0x11D50, 0x11D59, UC_NUMBER}, {0x11D60, 0x11D65, UC_LETTER},
+  {0x11D67, 0x11D68, UC_LETTER}, {0x11D6A, 0x11D89, UC_LETTER}, {0x11D98, 0x11D98, UC_LETTER},
+  {0x11DA0, 0x11DA9, UC_NUMBER}, {0x11DB0, 0x11DDB, UC_LETTER}, {0x11DE0, 0x11DE9, UC_NUMBER},
+  {0x11DF1, 0x11DF1, UC_LETTER}, {0x11EE0, 0x11EF2, UC_LETTER}, {0x11F02, 0x11F02, UC_LETTER},
+  {0x11F04, 0x11F10, UC_LETTER}, {0x11F12, 0x11F33, UC_LETTER}, {0x11F50, 0x11F59, UC_NUMBER},
+  {0x11FB0, 0x11FB0, UC_LETTER}, {0x11FC0, 0x11FD4, UC_NUMBER}, {0x12000, 0x12399, UC_LETTER},
+  {0x12400, 0x1246F, UC_NUMBER}, {0x12475, 0x1247F, UC_NUMBER}, {0x12480, 0x12543, UC_LETTER},
+  {0x12550, 0x12686, UC_NUMBER}, {0x12F90, 0x12FF0, UC_LETTER}, {0x13000, 0x1342F, UC_LETTER},
+  {0x13441, 0x13446, UC_LETTER}, {0x13460, 0x143FA, UC_LETTER}, {0x14400, 0x14646, UC_LETTER},
+  {0x16100, 0x1611D, UC_LETTER}, {0x16130, 0x16139, UC_NUMBER}, {0x16800, 0x16A38, UC_LETTER},
+  {0x16A40, 0x16A5E, UC_LETTER}, {0x16A60, 0x16A69, UC_NUMBER}, {0x16A70, 0x16ABE, UC_LETTER},
+  {0x16AC0, 0x16AC9, UC_NUMBER}, {0x16AD0, 0x16AED, UC_LETTER}, {0x16B00, 0x16B2F, UC_LETTER},
+  {0x16B40, 0x16B43, UC_LETTER}, {0x16B50, 0x16B59, UC_NUMBER}, {0x16B5B, 0x16B61, UC_NUMBER},
+  {0x16B63, 0x16B77, UC_LETTER}, {0x16B7D, 0x16B8F, UC_LETTER}, {0x16D40, 0x16D6C, UC_LETTER},
+  {0x16D70, 0x16D79, UC_NUMBER}, {0x16E40, 0x16E7F, UC_LETTER}, {0x16E80, 0x16E96, UC_NUMBER},
+  {0x16EA0, 0x16EB8, UC_LETTER}, {0x16EBB, 0x16ED3, UC_LETTER}, {0x16F00, 0x16F4A, UC_LETTER},
+  {0x16F50, 0x16F50, UC_LETTER}, {0x16F93, 0x16F9F, UC_LETTER}, {0x16FE0, 0x16FE1, UC_LETTER},
+  {0x16FE3, 0x16FE3, UC_LETTER}, {0x16FF2, 0x16FF3, UC_LETTER}, {0x16FF4, 0x16FF6, UC_NUMBER},
+  {0x17000, 0x18CDA, UC_LETTER}, {0x18CFF, 0x18D20, UC_LETTER}, {0x18D80, 0x18DF2, UC_LETTER},
+  {0x18E00, 0x19191, UC_LETTER}, {0x191A0, 0x191D2, UC_LETTER}, {0x1AFF0, 0x1AFF3, UC_LETTER},
+  {0x1AFF5, 0x1AFFB, UC_LETTER}, {0x1AFFD, 0x1AFFE, UC_LETTER}, {0x1B000, 0x1B128, UC_LETTER},
+  {0x1B132, 0x1B132, UC_LETTER}, {0x1B150, 0x1B152, UC_LETTER}, {0x1B155, 0x1B155, UC_LETTER},
+  {0x1B164, 0x1B168, UC_LETTER}, {0x1B170, 0x1B2FB, UC_LETTER}, {0x1BC00, 0x1BC6A, UC_LETTER},
+  {0x1BC70, 0x1BC7C, UC_LETTER}, {0x1BC80, 0x1BC88, UC_LETTER}, {0x1BC90, 0x1BC99, UC_LETTER},
+  {0x1CCF0, 0x1CCF9, UC_NUMBER}, {0x1D2C0, 0x1D2D3, UC_NUMBER}, {0x1D2E0, 0x1D2F3, UC_NUMBER},
+  {0x1D360, 0x1D378, UC_NUMBER}, {0x1D400, 0x1D454, UC_LETTER}, {0x1D456, 0x1D49C, UC_LETTER},
+  {0x1D49E, 0x1D49F, UC_LETTER}, {0x1D4A2, 0x1D4A2, UC_LETTER}, {0x1D4A5, 0x1D4A6, UC_LETTER},
+  {0x1D4A9, 0x1D4AC, UC_LETTER}, {0x1D4AE, 0x1D4B9, UC_LETTER}, {0x1D4BB, 0x1D4BB, UC_LETTER},
+  {0x1D4BD, 0x1D4C3, UC_LETTER}, {0x1D4C5, 0x1D505, UC_LETTER}, {0x1D507, 0x1D50A, UC_LETTER},
+  {0x1D50D, 0x1D514, UC_LETTER}, {0x1D516, 0x1D51C, UC_LETTER}, {0x1D51E, 0x1D539, UC_LETTER},
+  {0x1D53B, 0x1D53E, UC_LETTER}, {0x1D540, 0x1D544, UC_LETTER}, {0x1D546, 0x1D546, UC_LETTER},
+  {0x1D54A, 0x1D550, UC_LETTER}, {0x1D552, 0x1D6A6, UC_LETTER}, {0x1D6A8, 0x1D6C0, UC_LETTER},
+  {0x1D6C2, 0x1D6DA, UC_LETTER}, {0x1D6DC, 0x1D6FA, UC_LETTER}, {0x1D6FC, 0x1D714, UC_LETTER},
+  {0x1D716, 0x1D734, UC_LETTER}, {0x1D736, 0x1D74E, UC_LETTER}, {0x1D750, 0x1D76E, UC_LETTER},
+  {0x1D770, 0x1D788, UC_LETTER}, {0x1D78A, 0x1D7A8, UC_LETTER}, {0x1D7AA, 0x1D7C2, UC_LETTER},
+  {0x1D7C4, 0x1D7CB, UC_LETTER}, {0x1D7CE, 0x1D7FF, UC_NUMBER}, {0x1DF00, 0x1DF81, UC_LETTER},
+  {0x1DF90, 0x1DF96, UC_LETTER}, {0x1DFCD, 0x1DFFF, UC_LETTER}, {0x1E030, 0x1E06D, UC_LETTER},
+  {0x1E100, 0x1E12C, UC_LETTER}, {0x1E137, 0x1E13D, UC_LETTER}, {0x1E140, 0x1E149, UC_NUMBER},
+  {0x1E14E, 0x1E14E, UC_LETTER}, {0x1E290, 0x1E2AD, UC_LETTER}, {0x1E2C0, 0x1E2EB, UC_LETTER},
+  {0x1E2F0, 0x1E2F9, UC_NUMBER}, {0x1E4D0, 0x1E4EB, UC_LETTER}, {0x1E4F0, 0x1E4F9, UC_NUMBER},
+  {0x1E5D0, 0x1E5ED, UC_LETTER}, {0x1E5F0, 0x1E5F0, UC_LETTER}, {0x1E5F1, 0x1E5FA, UC_NUMBER},
+  {0x1E6C0, 0x1E6DE, UC_LETTER}, {0x1E6E0, 0x1E6E2, UC_LETTER}, {0x1E6E4, 0x1E6E5, UC_LETTER},
+  {0x1E6E7, 0x1E6ED, UC_LETTER}, {0x1E6F0, 0x1E6F4, UC_LETTER}, {0x1E6FE, 0x1E6FF, UC_LETTER},
+  {0x1E7E0, 0x1E7E6, UC_LETTER}, {0x1E7E8, 0x1E7EB, UC_LETTER}, {0x1E7ED, 0x1E7EE, UC_LETTER},
+  {0x1E7F0, 0x1E7FE, UC_LETTER}, {0x1E800, 0x1E8C4, UC_LETTER}, {0x1E8C7, 0x1E8CF, UC_NUMBER},
+  {0x1E900, 0x1E943, UC_LETTER}, {0x1E94B, 0x1E94B, UC_LETTER}, {0x1E950, 0x1E959, UC_NUMBER},
+  {0x1EC71, 0x1ECAB, UC_NUMBER}, {0x1ECAD, 0x1ECAF, UC_NUMBER}, {0x1ECB1, 0x1ECB4, UC_NUMBER},
+  {0x1ED01, 0x1ED2D, UC_NUMBER}, {0x1ED2F, 0x1ED3D, UC_NUMBER}, {0x1EE00, 0x1EE03, UC_LETTER},
+  {0x1EE05, 0x1EE1F, UC_LETTER}, {0x1EE21, 0x1EE22, UC_LETTER}, {0x1EE24, 0x1EE24, UC_LETTER},
+  {0x1EE27, 0x1EE27, UC_LETTER}, {0x1EE29, 0x1EE32, UC_LETTER}, {0x1EE34, 0x1EE37, UC_LETTER},
+  {0x1EE39, 0x1EE39, UC_LETTER}, {0x1EE3B, 0x1EE3B, UC_LETTER}, {0x1EE42, 0x1EE42, UC_LETTER},
+  {0x1EE47, 0x1EE47, UC_LETTER}, {0x1EE49, 0x1EE49, UC_LETTER}, {0x1EE4B, 0x1EE4B, UC_LETTER},
+  {0x1EE4D, 0x1EE4F, UC_LETTER}, {0x1EE51, 0x1EE52, UC_LETTER}, {0x1EE54, 0x1EE54, UC_LETTER},
+  {0x1EE57, 0x1EE57, UC_LETTER}, {0x1EE59, 0x1EE59, UC_LETTER}, {0x1EE5B, 0x1EE5B, UC_LETTER},
+  {0x1EE5D, 0x1EE5D, UC_LETTER}, {0x1EE5F, 0x1EE5F, UC_LETTER}, {0x1EE61, 0x1EE62, UC_LETTER},
+  {0x1EE64, 0x1EE64, UC_LETTER}, {0x1EE67, 0x1EE6A, UC_LETTER}, {0x1EE6C, 0x1EE72, UC_LETTER},
+  {0x1EE74, 0x1EE77, UC_LETTER}, {0x1EE79, 0x1EE7C, UC_LETTER}, {0x1EE7E, 0x1EE7E, UC_LETTER},
+  {0x1EE80, 0x1EE89, UC_LETTER}, {0x1EE8B, 0x1EE9B, UC_LETTER}, {0x1EEA1, 0x1EEA3, UC_LETTER},
+  {0x1EEA5, 0x1EEA9, UC_LETTER}, {0x1EEAB, 0x1EEBB, UC_LETTER}, {0x1F100, 0x1F10C, UC_NUMBER},
+  {0x1FBF0, 0x1FBF9, UC_NUMBER}, {0x20000, 0x2A6DF, UC_LETTER}, {0x2A700, 0x2B81E, UC_LETTER},
+  {0x2B820, 0x2CEAD, UC_LETTER}, {0x2CEB0, 0x2EBE0, UC_LETTER}, {0x2EBF0, 0x2EE5D, UC_LETTER},
+  {0x2F800, 0x2FA1D, UC_LETTER}, {0x30000, 0x3134A, UC_LETTER}, {0x31350, 0x33479, UC_LETTER},
+  {0x3D000, 0x3FC3F, UC_LETTER},
+};
+
+static uint8_t codepoint_class(uint32_t cp) {
+  size_t lo = 0, hi = sizeof(class_ranges) / sizeof(class_ranges[0]);
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (cp < class_ranges[mid].first) hi = mid;
+    else if (cp > class_ranges[mid].last) lo = mid + 1;
+    else return class_ranges[mid].cls;
+  }
+  return UC_OTHER;
+}
+
+// class of the character at p & its byte length in `*len`; malformed UTF-8 is a 1-byte UC_OTHER
+static uint8_t class_at(const unsigned char* p, const unsigned char* end, size_t* len) {
+  unsigned char c = *p;
+  *len = 1;
+  if (c < 0x80) return ascii_class[c];
+  size_t n;
+  uint32_t cp, min;
+  if ((c & 0xE0) == 0xC0) { n = 2; cp = c & 0x1F; min = 0x80; }
+  else if ((c & 0xF0) == 0xE0) { n = 3; cp = c & 0x0F; min = 0x800; }
+  else if ((c & 0xF8) == 0xF0) { n = 4; cp = c & 0x07; min = 0x10000; }
+  else return UC_OTHER;
+  if ((size_t)(end - p) < n) return UC_OTHER;
+  for (size_t k = 1; k < n; k++) {
+    if ((p[k] & 0xC0) != 0x80) return UC_OTHER;
+    cp = (cp << 6) | (p[k] & 0x3F);
+  }
+  if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return UC_OTHER;
+  *len = n;
+  return codepoint_class(cp);
+}
+
+// end of the run of `cls` characters starting at p, at most `max` of them (0 -> unbounded)
+static const unsigned char* run_end(const unsigned char* p, const unsigned char* end, uint8_t cls, size_t max) {
+  size_t count = 0, len;
+  bool skim = cls == UC_LETTER && max == 0 && scan_simd();
+  while (p < end && (max == 0 || count < max)) {
+    // ASCII letters 64 at a time, other characters one by one
+    if (skim && *p < 0x80 && end - p >= SCAN_BLOCK) {
+      uint64_t rest = ~scan_kernels.alpha_mask((const char*)p);
+      size_t skip = rest ? (size_t)scan_ctz64(rest) : SCAN_BLOCK;
+      if (skip) {
+        p += skip;
+        continue;
+      }
+    }
+    if (class_at(p, end, &len) != cls) break;
+    p += len;
+    count++;
+  }
+  return p;
+}
+
+// length of the contraction suffix after an apostrophe: [sdmt] | ll | ve | re
+static size_t contraction_len(const unsigned char* p, const unsigned char* end, bool fold_case) {
+  if (p >= end) return 0;
+  unsigned char a = fold_case ? (unsigned char)(*p | 0x20) : *p;
+  if (a == 's' || a == 'd' || a == 'm' || a == 't') return 1;
+  if (p + 1 >= end) return 0;
+  unsigned char b = fold_case ? (unsigned char)(p[1] | 0x20) : p[1];
+  if ((a == 'l' && b == 'l') || (a == 'v' && b == 'e') || (a == 'r' && b == 'e')) return 2;
+  return 0;
+}
+
+/**
+ @brief Matches the whitespace alternatives at p, which starts a whitespace run.
+ *
+ * GPT4 first tries `\s*[\r\n]`: the run up to its last line break. Both patterns then try
+ * `\s+(?!\S)`: the whole run at the end of the text, else the run minus its last character
+ * (which then prefixes the next word), and fall back to `\s+` for a single character.
+*/
+static size_t match_space(const unsigned char* p, const unsigned char* end, bool line_breaks) {
+  const unsigned char* q = p;
+  const unsigned char* last = p;  // start of the run's last character
+  const unsigned char* brk = NULL;  // one past the run's last line break
+  size_t len;
+  while (q < end && class_at(q, end, &len) == UC_SPACE) {
+    if (*q == '\n' || *q == '\r') brk = q + 1;
+    last = q;
+    q += len;
+  }
+  if (line_breaks && brk) return (size_t)(brk - p);
+  if (q == end || last == p) return (size_t)(q - p);
+  return (size_t)(last - p);
+}
+
+static size_t gpt2_next(const unsigned char* p, const unsigned char* end) {
+  size_t len, len2;
+  if (*p == '\'') {
+    size_t k = contraction_len(p + 1, end, false);
+    if (k) return 1 + k;
+  }
+  uint8_t cls = class_at(p, end, &len);
+  // ` ?\p{L}+`, ` ?\p{N}+`, ` ?[^\s\p{L}\p{N}]+`: one leading space joins the run after it
+  if (*p == ' ' && p + 1 < end) {
+    uint8_t next = class_at(p + 1, end, &len2);
+    if (next != UC_SPACE) return (size_t)(run_end(p + 1, end, next, 0) - p);
+  }
+  if (cls != UC_SPACE) return (size_t)(run_end(p, end, cls, 0) - p);
+  return match_space(p, end, false);
+}
+
+static size_t gpt4_next(const unsigned char* p, const unsigned char* end) {
+  size_t len, len2;
+  if (*p == '\'') {
+    size_t k = contraction_len(p + 1, end, true);
+    if (k) return 1 + k;
+  }
+  uint8_t cls = class_at(p, end, &len);
+  // `[^\r\n\p{L}\p{N}]?+\p{L}+`: a letter run, optionally behind one non-letter, non-digit, non-line-break char
+  if (cls == UC_LETTER) return (size_t)(run_end(p, end, UC_LETTER, 0) - p);
+  if (cls != UC_NUMBER && *p != '\r' && *p != '\n' && p + len < end && class_at(p + len, end, &len2) == UC_LETTER) {
+    return (size_t)(run_end(p + len, end, UC_LETTER, 0) - p);
+  }
+  // `\p{N}{1,3}`
+  if (cls == UC_NUMBER) return (size_t)(run_end(p, end, UC_NUMBER, 3) - p);
+  // ` ?[^\s\p{L}\p{N}]++[\r\n]*`: a punctuation run & the line breaks right after it
+  const unsigned char* q = p;
+  if (*q == ' ' && q + 1 < end && class_at(q + 1, end, &len2) == UC_OTHER) q++;
+  if (class_at(q, end, &len2) == UC_OTHER) {
+    q = run_end(q, end, UC_OTHER, 0);
+    while (q < end && (*q == '\r' || *q == '\n')) q++;
+    return (size_t)(q - p);
+  }
+  return match_space(p, end, true);
+}
+
+/**
+ @brief Returns the byte length of the word starting at `p` under a GPT2 or GPT4 pre-tokenizer.
+ *
+ * Matches the pattern's alternatives in order at `p`, like a regex `findall` does, so walking
+ * a text word by word reproduces `apply_regex`. Never returns 0 for `p < end`.
+ *
+ @param mode PRETOK_GPT2 or PRETOK_GPT4 (anything else is treated as GPT4).
+ @param p Start of the word.
+ @param end End of the text; the lookahead of `\s+(?!\S)` sees it as the end of input.
+*/
+size_t pretok_next(int mode, const char* p, const char* end) {
+  const unsigned char* s = (const unsigned char*)p;
+  const unsigned char* e = (const unsigned char*)end;
+  return mode == PRETOK_GPT2 ? gpt2_next(s, e) : gpt4_next(s, e);
+}
+
+/**
+ @brief Splits a text into words the way training does and records where each word lies.
+ *
+ @param mode Pre-tokenizer (see `PreTokenizer`); whitespace splitting drops the delimiters.
+ @param text Text to split (need not be NUL-terminated).
+ @param len Length of the text in bytes.
+ @param spans Receives `begin, end` byte offsets of the first `cap` words (may be NULL if cap is 0).
+ @param cap Number of word slots in `spans`.
+ @return Number of words in the text, which may exceed `cap`.
+*/
+size_t pretok_split(int mode, const char* text, size_t len, size_t* spans, size_t cap) {
+  const char* p = text;
+  const char* end = text + len;
+  size_t n = 0;
+  while (p < end) {
+    const char* word = p;
+    if (mode == PRETOK_WHITESPACE) {
+      while (p < end && is_corpus_delim((unsigned char)*p)) p++;
+      word = p;
+      while (p < end && !is_corpus_delim((unsigned char)*p)) p++;
+      if (p == word) break;
+    } else {
+      p += pretok_next(mode, p, end);
+    }
+    if (n < cap) {
+      spans[2 * n] = (size_t)(word - text);
+      spans[2 * n + 1] = (size_t)(p - text);
+    }
+    n++;
+  }
+  return n;
+}
@@ -0,0 +1,48 @@
+/**
+  @file pretok.h
+  @brief Pre-tokenizers: how corpus text is cut into the words that BPE trains on.
+
+  * PRETOK_WHITESPACE (default): a word is a run of bytes between corpus delimiters
+    (space, tab, newline, carriage return, NUL); the delimiters themselves are dropped.
+  * PRETOK_GPT2 / PRETOK_GPT4: compiled versions of the split patterns of `apply_regex`
+    in base.py, matched by hand over UTF-8 without a regex engine. Every byte of the text
+    ends up in some word, so spaces & newlines are trained into the vocab like any symbol:
+      GPT2: '(?:[sdmt]|ll|ve|re)| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+
+      GPT4: '(?i:[sdmt]|ll|ve|re)|[^\r\n\p{L}\p{N}]?+\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]++[\r\n]*|\s*[\r\n]|\s+(?!\S)|\s+
+  * Letter, number & whitespace classes beyond ASCII come from range tables generated
+    with the `regex` module, so both sides agree on non-Latin scripts; bytes that aren't
+    valid UTF-8 count as punctuation, one byte each.
+  * Text may only be cut into independently split pieces where both patterns always
+    split anyway: before a space that follows an ASCII letter/digit and precedes an
+    ASCII letter ("word| next"). Shards & reader chunks are cut there.
+*/
+
+#ifndef __PRETOK__H__
+#define __PRETOK__H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum PreTokenizer {
+  PRETOK_WHITESPACE = 0,
+  PRETOK_GPT2 = 1,
+  PRETOK_GPT4 = 2
+} PreTokenizer;
+
+static inline bool pretok_ascii_alpha(unsigned char c) {
+  return (unsigned char)((c | 0x20) - 'a') < 26;
+}
+
+// true if text may be cut right before data[i] without changing how either pattern splits it
+static inline bool pretok_is_cut(const char* data, size_t i, size_t size) {
+  if (i == 0 || i + 1 >= size || data[i] != ' ') return false;
+  unsigned char prev = (unsigned char)data[i - 1];
+  return (pretok_ascii_alpha(prev) || (unsigned char)(prev - '0') < 10) && pretok_ascii_alpha((unsigned char)data[i + 1]);
+}
+
+extern "C" {
+  size_t pretok_next(int mode, const char* p, const char* end);  // byte length of the GPT2/GPT4 word at p (p < end)
+  size_t pretok_split(int mode, const char* text, size_t len, size_t* spans, size_t cap);  // word [begin, end) pairs, returns the word count
+}
+
+#endif  //!__PRETOK__H__
@@ -0,0 +1,622 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "reader.h"
+#include "pretok.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <dirent.h>
+  #include <glob.h>
+  #include <sys/stat.h>
+#endif
+#ifdef SHRED_HAVE_ZLIB
+  #include <zlib.h>
+#endif
+#ifdef SHRED_HAVE_ZSTD
+  #include <zstd.h>
+#endif
+
+#define  READER_INPUT_BYTES  (1 << 18)   // raw bytes read from disk at a time
+
+// one open corpus file, decoded on the fly if compressed
+typedef struct CorpusSource {
+  FILE* fp;
+  const char* path;
+  CorpusCodec codec;
+  unsigned char* in;  // raw bytes read ahead of the decoder
+  size_t in_pos, in_len;
+  bool in_eof;  // nothing left to read from `fp`
+  bool frame_end;   // the decoder finished a gzip member / zstd frame & holds no pending output
+#ifdef SHRED_HAVE_ZLIB
+  z_stream z;
+#endif
+#ifdef SHRED_HAVE_ZSTD
+  ZSTD_DStream* zs;
+#endif
+} CorpusSource;
+
+typedef struct ReaderBuffer {
+  char* data;
+  size_t size;  // bytes of the current chunk
+  size_t cap;
+  bool full;  // holds a chunk that the caller hasn't handed back yet
+} ReaderBuffer;
+
+struct CorpusReader {
+  const CorpusFiles* files;
+  size_t chunk;   // target chunk size in bytes
+  int pre_tokenizer;  // chooses where chunks may be cut, see pretok.h
+  ReaderBuffer bufs[2];
+  int take;   // buffer the caller gets next
+  int held;   // buffer currently lent to the caller, -1 if none
+  bool done, failed, stop;  // guarded by `lock`, like the `full` flags
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_t thread;
+  bool threaded;  // false if the reader thread couldn't be started, chunks are then read inline
+  // reading side only ----
+  CorpusSource src;   // file being read
+  bool src_open;  // false between files
+  size_t next_file;
+  bool eof;   // every file consumed
+  bool pending_sep;   // the last file didn't end in a newline, one is owed before the next one
+  int last_byte;  // last byte read from the current file, -1 if none yet
+  char* carry;  // partial word cut off the end of the previous chunk
+  size_t carry_len, carry_cap;
+};
+
+static void files_push(CorpusFiles* files, const char* path) {
+  if (files->size == files->cap) {
+    size_t cap = files->cap ? files->cap * 2 : 16;
+    char** paths = (char**)realloc(files->paths, cap * sizeof(char*));
+    if (!paths) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of corpus file list\n");
+      exit(EXIT_FAILURE);
+    }
+    files->paths = paths;
+    files->cap = cap;
+  }
+  char* copy = strdup(path);
+  if (!copy) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of corpus file list\n");
+    exit(EXIT_FAILURE);
+  }
+  files->paths[files->size++] = copy;
+}
+
+static char* join_path(const char* dir, const char* name) {
+  size_t n = strlen(dir), m = strlen(name);
+  bool sep = n > 0 && dir[n - 1] != '/' && dir[n - 1] != '\\';
+  char* out = (char*)malloc(n + sep + m + 1);
+  if (!out) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of corpus file path\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(out, dir, n);
+  if (sep) out[n] = '/';
+  memcpy(out + n + sep, name, m + 1);
+  return out;
+}
+
+static int name_cmp(const void* a, const void* b) {
+  return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// growable list of entry names, sorted before use so the reading order never depends on the filesystem
+typedef struct NameList {
+  char** names;
+  size_t size, cap;
+} NameList;
+
+static void names_push(NameList* list, const char* name) {
+  if (list->size == list->cap) {
+    size_t cap = list->cap ? list->cap * 2 : 64;
+    char** names = (char**)realloc(list->names, cap * sizeof(char*));
+    if (!names) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of directory listing\n");
+      exit(EXIT_FAILURE);
+    }
+    list->names = names;
+    list->cap = cap;
+  }
+  char* copy = strdup(name);
+  if (!copy) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of directory listing\n");
+    exit(EXIT_FAILURE);
+  }
+  list->names[list->size++] = copy;
+}
+
+static void names_free(NameList* list) {
+  for (size_t i = 0; i < list->size; i++) free(list->names[i]);
+  free(list->names);
+}
+
+#ifdef _WIN32
+static bool path_is_dir(const char* path, bool* exists) {
+  DWORD attr = GetFileAttributesA(path);
+  *exists = attr != INVALID_FILE_ATTRIBUTES;
+  return *exists && (attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// lists the entries matching `pattern` (a directory followed by `*`, or a wildcard path)
+static int list_matches(const char* pattern, NameList* list) {
+  WIN32_FIND_DATAA fd;
+  HANDLE h = FindFirstFileA(pattern, &fd);
+  if (h == INVALID_HANDLE_VALUE) return -1;
+  do {
+    if (fd.cFileName[0] != '.') names_push(list, fd.cFileName);
+  } while (FindNextFileA(h, &fd));
+  FindClose(h);
+  return 0;
+}
+#else
+static bool path_is_dir(const char* path, bool* exists) {
+  struct stat st;
+  *exists = stat(path, &st) == 0;
+  return *exists && S_ISDIR(st.st_mode);
+}
+#endif
+
+// appends every file below `dir`, descending into sub-directories in name order
+static int expand_dir(CorpusFiles* files, const char* dir) {
+  NameList list = {NULL, 0, 0};
+#ifdef _WIN32
+  char* pattern = join_path(dir, "*");
+  int status = list_matches(pattern, &list);
+  free(pattern);
+  if (status != 0) {
+    fprintf(stderr, "[ERROR]\t Couldn't open directory: %s\n", dir);
+    return -1;
+  }
+#else
+  DIR* d = opendir(dir);
+  if (!d) {
+    fprintf(stderr, "[ERROR]\t Couldn't open directory: %s\n", dir);
+    return -1;
+  }
+  for (struct dirent* e = readdir(d); e; e = readdir(d)) {
+    if (e->d_name[0] != '.') names_push(&list, e->d_name);
+  }
+  closedir(d);
+#endif
+  qsort(list.names, list.size, sizeof(char*), name_cmp);
+  int status = 0;
+  for (size_t i = 0; i < list.size && status == 0; i++) {
+    char* path = join_path(dir, list.names[i]);
+    bool exists;
+    if (path_is_dir(path, &exists)) status = expand_dir(files, path);
+    else if (exists) files_push(files, path);
+    free(path);
+  }
+  names_free(&list);
+  return status;
+}
+
+void corpus_files_init(CorpusFiles* files) {
+  files->paths = NULL;
+  files->size = 0;
+  files->cap = 0;
+}
+
+/**
+ @brief Appends the files named by one corpus spec.
+ *
+ * An existing path is taken as is, unless it is a directory, which contributes every file
+ * below it (sorted by name, hidden entries skipped). A path that doesn't exist but holds
+ * wildcards is expanded as a glob pattern, matches in sorted order.
+ *
+ @param files List to append to.
+ @param spec File, directory or glob pattern.
+ @return 0 on success, -1 if the spec can't be read or names no file at all.
+*/
+int corpus_files_expand(CorpusFiles* files, const char* spec) {
+  size_t before = files->size;
+  bool exists;
+  if (path_is_dir(spec, &exists)) {
+    if (expand_dir(files, spec) != 0) return -1;
+  } else if (exists) {
+    files_push(files, spec);
+  } else if (strpbrk(spec, "*?[")) {
+#ifdef _WIN32
+    NameList list = {NULL, 0, 0};
+    if (list_matches(spec, &list) == 0) {
+      qsort(list.names, list.size, sizeof(char*), name_cmp);
+      const char* slash = strrchr(spec, '\\');
+      const char* fwd = strrchr(spec, '/');
+      if (!slash || (fwd && fwd > slash)) slash = fwd;
+      size_t dir_len = slash ? (size_t)(slash - spec) + 1 : 0;
+      for (size_t i = 0; i < list.size; i++) {
+        char* path = (char*)malloc(dir_len + strlen(list.names[i]) + 1);
+        if (!path) {
+          fprintf(stderr, "[ERROR]\t Failed allocation of corpus file path\n");
+          exit(EXIT_FAILURE);
+        }
+        memcpy(path, spec, dir_len);
+        strcpy(path + dir_len, list.names[i]);
+        bool is_file;
+        if (path_is_dir(path, &is_file)) expand_dir(files, path);
+        else if (is_file) files_push(files, path);
+        free(path);
+      }
+    }
+    names_free(&list);
+#else
+    glob_t g;
+    if (glob(spec, 0, NULL, &g) == 0) {
+      for (size_t i = 0; i < g.gl_pathc; i++) {
+        bool is_file;
+        if (path_is_dir(g.gl_pathv[i], &is_file)) expand_dir(files, g.gl_pathv[i]);
+        else if (is_file) files_push(files, g.gl_pathv[i]);
+      }
+    }
+    globfree(&g);
+#endif
+  } else {
+    fprintf(stderr, "[ERROR]\t Couldn't open file: %s\n", spec);
+    return -1;
+  }
+  if (files->size == before) {
+    fprintf(stderr, "[ERROR]\t No corpus files found for: %s\n", spec);
+    return -1;
+  }
+  return 0;
+}
+
+void corpus_files_free(CorpusFiles* files) {
+  for (size_t i = 0; i < files->size; i++) free(files->paths[i]);
+  free(files->paths);
+  corpus_files_init(files);
+}
+
+/**
+ @brief Tells plain text from compressed input by its leading magic bytes.
+ @param head First bytes of the file.
+ @param n Number of bytes available in `head`.
+*/
+CorpusCodec corpus_detect_codec(const unsigned char* head, size_t n) {
+  if (n >= 2 && head[0] == 0x1F && head[1] == 0x8B) return CORPUS_GZIP;
+  if (n >= 4 && head[0] == 0x28 && head[1] == 0xB5 && head[2] == 0x2F && head[3] == 0xFD) return CORPUS_ZSTD;
+  return CORPUS_PLAIN;
+}
+
+static const char* codec_name(CorpusCodec codec) {
+  return codec == CORPUS_GZIP ? "gzip" : codec == CORPUS_ZSTD ? "zstd" : "plain";
+}
+
+// tops up the raw input once the decoder has consumed all of it
+static int source_refill(CorpusSource* s) {
+  if (s->in_pos < s->in_len || s->in_eof) return 0;
+  s->in_len = fread(s->in, 1, READER_INPUT_BYTES, s->fp);
+  s->in_pos = 0;
+  if (s->in_len < READER_INPUT_BYTES) {
+    if (ferror(s->fp)) {
+      fprintf(stderr, "[ERROR]\t Couldn't read file: %s\n", s->path);
+      return -1;
+    }
+    s->in_eof = true;
+  }
+  return 0;
+}
+
+/**
+ @brief Opens a corpus file and picks its decoder from the first bytes.
+ * The peeked bytes stay in the input buffer, so pipes work as well as regular files.
+ @return 0 on success, -1 if the file can't be opened or its codec isn't compiled in.
+*/
+static int source_open(CorpusSource* s, const char* path) {
+  memset(s, 0, sizeof(CorpusSource));
+  s->path = path;
+  s->fp = fopen(path, "rb");
+  if (!s->fp) {
+    fprintf(stderr, "[ERROR]\t Couldn't open file: %s\n", path);
+    return -1;
+  }
+  s->in = (unsigned char*)malloc(READER_INPUT_BYTES);
+  if (!s->in) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of read buffer\n");
+    exit(EXIT_FAILURE);
+  }
+  if (source_refill(s) != 0) return -1;
+  s->codec = corpus_detect_codec(s->in, s->in_len);
+  switch (s->codec) {
+    case CORPUS_PLAIN:
+      return 0;
+    case CORPUS_GZIP:
+#ifdef SHRED_HAVE_ZLIB
+      if (inflateInit2(&s->z, 15 + 16) != Z_OK) break;
+      return 0;
+#else
+      break;
+#endif
+    case CORPUS_ZSTD:
+#ifdef SHRED_HAVE_ZSTD
+      s->zs = ZSTD_createDStream();
+      if (!s->zs || ZSTD_isError(ZSTD_initDStream(s->zs))) break;
+      return 0;
+#else
+      break;
+#endif
+  }
+  fprintf(stderr, "[ERROR]\t Can't decode %s input, built without %s support: %s\n", codec_name(s->codec), codec_name(s->codec), path);
+  return -1;
+}
+
+/**
+ @brief Reads up to `want` decoded bytes into `dst`.
+ @param status Set to 0 if more data follows, 1 at the end of the file, -1 on a read or decode error.
+ @return Number of bytes written to `dst`.
+*/
+static size_t source_read(CorpusSource* s, char* dst, size_t want, int* status) {
+  size_t got = 0;
+  *status = 0;
+  while (got < want) {
+    if (s->codec == CORPUS_PLAIN && s->in_pos == s->in_len && !s->in_eof) {
+      // plain text skips the input buffer once the peeked bytes are used up
+      size_t n = fread(dst + got, 1, want - got, s->fp);
+      if (n < want - got) {
+        if (ferror(s->fp)) {
+          fprintf(stderr, "[ERROR]\t Couldn't read file: %s\n", s->path);
+          *status = -1;
+          return got + n;
+        }
+        s->in_eof = true;
+      }
+      got += n;
+      continue;
+    }
+    if (source_refill(s) != 0) {
+      *status = -1;
+      return got;
+    }
+    bool drained = s->in_pos == s->in_len && s->in_eof;
+    if (s->codec == CORPUS_PLAIN) {
+      if (drained) {
+        *status = 1;
+        return got;
+      }
+      size_t n = s->in_len - s->in_pos;
+      if (n > want - got) n = want - got;
+      memcpy(dst + got, s->in + s->in_pos, n);
+      s->in_pos += n;
+      got += n;
+      continue;
+    }
+
+    size_t before = got;
+    bool ok = true;
+#ifdef SHRED_HAVE_ZLIB
+    if (s->codec == CORPUS_GZIP) {
+      if (s->frame_end && !drained) {
+        inflateReset(&s->z);  // concatenated members, as written by `cat a.gz b.gz`
+        s->frame_end = false;
+      }
+      s->z.next_in = s->in + s->in_pos;
+      s->z.avail_in = (uInt)(s->in_len - s->in_pos);
+      s->z.next_out = (Bytef*)(dst + got);
+      s->z.avail_out = (uInt)(want - got);
+      int ret = s->frame_end ? Z_STREAM_END : inflate(&s->z, Z_NO_FLUSH);
+      s->in_pos = s->in_len - s->z.avail_in;
+      got = want - s->z.avail_out;
+      if (ret == Z_STREAM_END) s->frame_end = true;
+      else if (ret != Z_OK && ret != Z_BUF_ERROR) ok = false;
+    }
+#endif
+#ifdef SHRED_HAVE_ZSTD
+    if (s->codec == CORPUS_ZSTD) {
+      ZSTD_inBuffer ib = { s->in, s->in_len, s->in_pos };
+      ZSTD_outBuffer ob = { dst, want, got };
+      size_t ret = ZSTD_decompressStream(s->zs, &ob, &ib);
+      if (ZSTD_isError(ret)) ok = false;
+      else if (ib.pos != s->in_pos || ob.pos != got) s->frame_end = ret == 0;  // an idle call only hints at the next frame
+      s->in_pos = ib.pos;
+      got = ob.pos;
+    }
+#endif
+    if (!ok) {
+      fprintf(stderr, "[ERROR]\t Corrupt %s data in file: %s\n", codec_name(s->codec), s->path);
+      *status = -1;
+      return got;
+    }
+    if (drained && got == before) {
+      if (!s->frame_end) {
+        fprintf(stderr, "[ERROR]\t Truncated %s data in file: %s\n", codec_name(s->codec), s->path);
+        *status = -1;
+      } else {
+        *status = 1;
+      }
+      return got;
+    }
+  }
+  return got;
+}
+
+static void source_close(CorpusSource* s) {
+#ifdef SHRED_HAVE_ZLIB
+  if (s->codec == CORPUS_GZIP) inflateEnd(&s->z);
+#endif
+#ifdef SHRED_HAVE_ZSTD
+  if (s->zs) ZSTD_freeDStream(s->zs);
+#endif
+  if (s->fp) fclose(s->fp);
+  free(s->in);
+  memset(s, 0, sizeof(CorpusSource));
+}
+
+static void reserve_bytes(char** data, size_t* cap, size_t need) {
+  if (*cap >= need) return;
+  size_t new_cap = *cap ? *cap : 1;
+  while (new_cap < need) new_cap *= 2;
+  char* p = (char*)realloc(*data, new_cap);
+  if (!p) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of read buffer\n");
+    exit(EXIT_FAILURE);
+  }
+  *data = p;
+  *cap = new_cap;
+}
+
+/**
+ @brief Reads the next chunk into `buf`: the carried partial word, then file data until the buffer
+ * is full, cut back after its last delimiter. A buffer holding a single word is grown instead.
+ @return 1 if a chunk was read, 0 once every file is consumed, -1 on a read error.
+*/
+static int reader_fill(CorpusReader* r, ReaderBuffer* buf) {
+  reserve_bytes(&buf->data, &buf->cap, r->chunk > r->carry_len ? r->chunk : 2 * r->carry_len);
+  if (r->carry_len) memcpy(buf->data, r->carry, r->carry_len);
+  buf->size = r->carry_len;
+  r->carry_len = 0;
+
+  for (;;) {
+    while (buf->size < buf->cap && !r->eof) {
+      if (r->pending_sep) {
+        buf->data[buf->size++] = '\n';
+        r->pending_sep = false;
+        continue;
+      }
+      if (!r->src_open) {
+        if (r->next_file == r->files->size) {
+          r->eof = true;
+          break;
+        }
+        r->src_open = true;
+        r->last_byte = -1;
+        if (source_open(&r->src, r->files->paths[r->next_file++]) != 0) return -1;
+        continue;
+      }
+      int status;
+      size_t got = source_read(&r->src, buf->data + buf->size, buf->cap - buf->size, &status);
+      buf->size += got;
+      if (got) r->last_byte = (unsigned char)buf->data[buf->size - 1];
+      if (status < 0) return -1;
+      if (status > 0) {
+        source_close(&r->src);
+        r->src_open = false;
+        r->pending_sep = r->last_byte >= 0 && r->last_byte != '\n';
+      }
+    }
+    if (r->eof) return buf->size > 0 ? 1 : 0;
+
+    // cutting after the last delimiter (or before the last pre-tokenizer cut), the partial word moves to the next chunk
+    size_t cut = buf->size;
+    if (r->pre_tokenizer == PRETOK_WHITESPACE) {
+      while (cut > 0 && !is_corpus_delim((unsigned char)buf->data[cut - 1])) cut--;
+    } else {
+      while (cut > 0 && !pretok_is_cut(buf->data, cut, buf->size)) cut--;
+    }
+    if (cut > 0) {
+      size_t tail = buf->size - cut;
+      if (tail) {
+        reserve_bytes(&r->carry, &r->carry_cap, tail);
+        memcpy(r->carry, buf->data + cut, tail);
+      }
+      r->carry_len = tail;
+      buf->size = cut;
+      return 1;
+    }
+    reserve_bytes(&buf->data, &buf->cap, 2 * buf->cap);
+  }
+}
+
+// reader thread: fills the two buffers in turn, waiting whenever both hold unread chunks
+static void* reader_main(void* arg) {
+  CorpusReader* r = (CorpusReader*)arg;
+  int idx = 0;
+  for (;;) {
+    pthread_mutex_lock(&r->lock);
+    while (r->bufs[idx].full && !r->stop) pthread_cond_wait(&r->cond, &r->lock);
+    bool stop = r->stop;
+    pthread_mutex_unlock(&r->lock);
+    if (stop) break;
+
+    int status = reader_fill(r, &r->bufs[idx]);
+    pthread_mutex_lock(&r->lock);
+    if (status > 0) r->bufs[idx].full = true;
+    else if (status == 0) r->done = true;
+    else r->failed = true;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    if (status <= 0) break;
+    idx ^= 1;
+  }
+  return NULL;
+}
+
+/**
+ @brief Starts reading `files` ahead of the caller.
+ @param files Expanded file list, must stay alive until `reader_close`.
+ @param chunk_bytes Size of each of the two buffers (0 -> READER_CHUNK_BYTES).
+ @param pre_tokenizer Pre-tokenizer of the words being counted, decides where chunks are cut.
+ @return The reader; if its thread can't be started, chunks are read on demand instead.
+*/
+CorpusReader* reader_open(const CorpusFiles* files, size_t chunk_bytes, int pre_tokenizer) {
+  CorpusReader* r = (CorpusReader*)calloc(1, sizeof(CorpusReader));
+  if (!r) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of corpus reader\n");
+    exit(EXIT_FAILURE);
+  }
+  r->files = files;
+  r->chunk = chunk_bytes ? chunk_bytes : READER_CHUNK_BYTES;
+  r->pre_tokenizer = pre_tokenizer;
+  r->held = -1;
+  pthread_mutex_init(&r->lock, NULL);
+  pthread_cond_init(&r->cond, NULL);
+  r->threaded = pthread_create(&r->thread, NULL, reader_main, r) == 0;
+  return r;
+}
+
+/**
+ @brief Hands out the next chunk, giving the previous one back to the reader.
+ * The chunk stays valid until the next `reader_next` or `reader_close` call.
+ @return 1 with `data`/`size` set, 0 after the last chunk, -1 if a file couldn't be read.
+*/
+int reader_next(CorpusReader* r, const char** data, size_t* size) {
+  if (!r->threaded) {
+    int status = reader_fill(r, &r->bufs[0]);
+    *data = r->bufs[0].data;
+    *size = status > 0 ? r->bufs[0].size : 0;
+    return status;
+  }
+  pthread_mutex_lock(&r->lock);
+  if (r->held >= 0) {
+    r->bufs[r->held].full = false;
+    r->held = -1;
+    pthread_cond_broadcast(&r->cond);
+  }
+  while (!r->bufs[r->take].full && !r->done && !r->failed) pthread_cond_wait(&r->cond, &r->lock);
+  int status;
+  if (r->bufs[r->take].full) {
+    r->held = r->take;
+    *data = r->bufs[r->take].data;
+    *size = r->bufs[r->take].size;
+    r->take ^= 1;
+    status = 1;
+  } else {
+    *data = NULL;
+    *size = 0;
+    status = r->failed ? -1 : 0;
+  }
+  pthread_mutex_unlock(&r->lock);
+  return status;
+}
+
+void reader_close(CorpusReader* r) {
+  if (!r) return;
+  if (r->threaded) {
+    pthread_mutex_lock(&r->lock);
+    r->stop = true;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->thread, NULL);
+  }
+  pthread_mutex_destroy(&r->lock);
+  pthread_cond_destroy(&r->cond);
+  if (r->src_open) source_close(&r->src);
+  free(r->bufs[0].data);
+  free(r->bufs[1].data);
+  free(r->carry);
+  free(r);
+}
@@ -0,0 +1,56 @@
+/**
+  @file reader.h
+  @brief Corpus input: path expansion & a read-ahead reader over many files.
+
+  * A corpus spec is a single file, a directory (all its files, recursively, in name
+    order, skipping hidden entries) or a glob pattern; several specs can be combined.
+  * `CorpusReader` streams the expanded files on a dedicated thread into two buffers:
+    while the caller counts the words of one chunk, the next one is already being read.
+  * gzip & zstd files are recognized by their magic bytes and decoded on the reader
+    thread, so decompression overlaps counting too (needs SHRED_HAVE_ZLIB / SHRED_HAVE_ZSTD).
+  * Every chunk ends on a word delimiter (or a cut point of the GPT pre-tokenizers, see
+    pretok.h) and consecutive files are separated by a newline, so no word is ever split
+    across two chunks or glued across two files.
+*/
+
+#ifndef __READER__H__
+#define __READER__H__
+
+#include <stddef.h>
+
+#define  READER_CHUNK_BYTES  (8 << 20)   // default size of each read-ahead buffer
+
+typedef struct CorpusFiles {
+  char** paths;   // expanded file paths, in reading order
+  size_t size;
+  size_t cap;
+} CorpusFiles;
+
+typedef enum CorpusCodec {
+  CORPUS_PLAIN,
+  CORPUS_GZIP,  // 1F 8B
+  CORPUS_ZSTD   // 28 B5 2F FD
+} CorpusCodec;
+
+typedef struct CorpusReader CorpusReader;  // reader thread & its two buffers
+
+// token delimiters used while splitting the corpus into words
+static inline bool is_corpus_delim(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\0';
+}
+
+extern "C" {
+  // CorpusFiles related functions ----
+  void corpus_files_init(CorpusFiles* files);
+  int corpus_files_expand(CorpusFiles* files, const char* spec);  // appends the files of spec, -1 if none
+  void corpus_files_free(CorpusFiles* files);
+
+  CorpusCodec corpus_detect_codec(const unsigned char* head, size_t n);
+
+  // CorpusReader related functions ----
+  CorpusReader* reader_open(const CorpusFiles* files, size_t chunk_bytes, int pre_tokenizer);  // files must outlive the reader
+  int reader_next(CorpusReader* reader, const char** data, size_t* size);  // 1 -> chunk, 0 -> done, -1 -> error
+  void reader_close(CorpusReader* reader);
+}
+
+#endif  //!__READER__H__
@@ -0,0 +1,218 @@
+#include <stdlib.h>
+#include <string.h>
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+  #define SCAN_X86 1
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #define SCAN_TARGET_AVX2
+  #else
+    #define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#else
+  #define SCAN_X86 0
+#endif
+
+// scalar kernels ----
+
+static inline bool is_delim_byte(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\0';
+}
+
+static uint64_t delim_mask_scalar(const char* p) {
+  uint64_t m = 0;
+  for (int i = 0; i < SCAN_BLOCK; i++) m |= (uint64_t)is_delim_byte((unsigned char)p[i]) << i;
+  return m;
+}
+
+static uint64_t alpha_mask_scalar(const char* p) {
+  uint64_t m = 0;
+  for (int i = 0; i < SCAN_BLOCK; i++) m |= (uint64_t)((unsigned char)(((unsigned char)p[i] | 0x20) - 'a') < 26) << i;
+  return m;
+}
+
+static void lower_copy_scalar(char* dst, const char* src, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    char c = src[i];
+    dst[i] = (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : c;
+  }
+}
+
+#if SCAN_X86
+// SSE2 kernels (baseline on x86-64) ----
+// unsigned range tests use the signed compare: (c - lo) ^ 0x80 < (width ^ 0x80) <=> lo <= c < lo + width
+
+static inline uint64_t delim_mask16_sse2(const char* p) {
+  __m128i v = _mm_loadu_si128((const __m128i*)p);
+  __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                           _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+  return (uint64_t)(uint32_t)_mm_movemask_epi8(m);
+}
+
+static inline __m128i in_range_sse2(__m128i v, char lo, char width) {
+  __m128i t = _mm_xor_si128(_mm_sub_epi8(v, _mm_set1_epi8(lo)), _mm_set1_epi8((char)0x80));
+  return _mm_cmplt_epi8(t, _mm_set1_epi8((char)(width ^ 0x80)));
+}
+
+static inline uint64_t alpha_mask16_sse2(const char* p) {
+  __m128i v = _mm_or_si128(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8(0x20));
+  return (uint64_t)(uint32_t)_mm_movemask_epi8(in_range_sse2(v, 'a', 26));
+}
+
+static uint64_t delim_mask_sse2(const char* p) {
+  return delim_mask16_sse2(p) | delim_mask16_sse2(p + 16) << 16 | delim_mask16_sse2(p + 32) << 32 | delim_mask16_sse2(p + 48) << 48;
+}
+
+static uint64_t alpha_mask_sse2(const char* p) {
+  return alpha_mask16_sse2(p) | alpha_mask16_sse2(p + 16) << 16 | alpha_mask16_sse2(p + 32) << 32 | alpha_mask16_sse2(p + 48) << 48;
+}
+
+static void lower_copy_sse2(char* dst, const char* src, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i upper = in_range_sse2(v, 'A', 26);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+  }
+  lower_copy_scalar(dst + i, src + i, n - i);
+}
+
+// AVX2 kernels ----
+
+SCAN_TARGET_AVX2 static inline uint64_t delim_mask32_avx2(const char* p) {
+  __m256i v = _mm256_loadu_si256((const __m256i*)p);
+  __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                              _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+  m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+  return (uint64_t)(uint32_t)_mm256_movemask_epi8(m);
+}
+
+SCAN_TARGET_AVX2 static inline __m256i in_range_avx2(__m256i v, char lo, char width) {
+  __m256i t = _mm256_xor_si256(_mm256_sub_epi8(v, _mm256_set1_epi8(lo)), _mm256_set1_epi8((char)0x80));
+  return _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(width ^ 0x80)), t);
+}
+
+SCAN_TARGET_AVX2 static inline uint64_t alpha_mask32_avx2(const char* p) {
+  __m256i v = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)p), _mm256_set1_epi8(0x20));
+  return (uint64_t)(uint32_t)_mm256_movemask_epi8(in_range_avx2(v, 'a', 26));
+}
+
+SCAN_TARGET_AVX2 static uint64_t delim_mask_avx2(const char* p) {
+  return delim_mask32_avx2(p) | delim_mask32_avx2(p + 32) << 32;
+}
+
+SCAN_TARGET_AVX2 static uint64_t alpha_mask_avx2(const char* p) {
+  return alpha_mask32_avx2(p) | alpha_mask32_avx2(p + 32) << 32;
+}
+
+SCAN_TARGET_AVX2 static void lower_copy_avx2(char* dst, const char* src, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i upper = in_range_avx2(v, 'A', 26);
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20))));
+  }
+  lower_copy_sse2(dst + i, src + i, n - i);
+}
+#endif
+
+// best level the CPU (& OS, for the AVX registers) supports
+static int cpu_level() {
+#if SCAN_X86
+  #if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return SCAN_SSE2;
+    __cpuid(r, 1);
+    bool osxsave = (r[2] >> 27) & 1, avx = (r[2] >> 28) & 1;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return SCAN_SSE2;
+    __cpuidex(r, 7, 0);
+    return ((r[1] >> 5) & 1) ? SCAN_AVX2 : SCAN_SSE2;
+  #else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? SCAN_AVX2 : SCAN_SSE2;
+  #endif
+#else
+  return SCAN_SCALAR;
+#endif
+}
+
+ScanKernels scan_kernels = { SCAN_SCALAR, delim_mask_scalar, alpha_mask_scalar, lower_copy_scalar };
+
+int scan_level() {
+  return scan_kernels.level;
+}
+
+/**
+ @brief Switches the scan kernels to `level`, or to the best level below it that the CPU supports.
+ *
+ * Meant for start-up & tests: kernels are read without synchronization, so the level must not
+ * change while other threads are splitting text.
+ *
+ @param level Requested `ScanLevel`.
+ @return The level now in effect.
+*/
+int scan_set_level(int level) {
+  int best = cpu_level();
+  if (level > best) level = best;
+  if (level < SCAN_SCALAR) level = SCAN_SCALAR;
+  ScanKernels scalar = { SCAN_SCALAR, delim_mask_scalar, alpha_mask_scalar, lower_copy_scalar };
+  scan_kernels = scalar;
+#if SCAN_X86
+  if (level == SCAN_SSE2) {
+    ScanKernels sse2 = { SCAN_SSE2, delim_mask_sse2, alpha_mask_sse2, lower_copy_sse2 };
+    scan_kernels = sse2;
+  } else if (level == SCAN_AVX2) {
+    ScanKernels avx2 = { SCAN_AVX2, delim_mask_avx2, alpha_mask_avx2, lower_copy_avx2 };
+    scan_kernels = avx2;
+  }
+#endif
+  return level;
+}
+
+// picks the best kernels when the library loads, capped by SHRED_SIMD
+static int scan_init() {
+  int level = SCAN_AVX2;
+  const char* env = getenv("SHRED_SIMD");
+  if (env && strcmp(env, "scalar") == 0) level = SCAN_SCALAR;
+  else if (env && strcmp(env, "sse2") == 0) level = SCAN_SSE2;
+  return scan_set_level(level);
+}
+static int scan_initialized = scan_init();
+
+uint64_t scan_delim_mask_tail(const char* p, size_t n) {
+  char block[SCAN_BLOCK];
+  memset(block, ' ', sizeof(block));
+  memcpy(block, p, n);
+  return scan_kernels.delim_mask(block);
+}
+
+uint64_t scan_alpha_mask_tail(const char* p, size_t n) {
+  char block[SCAN_BLOCK];
+  memset(block, 0, sizeof(block));
+  memcpy(block, p, n);
+  return scan_kernels.alpha_mask(block);
+}
+
+/**
+ @brief Finds the first corpus delimiter in [p, p + n), 64 bytes per step.
+ @return Its offset from p, or n if the range holds none.
+*/
+size_t scan_to_delim(const char* p, size_t n) {
+  size_t i = 0;
+  if (!scan_simd()) {
+    while (i < n && !is_delim_byte((unsigned char)p[i])) i++;
+    return i;
+  }
+  for (; i + SCAN_BLOCK <= n; i += SCAN_BLOCK) {
+    uint64_t m = scan_kernels.delim_mask(p + i);
+    if (m) return i + (size_t)scan_ctz64(m);
+  }
+  if (i < n) {
+    size_t off = i + (size_t)scan_ctz64(scan_delim_mask_tail(p + i, n - i));
+    return off < n ? off : n;
+  }
+  return n;
+}
@@ -0,0 +1,56 @@
+/**
+  @file scan.h
+  @brief Byte-classification kernels used to split & normalize corpus text.
+
+  * A kernel classifies a block of 64 bytes into a bitmask, bit i set <-> byte i is in the
+    class, so callers walk words & runs with `scan_ctz64` instead of testing every byte.
+  * SSE2 (16 bytes per compare) & AVX2 (32 bytes) versions on x86-64, chosen once at load time
+    from what the CPU supports; other targets use the portable scalar version.
+  * The SHRED_SIMD environment variable (scalar, sse2 or avx2) caps the level, e.g. to compare
+    the paths; all levels produce identical results.
+*/
+
+#ifndef __SCAN__H__
+#define __SCAN__H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define  SCAN_BLOCK  64   // bytes classified per kernel call, one mask bit each
+
+typedef enum ScanLevel {
+  SCAN_SCALAR = 0,
+  SCAN_SSE2 = 1,
+  SCAN_AVX2 = 2
+} ScanLevel;
+
+typedef struct ScanKernels {
+  int level;  // ScanLevel of these kernels
+  uint64_t (*delim_mask)(const char* p);  // corpus delimiters: space, tab, newline, carriage return, NUL
+  uint64_t (*alpha_mask)(const char* p);  // ASCII letters
+  void (*lower_copy)(char* dst, const char* src, size_t n);  // copies n bytes, lowercasing ASCII letters
+} ScanKernels;
+
+extern ScanKernels scan_kernels;  // kernels of the active level
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+  static inline int scan_ctz64(uint64_t x) { unsigned long i; _BitScanForward64(&i, x); return (int)i; }
+#else
+  static inline int scan_ctz64(uint64_t x) { return __builtin_ctzll(x); }  // x must be non-zero
+#endif
+
+// true if the active kernels are vectorized; scalar masks are slower than plain byte loops
+static inline bool scan_simd() {
+  return scan_kernels.level != SCAN_SCALAR;
+}
+
+extern "C" {
+  int scan_level();   // level of the active kernels
+  int scan_set_level(int level);  // switches kernels, capped at the CPU's best; returns the level in effect
+  uint64_t scan_delim_mask_tail(const char* p, size_t n);   // delim_mask of n < 64 bytes, bits past n set
+  uint64_t scan_alpha_mask_tail(const char* p, size_t n);   // alpha_mask of n < 64 bytes, bits past n clear
+  size_t scan_to_delim(const char* p, size_t n);  // offset of the first delimiter in [p, p + n), n if none
+}
+
+#endif  //!__SCAN__H__
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shards.h"
+#include "bpe.h"
+#include "reader.h"
+
+#define  SHARD_WRITE_IDS  (1 << 16)   // ids narrowed & written per call when the shard holds uint16
+
+typedef struct ShardWriter {
+  const char* prefix;
+  uint32_t id_bytes;
+  uint64_t shard_tokens;   // ids after which the next document opens a new shard, 0 for one shard
+  long index;   // no of the open shard, -1 before the first one
+  FILE* bin;   // ids of the open shard, NULL if none is open
+  FILE* idx;   // its header & document offsets
+  ShardHeader header;   // counts of the open shard
+  uint16_t* narrow;   // uint16 staging buffer
+  uint64_t total_docs, total_tokens;
+} ShardWriter;
+
+static char* shard_path(const char* prefix, long index, const char* ext) {
+  size_t len = strlen(prefix) + 32;
+  char* path = (char*)malloc(len);
+  if (!path) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of shard path\n");
+    exit(EXIT_FAILURE);
+  }
+  snprintf(path, len, "%s_%05ld.%s", prefix, index, ext);
+  return path;
+}
+
+// ends the open shard: the closing offset, then the final header over the placeholder
+static int shard_close(ShardWriter* w) {
+  if (!w->bin) return 0;
+  uint64_t end = w->header.num_tokens;
+  int rc = fwrite(&end, sizeof(uint64_t), 1, w->idx) == 1 ? 0 : -1;
+  if (rc == 0) rc = (fseek(w->idx, 0, SEEK_SET) == 0 && fwrite(&w->header, sizeof(ShardHeader), 1, w->idx) == 1) ? 0 : -1;
+  if (fclose(w->bin) != 0) rc = -1;
+  if (fclose(w->idx) != 0) rc = -1;
+  w->bin = w->idx = NULL;
+  if (rc != 0) fprintf(stderr, "[ERROR]\t Failed writing shard %ld of %s\n", w->index, w->prefix);
+  w->total_docs += w->header.num_docs;
+  w->total_tokens += w->header.num_tokens;
+  return rc;
+}
+
+static int shard_open(ShardWriter* w) {
+  w->index++;
+  char* bin_path = shard_path(w->prefix, w->index, "bin");
+  char* idx_path = shard_path(w->prefix, w->index, "idx");
+  w->bin = fopen(bin_path, "wb");
+  w->idx = fopen(idx_path, "wb");
+  int rc = 0;
+  if (!w->bin || !w->idx) {
+    fprintf(stderr, "[ERROR]\t Cannot open shard file: %s\n", w->bin ? idx_path : bin_path);
+    if (w->bin) fclose(w->bin);
+    if (w->idx) fclose(w->idx);
+    w->bin = w->idx = NULL;
+    rc = -1;
+  } else {
+    memset(&w->header, 0, sizeof(ShardHeader));
+    memcpy(w->header.magic, SHARD_MAGIC, 8);
+    w->header.version = SHARD_VERSION;
+    w->header.id_bytes = w->id_bytes;
+    rc = fwrite(&w->header, sizeof(ShardHeader), 1, w->idx) == 1 ? 0 : -1;   // placeholder until closing
+  }
+  free(bin_path);
+  free(idx_path);
+  return rc;
+}
+
+// records a document starting at the end of the open shard, first moving on to a new shard if it's full
+static int shard_begin_doc(ShardWriter* w) {
+  if (!w->bin || (w->shard_tokens && w->header.num_tokens >= w->shard_tokens)) {
+    if (shard_close(w) != 0 || shard_open(w) != 0) return -1;
+  }
+  uint64_t off = w->header.num_tokens;
+  if (fwrite(&off, sizeof(uint64_t), 1, w->idx) != 1) return -1;
+  w->header.num_docs++;
+  return 0;
+}
+
+static int shard_write_ids(ShardWriter* w, const int32_t* ids, size_t n) {
+  w->header.num_tokens += n;
+  if (w->id_bytes == 4) return fwrite(ids, sizeof(int32_t), n, w->bin) == n ? 0 : -1;   // ids are never negative
+  for (size_t i = 0; i < n; i += SHARD_WRITE_IDS) {
+    size_t k = n - i < SHARD_WRITE_IDS ? n - i : SHARD_WRITE_IDS;
+    for (size_t j = 0; j < k; j++) w->narrow[j] = (uint16_t)ids[i + j];
+    if (fwrite(w->narrow, sizeof(uint16_t), k, w->bin) != k) return -1;
+  }
+  return 0;
+}
+
+typedef struct DocPieces {
+  const char** texts;
+  size_t* lengths;
+  bool* starts;   // piece opens a new document (false: it carries on the one cut by the last chunk)
+  size_t size, cap;
+} DocPieces;
+
+static void pieces_push(DocPieces* d, const char* text, size_t len, bool starts) {
+  if (d->size == d->cap) {
+    d->cap = d->cap ? d->cap * 2 : 1024;
+    d->texts = (const char**)realloc(d->texts, d->cap * sizeof(char*));
+    d->lengths = (size_t*)realloc(d->lengths, d->cap * sizeof(size_t));
+    d->starts = (bool*)realloc(d->starts, d->cap * sizeof(bool));
+    if (!d->texts || !d->lengths || !d->starts) {
+      fprintf(stderr, "[ERROR]\t Failed allocation of document pieces\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  d->texts[d->size] = text;
+  d->lengths[d->size] = len;
+  d->starts[d->size++] = starts;
+}
+
+/**
+ @brief Encodes corpus files into token shard files, see shards.h for the layout.
+ *
+ * Chunks come from the corpus reader, cut where the encoder's pre-tokenizer allows, so a document
+ * cut between two chunks encodes exactly as a whole one. Every chunk is split into its documents,
+ * encoded as one batch on the encoder's pool and written out before the next chunk is taken,
+ * while the reader thread already reads (& decompresses) the one after.
+ *
+ @param paths Corpus files, directories or glob patterns, as for `bpe_load_corpus_files`.
+ @param out_prefix Shards are written to `<out_prefix>_00000.bin/.idx`, `<out_prefix>_00001.bin/.idx`, ...
+ @param shard_tokens Ids per shard before the next document opens a new one, 0 for a single shard.
+ @param doc_sep Byte separating documents, e.g. '\n' for one document per line.
+ @return No of shards written, or -1 if an input can't be read or a shard can't be written.
+*/
+long encoder_encode_files(Encoder* enc, const char* const* paths, size_t npaths, const char* out_prefix, uint64_t shard_tokens, int doc_sep) {
+  if (!enc || !paths || !out_prefix) {
+    fprintf(stderr, "[ERROR]\t NULL encoder, path or output prefix pointers\n");
+    return -1;
+  }
+  if (doc_sep < 0 || doc_sep > 255) {
+    fprintf(stderr, "[ERROR]\t Document separator must be a single byte, got %d\n", doc_sep);
+    return -1;
+  }
+  CorpusFiles files;
+  corpus_files_init(&files);
+  for (size_t i = 0; i < npaths; i++) {
+    if (!paths[i] || corpus_files_expand(&files, paths[i]) != 0) {
+      corpus_files_free(&files);
+      return -1;
+    }
+  }
+
+  ShardWriter w;
+  memset(&w, 0, sizeof(w));
+  w.prefix = out_prefix;
+  w.id_bytes = encoder_vocab_size(enc) <= 65536 ? 2 : 4;
+  w.shard_tokens = shard_tokens;
+  w.index = -1;
+  w.narrow = (uint16_t*)malloc(SHARD_WRITE_IDS * sizeof(uint16_t));
+  if (!w.narrow) {
+    fprintf(stderr, "[ERROR]\t Failed allocation of shard buffer\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // large enough chunks for every pool thread to get a batch shard of its own
+  size_t chunk = (size_t)resolve_threads(enc->num_threads) * 2 * MIN_SHARD_BYTES;
+  if (chunk < READER_CHUNK_BYTES) chunk = READER_CHUNK_BYTES;
+  CorpusReader* reader = reader_open(&files, chunk, enc->pre_tokenizer);
+  DocPieces pieces;
+  memset(&pieces, 0, sizeof(pieces));
+  bool doc_ended = true;  // the next byte opens a new document
+  const char* data;
+  size_t size;
+  int status, rc = 0;
+  while (rc == 0 && (status = reader_next(reader, &data, &size)) > 0) {
+    pieces.size = 0;
+    const char *p = data, *end = data + size;
+    while (p < end) {
+      const char* sep = (const char*)memchr(p, doc_sep, (size_t)(end - p));
+      const char* stop = sep ? sep : end;
+      if (stop > p) pieces_push(&pieces, p, (size_t)(stop - p), doc_ended);
+      doc_ended = sep != NULL;
+      p = sep ? sep + 1 : end;
+    }
+
+    // every non-empty piece has ids, so a document is only recorded once it has some
+    EncodeBatch* batch = encoder_encode_batch(enc, pieces.texts, pieces.lengths, pieces.size);
+    if (!batch) {
+      rc = -1;
+      break;
+    }
+    for (size_t i = 0; rc == 0 && i < pieces.size; i++) {
+      if (pieces.starts[i] && shard_begin_doc(&w) != 0) rc = -1;
+      if (rc == 0) rc = shard_write_ids(&w, batch->ids + batch->offsets[i], batch->offsets[i + 1] - batch->offsets[i]);
+    }
+    encoder_batch_free(batch);
+  }
+  if (rc == 0 && status < 0) rc = -1;
+  reader_close(reader);
+  corpus_files_free(&files);
+  free(pieces.texts);
+  free(pieces.lengths);
+  free(pieces.starts);
+  if (shard_close(&w) != 0) rc = -1;
+  free(w.narrow);
+  if (rc != 0) {
+    fprintf(stderr, "[ERROR]\t Encoding into %s failed\n", out_prefix);
+    return -1;
+  }
+  printf("[INFO]\t Encoded %llu documents into %llu tokens, %ld shard(s) of uint%u ids at %s_*\n",
+         (unsigned long long)w.total_docs, (unsigned long long)w.total_tokens, w.index + 1, w.id_bytes * 8, out_prefix);
+  return w.index + 1;
+}
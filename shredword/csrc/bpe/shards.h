@@ -0,0 +1,40 @@
+/**
+  @file shards.h
+  @brief Streams corpus files through an `Encoder` into flat token shard files.
+
+  * Input goes through the corpus reader (files, directories, globs, gzip/zstd), so memory stays
+    at its two read buffers plus the ids of one chunk, however large the corpus is.
+  * Documents are separated by a single byte, newline by default (one document per line). The
+    separator isn't encoded, documents without any id are skipped, and since the reader ends
+    every file with a newline a line document never spans two files.
+  * The documents of each chunk are encoded on the encoder's pool (`encoder_encode_batch`) and
+    appended in input order, so the output doesn't depend on the thread count.
+  * Shard `<prefix>_NNNNN.bin` holds the bare ids, uint16 if the vocab fits & uint32 otherwise,
+    ready to be mapped (e.g. `np.memmap`); `<prefix>_NNNNN.idx` holds a `ShardHeader` and the
+    token offset of every document plus the total, as uint64. Integers are in host byte order.
+  * A shard is closed at the first document boundary after it reached `shard_tokens` ids, so a
+    document never spans two shards.
+*/
+
+#ifndef __SHARDS__H__
+#define __SHARDS__H__
+
+#include <stdint.h>
+#include "encoder.h"
+
+#define  SHARD_MAGIC  "SHREDIDX"
+#define  SHARD_VERSION  1
+
+typedef struct ShardHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t id_bytes;   // 2 or 4, width of every id in the .bin file
+  uint64_t num_docs;
+  uint64_t num_tokens;
+} ShardHeader;  // followed by num_docs + 1 uint64 offsets into the .bin file, in ids
+
+extern "C" {
+  long encoder_encode_files(Encoder* enc, const char* const* paths, size_t npaths, const char* out_prefix, uint64_t shard_tokens, int doc_sep);
+}
+
+#endif  //!__SHARDS__H__
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <pthread.h>
 #include "threads.h"
 
@@ -26,4 +27,167 @@ int MAX_THREADS = DEFAULT_MAX_THREADS;
 void initialize_threads() {
   MAX_THREADS = get_max_threads();
   printf("Detected CPU threads: %d, using max threads: %d\n", MAX_THREADS + 2, MAX_THREADS);
-}
\ No newline at end of file
+}
+int resolve_threads(int requested) {
+  return (requested > 0) ? requested : get_max_threads();
+}
+
+typedef struct ThreadArg {
+  ThreadTask task;
+  void* arg;
+  int tid;
+} ThreadArg;
+
+static void* thread_entry(void* p) {
+  ThreadArg* a = (ThreadArg*)p;
+  a->task(a->arg, a->tid);
+  return NULL;
+}
+
+/**
+ @brief Runs `task(arg, tid)` for tid in [0, nthreads) and waits for all of them.
+ * tid 0 runs on the calling thread; if a thread can't be spawned its task
+ * runs inline on the caller instead, so every tid is always executed once.
+*/
+void run_threads(int nthreads, ThreadTask task, void* arg) {
+  if (nthreads <= 1) {
+    task(arg, 0);
+    return;
+  }
+  pthread_t* handles = (pthread_t*)malloc(sizeof(pthread_t) * nthreads);
+  ThreadArg* args = (ThreadArg*)malloc(sizeof(ThreadArg) * nthreads);
+  bool* spawned = (bool*)calloc(nthreads, sizeof(bool));
+  if (!handles || !args || !spawned) {
+    free(handles); free(args); free(spawned);
+    for (int t = 0; t < nthreads; t++) task(arg, t);
+    return;
+  }
+  for (int t = 1; t < nthreads; t++) {
+    args[t].task = task;
+    args[t].arg = arg;
+    args[t].tid = t;
+    spawned[t] = pthread_create(&handles[t], NULL, thread_entry, &args[t]) == 0;
+  }
+  task(arg, 0);
+  for (int t = 1; t < nthreads; t++) {
+    if (spawned[t]) pthread_join(handles[t], NULL);
+    else task(arg, t);
+  }
+  free(handles);
+  free(args);
+  free(spawned);
+}
+
+struct ThreadPool {
+  pthread_mutex_t lock;
+  pthread_cond_t start, done;
+  pthread_t* handles;
+  int size;   // workers + the calling thread
+  ThreadTask task;
+  void* arg;
+  int ntasks;   // tids [0, ntasks) run in the current generation
+  int pending;  // workers still busy with the current generation
+  unsigned long generation;
+  bool stop;
+};
+
+typedef struct PoolWorker {
+  ThreadPool* pool;
+  int tid;
+} PoolWorker;
+
+static void* pool_entry(void* p) {
+  PoolWorker* w = (PoolWorker*)p;
+  ThreadPool* pool = w->pool;
+  int tid = w->tid;
+  free(w);
+  unsigned long seen = 0;
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (!pool->stop && pool->generation == seen) pthread_cond_wait(&pool->start, &pool->lock);
+    if (pool->stop) break;
+    seen = pool->generation;
+    ThreadTask task = pool->task;
+    void* arg = pool->arg;
+    bool active = tid < pool->ntasks;
+    pthread_mutex_unlock(&pool->lock);
+    if (active) task(arg, tid);
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->pending == 0) pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/**
+ @brief Creates a pool of `nthreads - 1` sleeping workers for repeated fork/join runs.
+ * Spawning stops at the first failure, so the pool may end up smaller than
+ * requested (down to the caller alone); `threadpool_size` reports the real count.
+*/
+ThreadPool* threadpool_create(int nthreads) {
+  ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+  if (!pool) return NULL;
+  if (nthreads < 1) nthreads = 1;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  pool->size = 1;
+  pool->handles = (pthread_t*)malloc(sizeof(pthread_t) * nthreads);
+  if (!pool->handles) return pool;
+  for (int t = 1; t < nthreads; t++) {
+    PoolWorker* w = (PoolWorker*)malloc(sizeof(PoolWorker));
+    if (!w) break;
+    w->pool = pool;
+    w->tid = t;
+    if (pthread_create(&pool->handles[t], NULL, pool_entry, w) != 0) {
+      free(w);
+      break;
+    }
+    pool->size++;
+  }
+  return pool;
+}
+
+int threadpool_size(const ThreadPool* pool) {
+  return pool ? pool->size : 1;
+}
+
+/**
+ @brief Runs `task(arg, tid)` for tid in [0, ntasks) on the pool and waits for all of them.
+ * tid 0 runs on the calling thread; `ntasks` is clamped to the pool size.
+*/
+void threadpool_run(ThreadPool* pool, int ntasks, ThreadTask task, void* arg) {
+  if (!pool || pool->size <= 1 || ntasks <= 1) {
+    if (ntasks >= 1) task(arg, 0);
+    return;
+  }
+  if (ntasks > pool->size) ntasks = pool->size;
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->arg = arg;
+  pool->ntasks = ntasks;
+  pool->pending = pool->size - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  task(arg, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending > 0) pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void threadpool_destroy(ThreadPool* pool) {
+  if (!pool) return;
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+  for (int t = 1; t < pool->size; t++) pthread_join(pool->handles[t], NULL);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->handles);
+  free(pool);
+}
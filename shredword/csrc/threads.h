@@ -1,9 +1,18 @@
 #ifndef __THREADS__H__
 #define __THREADS__H__
 
+typedef void (*ThreadTask)(void* arg, int tid);  // work item run by each thread
+typedef struct ThreadPool ThreadPool;  // persistent workers reused across many short runs
+
 extern "C" {
   void initialize_threads();  // initializes threads for training
   int get_max_threads();  // returns the max no of threads
+  int resolve_threads(int requested);  // requested count, or max threads if <= 0
+  void run_threads(int nthreads, ThreadTask task, void* arg);  // runs task on nthreads threads & joins them
+  ThreadPool* threadpool_create(int nthreads);  // spawns nthreads - 1 workers, the caller is the last one
+  int threadpool_size(const ThreadPool* pool);  // number of threads a run can use (workers + caller)
+  void threadpool_run(ThreadPool* pool, int ntasks, ThreadTask task, void* arg);  // runs task for tid in [0, ntasks) & waits
+  void threadpool_destroy(ThreadPool* pool);  // stops & joins all workers
 }
 
-#endif
\ No newline at end of file
+#endif
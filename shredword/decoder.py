@@ -0,0 +1,100 @@
+import ctypes
+from array import array
+from typing import *
+from .cbase import lib, Py_buffer, PyBUF_SIMPLE
+
+def _view(values, typecode: str, formats: str) -> memoryview:
+  # contiguous native integers are passed as they are, anything else is converted once
+  try:
+    view = memoryview(values)
+    if view.c_contiguous and view.itemsize == array(typecode).itemsize and view.format.lstrip('@=') in formats:
+      return view
+  except TypeError:
+    pass
+  return memoryview(array(typecode, values))
+
+class _Buffer:
+  # address of a memoryview's memory, held for the duration of a call
+  def __init__(self, view: memoryview): self.view, self.buf = view, Py_buffer()
+  def __enter__(self):
+    ctypes.pythonapi.PyObject_GetBuffer(self.view, ctypes.byref(self.buf), PyBUF_SIMPLE)
+    return self.buf.buf
+  def __exit__(self, *exc): ctypes.pythonapi.PyBuffer_Release(ctypes.byref(self.buf))
+
+def _ids(ids) -> memoryview:
+  return _view(ids, 'i', 'iIl' if array('l').itemsize == 4 else 'iI')
+
+class DecodeStream:
+  def __init__(self, decoder: "BPEDecoder"):
+    self.decoder = decoder   # keeps the token table alive
+    self.stream = lib.decoder_stream_create(decoder.decoder)
+
+  def _text(self, ptr, n: ctypes.c_size_t) -> str:
+    return ctypes.string_at(ptr, n.value).decode('utf-8', errors='replace') if n.value else ""
+
+  def push(self, ids: Union[int, Iterable[int]]) -> str:
+    view = _ids([ids] if isinstance(ids, int) else ids)
+    n = ctypes.c_size_t()
+    with _Buffer(view) as buf:
+      ptr = lib.decoder_stream_push(self.stream, buf, len(view), ctypes.byref(n))
+    if not ptr:
+      raise ValueError("Token id outside the vocabulary")
+    return self._text(ptr, n)
+
+  def flush(self) -> str:
+    n = ctypes.c_size_t()
+    return self._text(lib.decoder_stream_flush(self.stream, ctypes.byref(n)), n)
+
+  def __del__(self):
+    if getattr(self, "stream", None):
+      lib.decoder_stream_destroy(self.stream)
+      self.stream = None
+
+class BPEDecoder:
+  def __init__(self, model_path: str):
+    self.decoder = lib.decoder_create(model_path.encode('utf-8'))
+    if not self.decoder:
+      raise IOError(f"Failed to load model from {model_path}")
+
+  @property
+  def vocab_size(self) -> int:
+    return lib.decoder_vocab_size(self.decoder)
+
+  def decode(self, ids: Union[Sequence[int], memoryview]) -> bytes:
+    view = _ids(ids)
+    cap = 4 * len(view) + 16   # a guess, retried at the exact size if the ids are longer
+    with _Buffer(view) as buf:
+      while True:
+        out = ctypes.create_string_buffer(cap)
+        n = lib.decoder_decode(self.decoder, buf, len(view), out, cap)
+        if n <= cap: break
+        cap = n
+    if n < 0:
+      raise ValueError("Token id outside the vocabulary")
+    return out.raw[:n]
+
+  def decode_batch(self, ids: Union[Sequence[int], memoryview], offsets: Union[Sequence[int], memoryview]) -> List[bytes]:
+    ids, offsets = _ids(ids), _view(offsets, 'Q', 'NnQqLl')
+    if len(offsets) == 0 or offsets[0] < 0 or offsets[-1] > len(ids):
+      raise ValueError("Offsets don't fit the ids")
+    with _Buffer(ids) as ibuf, _Buffer(offsets) as obuf:
+      ptr = lib.decoder_decode_batch(self.decoder, ibuf, obuf, len(offsets) - 1)
+    if not ptr:
+      raise ValueError("Token id outside the vocabulary, or offsets out of order")
+    try:
+      raw = ctypes.string_at(ptr.contents.bytes, ptr.contents.num_bytes)
+      ends = ptr.contents.offsets[:ptr.contents.num_texts + 1]
+    finally:
+      lib.decoder_batch_free(ptr)
+    return [raw[ends[i]:ends[i + 1]] for i in range(len(ends) - 1)]
+
+  def stream(self) -> DecodeStream:
+    return DecodeStream(self)
+
+  def destroy(self):
+    if getattr(self, "decoder", None):
+      lib.decoder_destroy(self.decoder)
+      self.decoder = None
+
+  def __del__(self):
+    self.destroy()
@@ -0,0 +1,93 @@
+import ctypes
+from typing import *
+from .cbase import lib, Py_buffer, PyBUF_SIMPLE
+from .trainer import PRE_TOKENIZERS, BPETrainer
+
+class _Batch:
+  # owns a C-side EncodeBatch, freed once no view into it is left
+  def __init__(self, ptr): self.ptr = ptr
+  def __del__(self): lib.encoder_batch_free(self.ptr)
+
+  def view(self, pointer, ctype, n, fmt):
+    arr = (ctype * n).from_address(ctypes.addressof(pointer.contents))
+    arr._owner = self
+    return memoryview(arr).cast('B').cast(fmt)   # native format, so `tolist` & NumPy both accept it
+
+class BPEEncoder:
+  def __init__(self, model_path: str, pre_tokenizer="whitespace", num_threads=0, cache_size=65536):
+    if pre_tokenizer not in PRE_TOKENIZERS:
+      raise ValueError(f"Unknown pre_tokenizer {pre_tokenizer!r}, expected one of {', '.join(PRE_TOKENIZERS)}")
+    self.encoder = lib.encoder_create(model_path.encode('utf-8'), PRE_TOKENIZERS[pre_tokenizer], num_threads)
+    if not self.encoder:
+      raise IOError(f"Failed to load model from {model_path}")
+    self.set_cache(cache_size)
+
+  @property
+  def vocab_size(self) -> int:
+    return lib.encoder_vocab_size(self.encoder)
+
+  def _run(self, fn, text: Union[str, bytes, bytearray, memoryview]) -> List[int]:
+    if isinstance(text, str): text = text.encode('utf-8')
+    view = Py_buffer()
+    ctypes.pythonapi.PyObject_GetBuffer(text, ctypes.byref(view), PyBUF_SIMPLE)
+    try:
+      out = (ctypes.c_int32 * max(view.len, 1))()   # never more ids than bytes
+      n = fn(self.encoder, view.buf, view.len, out)   # runs without the GIL
+    finally:
+      ctypes.pythonapi.PyBuffer_Release(ctypes.byref(view))
+    return out[:n]
+
+  def encode(self, text: Union[str, bytes, bytearray, memoryview]) -> List[int]:
+    return self._run(lib.encoder_encode, text)
+
+  def encode_word(self, word: Union[str, bytes, bytearray, memoryview]) -> List[int]:
+    return self._run(lib.encoder_encode_word, word)
+
+  def encode_batch(self, texts: Iterable[Union[str, bytes, bytearray, memoryview]]) -> Tuple[memoryview, memoryview]:
+    views = []
+    try:
+      for text in texts:
+        if isinstance(text, str): text = text.encode('utf-8')
+        view = Py_buffer()
+        ctypes.pythonapi.PyObject_GetBuffer(text, ctypes.byref(view), PyBUF_SIMPLE)
+        views.append(view)
+      ptrs = (ctypes.c_void_p * len(views))(*[v.buf for v in views])
+      lens = (ctypes.c_size_t * len(views))(*[v.len for v in views])
+      ptr = lib.encoder_encode_batch(self.encoder, ptrs, lens, len(views))  # runs without the GIL
+    finally:
+      for v in views: ctypes.pythonapi.PyBuffer_Release(ctypes.byref(v))
+    if not ptr:
+      raise RuntimeError("Failed to encode batch")
+    batch = _Batch(ptr)
+    return batch.view(ptr.contents.ids, ctypes.c_int32, ptr.contents.num_ids, 'i'), batch.view(ptr.contents.offsets, ctypes.c_size_t, ptr.contents.num_texts + 1, 'N')
+
+  def encode_files(self, path: Union[str, Sequence[str]], out_prefix: str, shard_tokens: int = 0, doc_sep: Union[str, bytes] = "\n") -> int:
+    if isinstance(doc_sep, str): doc_sep = doc_sep.encode('utf-8')
+    if len(doc_sep) != 1:
+      raise ValueError(f"doc_sep must be a single byte, got {doc_sep!r}")
+    shards = lib.encoder_encode_files(self.encoder, *BPETrainer._paths(path), out_prefix.encode('utf-8'), shard_tokens, doc_sep[0])
+    if shards < 0:
+      raise IOError(f"Failed to encode {path} into {out_prefix}")
+    return shards
+
+  def set_cache(self, cache_size: int):
+    lib.encoder_set_cache(self.encoder, cache_size)
+
+  def warm(self, trainer, max_words: int = 0) -> int:
+    cached = lib.encoder_warm(self.encoder, trainer.trainer, max_words)
+    if cached < 0:
+      raise RuntimeError("Failed to warm the encode cache")
+    return cached
+
+  def cache_stats(self) -> Dict[str, int]:
+    hits, misses, size = ctypes.c_uint64(), ctypes.c_uint64(), ctypes.c_size_t()
+    lib.encoder_cache_stats(self.encoder, ctypes.byref(hits), ctypes.byref(misses), ctypes.byref(size))
+    return {"hits": hits.value, "misses": misses.value, "size": size.value}
+
+  def destroy(self):
+    if getattr(self, "encoder", None):
+      lib.encoder_destroy(self.encoder)
+      self.encoder = None
+
+  def __del__(self):
+    self.destroy()
@@ -1,37 +1,111 @@
 import ctypes
 from typing import *
-from .cbase import lib, BPEConfig
+from .cbase import lib, BPEConfig, Py_buffer, PyBUF_SIMPLE
+
+PRE_TOKENIZERS = {"whitespace": 0, "gpt2": 1, "gpt4": 2}
 
 class BPETrainer:
-  def __init__(self, target_vocab_size=8192, unk_id=0, character_coverage=0.995, min_pair_freq=2000):
+  def __init__(self, target_vocab_size=8192, unk_id=0, character_coverage=0.995, min_pair_freq=2000, num_threads=0, pre_tokenizer="whitespace"):
+    if pre_tokenizer not in PRE_TOKENIZERS:
+      raise ValueError(f"Unknown pre_tokenizer {pre_tokenizer!r}, expected one of {', '.join(PRE_TOKENIZERS)}")
     self.config = BPEConfig(
       target_vocab_size=target_vocab_size,
       unk_id=unk_id,
       character_coverage=character_coverage,
-      min_pair_freq=min_pair_freq
+      min_pair_freq=min_pair_freq,
+      num_threads=num_threads,
+      pre_tokenizer=PRE_TOKENIZERS[pre_tokenizer]
     )
     self.trainer = lib.create_trainer(ctypes.byref(self.config))
     if not self.trainer:
       raise RuntimeError("Failed to create BPE trainer")
 
-  def load_corpus(self, path: str):
-    result = lib.bpe_load_corpus(self.trainer, path.encode('utf-8'))
+  @staticmethod
+  def _paths(path: Union[str, Sequence[str]]):
+    paths = [path] if isinstance(path, str) else list(path)
+    return (ctypes.c_char_p * len(paths))(*[p.encode('utf-8') for p in paths]), len(paths)
+
+  def load_corpus(self, path: Union[str, Sequence[str]]):
+    if isinstance(path, str):
+      result = lib.bpe_load_corpus(self.trainer, path.encode('utf-8'))
+    else:
+      result = lib.bpe_load_corpus_files(self.trainer, *self._paths(path))
     if result != 0:
       raise IOError(f"Failed to load corpus from {path}")
 
+  def count_corpus(self, path: Union[str, Sequence[str]]):
+    if lib.bpe_count_files(self.trainer, *self._paths(path)) != 0:
+      raise IOError(f"Failed to count corpus words from {path}")
+
+  def save_counts(self, path: str, text: bool = False):
+    if lib.bpe_save_counts(self.trainer, path.encode('utf-8'), int(text)) != 0:
+      raise IOError(f"Failed to save word counts to {path}")
+
+  def load_counts(self, path: Union[str, Sequence[str]]):
+    if lib.bpe_load_counts(self.trainer, *self._paths(path)) != 0:
+      raise IOError(f"Failed to load word counts from {path}")
+
+  def feed(self, texts: Iterable[Union[str, bytes, bytearray, memoryview]], batch_bytes: int = 64 << 20) -> int:
+    if isinstance(texts, (str, bytes, bytearray, memoryview)): texts = [texts]
+    views, total, count = [], 0, 0
+
+    def flush():
+      if not views: return
+      ptrs = (ctypes.c_void_p * len(views))(*[v.buf for v in views])
+      lens = (ctypes.c_size_t * len(views))(*[v.len for v in views])
+      try:
+        result = lib.bpe_feed(self.trainer, ptrs, lens, len(views))  # runs without the GIL
+      finally:
+        for v in views: ctypes.pythonapi.PyBuffer_Release(ctypes.byref(v))
+        views.clear()
+      if result != 0:
+        raise RuntimeError("Failed to feed text to the trainer")
+
+    try:
+      for text in texts:
+        if isinstance(text, str): text = text.encode('utf-8')
+        view = Py_buffer()
+        ctypes.pythonapi.PyObject_GetBuffer(text, ctypes.byref(view), PyBUF_SIMPLE)
+        views.append(view)
+        total, count = total + view.len, count + 1
+        if total >= batch_bytes:
+          flush()
+          total = 0
+      flush()
+    finally:
+      for v in views: ctypes.pythonapi.PyBuffer_Release(ctypes.byref(v))
+    return count
+
+  def load_merges(self, model_path: str) -> int:
+    merges = lib.bpe_load_merges(self.trainer, model_path.encode('utf-8'))
+    if merges < 0:
+      raise IOError(f"Failed to load merges from {model_path}")
+    return merges
+
   def train(self):
     merges = lib.bpe_train(self.trainer)
     if merges < 0:
       raise RuntimeError("Training failed")
     print(f"Training completed: {merges} merges performed.")
 
+  def checkpoint(self, path: str):
+    if lib.bpe_checkpoint(self.trainer, path.encode('utf-8')) != 0:
+      raise IOError(f"Failed to write checkpoint to {path}")
+
+  def resume(self, path: str):
+    if lib.bpe_resume(self.trainer, path.encode('utf-8')) != 0:
+      raise IOError(f"Failed to resume from checkpoint {path}")
+
+  def set_checkpoint(self, path: Optional[str], every: int = 0):
+    lib.bpe_set_checkpoint(self.trainer, path.encode('utf-8') if path else None, every)
+
   def save(self, model_path: str, vocab_path: str):
     lib.bpe_save(self.trainer, model_path.encode('utf-8'), vocab_path.encode('utf-8'))
     print(f"Model saved to: {model_path}")
     print(f"Vocabulary saved to: {vocab_path}")
 
   def destroy(self):
-    if self.trainer:
+    if getattr(self, "trainer", None):
       lib.bpe_trainer_destroy(self.trainer)
       self.trainer = None
 
@@ -1,5 +1,5 @@
 // test case for BPE trainer
-// Compilation: g++ -o run bpe_test.cpp ../shred/csrc/bpe/bpe.cpp ../shred/csrc/bpe/histogram.cpp ../shred/csrc/bpe/hash.cpp ../shred/csrc/bpe/heap.cpp
+// Compilation: g++ -o run bpe_test.cpp ../shred/csrc/bpe/bpe.cpp ../shred/csrc/bpe/histogram.cpp ../shred/csrc/bpe/hash.cpp ../shred/csrc/bpe/heap.cpp ../shred/csrc/bpe/arena.cpp ../shred/csrc/bpe/checkpoint.cpp ../shred/csrc/bpe/reader.cpp ../shred/csrc/bpe/counts.cpp ../shred/csrc/bpe/pretok.cpp ../shred/csrc/bpe/scan.cpp ../shred/csrc/bpe/normalize.cpp ../shred/csrc/bpe/encoder.cpp ../shred/csrc/bpe/shards.cpp ../shred/csrc/bpe/decoder.cpp ../shred/csrc/threads.cpp -lpthread
 // Usage: -> ./run
 
 #include <stdio.h>
@@ -7,10 +7,18 @@
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
 #include "../shred/csrc/bpe/bpe.h"
 #include "../shred/csrc/bpe/hash.h"
 #include "../shred/csrc/bpe/heap.h"
 #include "../shred/csrc/bpe/histogram.h"
+#include "../shred/csrc/bpe/pretok.h"
+#include "../shred/csrc/bpe/scan.h"
+#include "../shred/csrc/bpe/normalize.h"
+#include "../shred/csrc/bpe/encoder.h"
+#include "../shred/csrc/bpe/shards.h"
+#include "../shred/csrc/bpe/decoder.h"
 
 // Test utilities
 #define TEST_ASSERT(condition, message) \
@@ -110,7 +118,8 @@ static int test_corpus_loading() {
   
   TEST_ASSERT(result == 0, "Corpus loading failed");
   TEST_ASSERT(trainer->corpus.vocab_size > 0, "No words loaded from corpus");
-  TEST_ASSERT(trainer->corpus.words != NULL, "Words array not allocated");
+  TEST_ASSERT(trainer->corpus.symbols != NULL, "Symbols array not allocated");
+  TEST_ASSERT(trainer->corpus.offsets != NULL && trainer->corpus.lengths != NULL, "Word offsets/lengths not allocated");
   TEST_ASSERT(trainer->corpus.word_counts != NULL, "Word counts array not allocated");
   
   printf("[DEBUG] Loaded %zu unique words from test corpus\n", trainer->corpus.vocab_size);
@@ -118,7 +127,7 @@ static int test_corpus_loading() {
   // Verify some words were loaded correctly
   int found_words = 0;
   for (size_t i = 0; i < trainer->corpus.vocab_size && i < 10; i++) {
-    if (trainer->corpus.words[i] != NULL && trainer->corpus.word_counts[i] > 0) {
+    if (trainer->corpus.lengths[i] > 0 && trainer->corpus.word_counts[i] > 0) {
       found_words++;
     }
   }
@@ -321,6 +330,762 @@ static int test_error_handling() {
   TEST_PASS("test_error_handling");
 }
 
+// Test 9: Checkpoint & resume reproduce an uninterrupted run
+static int test_checkpoint_resume() {
+  const char* test_file = "test_ckpt.txt";
+  const char* ckpt_file = "test_ckpt.bin";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 0.99,
+    .min_pair_freq = 2
+  };
+
+  // uninterrupted reference run
+  Trainer* full = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(full, test_file) == 0, "Corpus loading failed");
+  int full_merges = bpe_train(full);
+  TEST_ASSERT(full_merges > 10, "Too few merges for the checkpoint test");
+
+  // stop half-way, snapshot, and carry on in a fresh trainer
+  BPEConfig half_config = config;
+  half_config.target_vocab_size = INITIAL_VOCAB_SIZE + full_merges / 2;
+  Trainer* half = create_trainer(&half_config);
+  TEST_ASSERT(bpe_load_corpus(half, test_file) == 0, "Corpus loading failed");
+  bpe_train(half);
+  TEST_ASSERT(bpe_checkpoint(half, ckpt_file) == 0, "Checkpoint writing failed");
+  bpe_trainer_destroy(half);
+
+  Trainer* resumed = create_trainer(&config);
+  TEST_ASSERT(bpe_resume(resumed, ckpt_file) == 0, "Resume failed");
+  TEST_ASSERT(resumed->num_merges == (size_t)(full_merges / 2), "Resumed merge count incorrect");
+  TEST_ASSERT(bpe_train(resumed) == full_merges, "Resumed run merge count differs");
+  for (size_t m = 0; m < full->num_merges; m++) {
+    TEST_ASSERT(resumed->merge_ops[m].first == full->merge_ops[m].first && resumed->merge_ops[m].second == full->merge_ops[m].second, "Resumed merges differ");
+  }
+
+  // a damaged file is rejected without touching the trainer
+  FILE* fp = fopen(ckpt_file, "r+b");
+  TEST_ASSERT(fp != NULL, "Checkpoint file not created");
+  fputc('X', fp);
+  fclose(fp);
+  TEST_ASSERT(bpe_resume(resumed, ckpt_file) == -1, "Corrupt checkpoint accepted");
+  TEST_ASSERT(resumed->num_merges == full->num_merges, "Failed resume modified trainer");
+
+  bpe_trainer_destroy(full);
+  bpe_trainer_destroy(resumed);
+  unlink(test_file);
+  unlink(ckpt_file);
+  TEST_PASS("test_checkpoint_resume");
+}
+
+static int test_load_merges() {
+  const char* test_file = "test_replay.txt";
+  const char* model_file = "test_replay.model";
+  const char* vocab_file = "test_replay.vocab";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 0.99,
+    .min_pair_freq = 2
+  };
+
+  Trainer* full = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(full, test_file) == 0, "Corpus loading failed");
+  int full_merges = bpe_train(full);
+  TEST_ASSERT(full_merges > 10, "Too few merges for the replay test");
+
+  // save the first half of the merges, then replay them & continue on the same corpus
+  BPEConfig half_config = config;
+  half_config.target_vocab_size = INITIAL_VOCAB_SIZE + full_merges / 2;
+  Trainer* half = create_trainer(&half_config);
+  TEST_ASSERT(bpe_load_corpus(half, test_file) == 0, "Corpus loading failed");
+  bpe_train(half);
+  bpe_save(half, model_file, vocab_file);
+  bpe_trainer_destroy(half);
+
+  Trainer* extended = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(extended, test_file) == 0, "Corpus loading failed");
+  TEST_ASSERT(bpe_load_merges(extended, model_file) == full_merges / 2, "Loaded merge count incorrect");
+  TEST_ASSERT(bpe_load_merges(extended, model_file) == -1, "Merges loaded twice");
+  TEST_ASSERT(bpe_train(extended) == full_merges, "Extended run merge count differs");
+  for (size_t m = 0; m < full->num_merges; m++) {
+    TEST_ASSERT(extended->merge_ops[m].first == full->merge_ops[m].first && extended->merge_ops[m].second == full->merge_ops[m].second, "Extended merges differ");
+  }
+
+  bpe_trainer_destroy(full);
+  bpe_trainer_destroy(extended);
+  unlink(test_file);
+  unlink(model_file);
+  unlink(vocab_file);
+  TEST_PASS("test_load_merges");
+}
+
+// sum of all word counts of a loaded corpus
+static uint64_t corpus_total(const Trainer* trainer) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < trainer->corpus.vocab_size; i++) total += trainer->corpus.word_counts[i];
+  return total;
+}
+
+static int test_multi_file_loading() {
+  const char* test_file = "test_multi.txt";
+  const char* shard_a = "test_shards/a.txt";
+  const char* shard_b = "test_shards/b.txt";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+  mkdir("test_shards", 0755);
+  TEST_ASSERT(create_test_corpus(shard_a) && create_test_corpus(shard_b), "Failed to create test shards");
+
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 0.99,
+    .min_pair_freq = 2
+  };
+
+  Trainer* single = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(single, test_file) == 0, "Single file loading failed");
+
+  // a directory & a glob over the same two shards both see every word twice
+  Trainer* dir = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(dir, "test_shards") == 0, "Directory loading failed");
+  TEST_ASSERT(dir->corpus.vocab_size == single->corpus.vocab_size, "Directory vocab size differs");
+  TEST_ASSERT(corpus_total(dir) == 2 * corpus_total(single), "Directory word counts incorrect");
+
+  const char* specs[] = { "test_shards/*.txt", test_file };
+  Trainer* list = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus_files(list, specs, 2) == 0, "File list loading failed");
+  TEST_ASSERT(corpus_total(list) == 3 * corpus_total(single), "File list word counts incorrect");
+
+  Trainer* missing = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(missing, "test_shards/*.none") == -1, "Empty glob accepted");
+
+  bpe_trainer_destroy(single);
+  bpe_trainer_destroy(dir);
+  bpe_trainer_destroy(list);
+  bpe_trainer_destroy(missing);
+  unlink(test_file);
+  unlink(shard_a);
+  unlink(shard_b);
+  rmdir("test_shards");
+  TEST_PASS("test_multi_file_loading");
+}
+
+static int test_feed_buffers() {
+  const char* test_file = "test_feed.txt";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 0.99,
+    .min_pair_freq = 2
+  };
+
+  Trainer* loaded = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(loaded, test_file) == 0, "Corpus loading failed");
+  int loaded_merges = bpe_train(loaded);
+
+  // the same text, line by line from memory
+  FILE* fp = fopen(test_file, "r");
+  TEST_ASSERT(fp != NULL, "Test corpus not readable");
+  char lines[128][128];
+  const char* texts[128];
+  size_t lengths[128];
+  size_t n = 0;
+  while (n < 128 && fgets(lines[n], sizeof(lines[n]), fp)) {
+    texts[n] = lines[n];
+    lengths[n] = strlen(lines[n]);
+    n++;
+  }
+  fclose(fp);
+
+  Trainer* fed = create_trainer(&config);
+  TEST_ASSERT(bpe_feed(fed, texts, lengths, n / 2) == 0, "Feeding first half failed");
+  TEST_ASSERT(bpe_feed(fed, texts + n / 2, lengths + n / 2, n - n / 2) == 0, "Feeding second half failed");
+  TEST_ASSERT(bpe_train(fed) == loaded_merges, "Fed corpus merge count differs");
+  TEST_ASSERT(fed->corpus.vocab_size == loaded->corpus.vocab_size, "Fed corpus vocab size differs");
+  for (size_t m = 0; m < loaded->num_merges; m++) {
+    TEST_ASSERT(fed->merge_ops[m].first == loaded->merge_ops[m].first && fed->merge_ops[m].second == loaded->merge_ops[m].second, "Fed corpus merges differ");
+  }
+  TEST_ASSERT(bpe_feed(fed, texts, lengths, 1) == -1, "Feeding after training accepted");
+
+  bpe_trainer_destroy(loaded);
+  bpe_trainer_destroy(fed);
+  unlink(test_file);
+  TEST_PASS("test_feed_buffers");
+}
+
+static int test_count_files() {
+  const char* test_file = "test_counts.txt";
+  const char* bin_file = "test_counts.cnt";
+  const char* text_file = "test_counts.tsv";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 0.99,
+    .min_pair_freq = 2
+  };
+
+  Trainer* loaded = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(loaded, test_file) == 0, "Corpus loading failed");
+  int loaded_merges = bpe_train(loaded);
+  TEST_ASSERT(bpe_save_counts(loaded, bin_file, 0) == -1, "Counts saved after the corpus was built");
+
+  Trainer* counter = create_trainer(&config);
+  TEST_ASSERT(bpe_count_files(counter, &test_file, 1) == 0, "Counting corpus failed");
+  TEST_ASSERT(bpe_save_counts(counter, bin_file, 0) == 0, "Saving binary counts failed");
+  TEST_ASSERT(bpe_save_counts(counter, text_file, 1) == 0, "Saving text counts failed");
+  bpe_trainer_destroy(counter);
+
+  // both formats rebuild the same corpus, merging two files sums the counts
+  const char* files[] = { bin_file, text_file };
+  for (int k = 0; k < 2; k++) {
+    Trainer* t = create_trainer(&config);
+    TEST_ASSERT(bpe_load_counts(t, &files[k], 1) == 0, "Loading counts failed");
+    TEST_ASSERT(bpe_train(t) == loaded_merges, "Merge count from counts differs");
+    for (size_t m = 0; m < loaded->num_merges; m++) {
+      TEST_ASSERT(t->merge_ops[m].first == loaded->merge_ops[m].first && t->merge_ops[m].second == loaded->merge_ops[m].second, "Merges from counts differ");
+    }
+    bpe_trainer_destroy(t);
+  }
+  Trainer* merged = create_trainer(&config);
+  TEST_ASSERT(bpe_load_counts(merged, files, 2) == 0, "Loading several count files failed");
+  TEST_ASSERT(bpe_build_corpus(merged) == 0, "Building corpus from counts failed");
+  TEST_ASSERT(merged->corpus.vocab_size == loaded->corpus.vocab_size, "Merged vocab size differs");
+  for (size_t i = 0; i < merged->corpus.vocab_size; i++) {
+    TEST_ASSERT(merged->corpus.word_counts[i] % 2 == 0, "Merged counts not summed");
+  }
+
+  bpe_trainer_destroy(loaded);
+  bpe_trainer_destroy(merged);
+  unlink(test_file);
+  unlink(bin_file);
+  unlink(text_file);
+  TEST_PASS("test_count_files");
+}
+
+// checks that pretok_split cuts `text` into exactly the `expected` words
+static int split_matches(int mode, const char* text, const char* const* expected, size_t n) {
+  size_t spans[64];
+  size_t len = strlen(text);
+  if (pretok_split(mode, text, len, spans, 32) != n) return 0;
+  for (size_t i = 0; i < n; i++) {
+    size_t wlen = spans[2 * i + 1] - spans[2 * i];
+    if (wlen != strlen(expected[i]) || memcmp(text + spans[2 * i], expected[i], wlen) != 0) return 0;
+  }
+  return 1;
+}
+
+static int test_pre_tokenizer() {
+  // same words as regex.findall with the patterns of `apply_regex`
+  const char* text = "Hello world'S 12345 ok!!\n\n  na\xC3\xAFve \xCE\xA9mega";
+  const char* gpt2[] = { "Hello", " world", "'", "S", " 12345", " ok", "!!", "\n\n ", " na\xC3\xAFve", " \xCE\xA9mega" };
+  const char* gpt4[] = { "Hello", " world", "'S", " ", "123", "45", " ok", "!!\n\n", " ", " na\xC3\xAFve", " \xCE\xA9mega" };
+  const char* ws[] = { "Hello", "world'S", "12345", "ok!!", "na\xC3\xAFve", "\xCE\xA9mega" };
+  TEST_ASSERT(split_matches(PRETOK_GPT2, text, gpt2, 10), "GPT2 split mismatch");
+  TEST_ASSERT(split_matches(PRETOK_GPT4, text, gpt4, 11), "GPT4 split mismatch");
+  TEST_ASSERT(split_matches(PRETOK_WHITESPACE, text, ws, 6), "Whitespace split mismatch");
+
+  const char* test_file = "test_pretok.txt";
+  const char* text_file = "test_pretok.tsv";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 0.99,
+    .min_pair_freq = 2,
+    .num_threads = 0,
+    .pre_tokenizer = PRETOK_GPT4
+  };
+
+  Trainer* loaded = create_trainer(&config);
+  TEST_ASSERT(bpe_count_files(loaded, &test_file, 1) == 0, "Counting corpus failed");
+  TEST_ASSERT(bpe_save_counts(loaded, text_file, 1) == 0, "Saving text counts failed");
+  int loaded_merges = bpe_train(loaded);
+  TEST_ASSERT(loaded_merges > 0, "No merges with the GPT4 pre-tokenizer");
+
+  // the whole file fed as one buffer, and the words read back from text counts holding spaces & newlines
+  FILE* fp = fopen(test_file, "rb");
+  TEST_ASSERT(fp != NULL, "Test corpus not readable");
+  static char buf[8192];
+  size_t len = fread(buf, 1, sizeof(buf), fp);
+  fclose(fp);
+  const char* texts[] = { buf };
+  Trainer* fed = create_trainer(&config);
+  TEST_ASSERT(bpe_feed(fed, texts, &len, 1) == 0, "Feeding corpus failed");
+  Trainer* counted = create_trainer(&config);
+  TEST_ASSERT(bpe_load_counts(counted, &text_file, 1) == 0, "Loading text counts failed");
+  Trainer* others[] = { fed, counted };
+  for (int k = 0; k < 2; k++) {
+    TEST_ASSERT(bpe_train(others[k]) == loaded_merges, "Merge count differs");
+    TEST_ASSERT(others[k]->corpus.vocab_size == loaded->corpus.vocab_size, "Word count differs");
+    for (size_t m = 0; m < loaded->num_merges; m++) {
+      TEST_ASSERT(others[k]->merge_ops[m].first == loaded->merge_ops[m].first && others[k]->merge_ops[m].second == loaded->merge_ops[m].second, "Merges differ");
+    }
+  }
+
+  bpe_trainer_destroy(loaded);
+  bpe_trainer_destroy(fed);
+  bpe_trainer_destroy(counted);
+  unlink(test_file);
+  unlink(text_file);
+  TEST_PASS("test_pre_tokenizer");
+}
+
+static int test_scan_kernels() {
+  // words shorter & longer than a 64-byte block, runs of every delimiter, non-ASCII bytes
+  static char text[1024];
+  size_t len = 0;
+  const char* pieces[] = { "The", " ", "quick\t\tBROWN", "\r\n", "f\xC3\xB6x", "   ",
+                           "jumpedoverthelazydogjumpedoverthelazydogjumpedoverthelazydogJUMPEDOVERTHELAZYDOG", "\n", "x" };
+  for (int r = 0; r < 6; r++) {
+    for (size_t k = 0; k < sizeof(pieces) / sizeof(pieces[0]); k++) {
+      memcpy(text + len, pieces[k], strlen(pieces[k]));
+      len += strlen(pieces[k]);
+    }
+  }
+  text[len] = '\0';
+
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 0.99,
+    .min_pair_freq = 2
+  };
+  int original = scan_level();
+  char norm[3][2048];
+  int norm_len[3];
+  Trainer* trainers[3];
+  for (int level = SCAN_SCALAR; level <= SCAN_AVX2; level++) {
+    int used = scan_set_level(level);
+    TEST_ASSERT(used <= level, "Scan level above the requested one");
+    for (size_t i = 0; i < len; i++) {
+      size_t expect = i;
+      while (expect < len && !strchr(" \t\r\n", text[expect])) expect++;
+      TEST_ASSERT(scan_to_delim(text + i, len - i) == expect - i, "scan_to_delim mismatch");
+    }
+    norm_len[level] = normalize_line(text, norm[level], sizeof(norm[level]));
+    const char* texts[] = { text };
+    trainers[level] = create_trainer(&config);
+    TEST_ASSERT(bpe_feed(trainers[level], texts, &len, 1) == 0, "Feeding failed");
+    TEST_ASSERT(bpe_train(trainers[level]) > 0, "No merges performed");
+  }
+  scan_set_level(original);
+
+  TEST_ASSERT(strncmp(norm[0], "the\xE2\x96\x81quick\xE2\x96\x81" "brown\xE2\x96\x81" "f\xC3\xB6x", 22) == 0, "Normalized text mismatch");
+  for (int level = 1; level <= SCAN_AVX2; level++) {
+    TEST_ASSERT(norm_len[level] == norm_len[0] && memcmp(norm[level], norm[0], norm_len[0]) == 0, "Normalized text differs between levels");
+    TEST_ASSERT(trainers[level]->num_merges == trainers[0]->num_merges, "Merge count differs between levels");
+    for (size_t m = 0; m < trainers[0]->num_merges; m++) {
+      TEST_ASSERT(trainers[level]->merge_ops[m].first == trainers[0]->merge_ops[m].first && trainers[level]->merge_ops[m].second == trainers[0]->merge_ops[m].second, "Merges differ between levels");
+    }
+  }
+  for (int level = 0; level <= SCAN_AVX2; level++) bpe_trainer_destroy(trainers[level]);
+  TEST_PASS("test_scan_kernels");
+}
+
+// applies every merge in rank order over the whole word, like `merge()` in base.py
+static size_t naive_encode(const PairKey* merges, size_t M, const char* word, size_t len, int32_t* ids) {
+  size_t n = len;
+  for (size_t i = 0; i < n; i++) ids[i] = (unsigned char)word[i];
+  for (size_t m = 0; m < M; m++) {
+    size_t out = 0;
+    for (size_t i = 0; i < n; ) {
+      if (i + 1 < n && ids[i] == merges[m].first && ids[i + 1] == merges[m].second) {
+        ids[out++] = (int32_t)(INITIAL_VOCAB_SIZE + m);
+        i += 2;
+      } else {
+        ids[out++] = ids[i++];
+      }
+    }
+    n = out;
+  }
+  return n;
+}
+
+typedef struct BatchCall {
+  Encoder* enc;
+  const char* const* texts;
+  const size_t* lengths;
+  size_t n;
+  EncodeBatch* batch;
+} BatchCall;
+
+static void* batch_call(void* arg) {
+  BatchCall* call = (BatchCall*)arg;
+  call->batch = encoder_encode_batch(call->enc, call->texts, call->lengths, call->n);
+  return NULL;
+}
+
+static int test_encoder() {
+  const char* test_file = "test_encoder.txt";
+  const char* model_file = "test_encoder.model";
+  const char* vocab_file = "test_encoder.vocab";
+  const char* bad_file = "test_encoder_bad.model";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+  BPEConfig config = {
+    .target_vocab_size = 320,
+    .unk_id = -1,
+    .character_coverage = 1.0,
+    .min_pair_freq = 2
+  };
+  Trainer* trainer = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(trainer, test_file) == 0, "Failed to load corpus");
+  TEST_ASSERT(bpe_train(trainer) > 0, "No merges performed");
+  bpe_save(trainer, model_file, vocab_file);
+
+  Encoder* enc = encoder_create(model_file, PRETOK_WHITESPACE, 0);
+  TEST_ASSERT(enc != NULL, "Failed to load model");
+  TEST_ASSERT(encoder_vocab_size(enc) == INITIAL_VOCAB_SIZE + trainer->num_merges, "Vocab size mismatch");
+
+  FILE* fp = fopen(test_file, "rb");
+  TEST_ASSERT(fp != NULL, "Test corpus not readable");
+  static char text[8192];
+  size_t len = fread(text, 1, sizeof(text), fp);
+  fclose(fp);
+
+  // every word matches the rank-order reference, and the corpus' own words end up as trained
+  static int32_t ids[8192], expect[8192];
+  const char* words[] = { "the", "quick", "brown", "jumps", "lazy", "dogdogdog", "zzzz" };
+  for (size_t k = 0; k < sizeof(words) / sizeof(words[0]); k++) {
+    size_t wlen = strlen(words[k]);
+    size_t n = encoder_encode_word(enc, words[k], wlen, ids);
+    TEST_ASSERT(n == naive_encode(trainer->merge_ops, trainer->num_merges, words[k], wlen, expect), "Word id count differs from reference");
+    TEST_ASSERT(memcmp(ids, expect, n * sizeof(int32_t)) == 0, "Word ids differ from reference");
+  }
+  TEST_ASSERT(encoder_encode_word(enc, "the", 3, ids) == 1, "Frequent word not merged into one token");
+
+  // whole text: ids decode back to the exact bytes, delimiters included
+  size_t n = encoder_encode(enc, text, len, ids);
+  TEST_ASSERT(n > 0 && n < len, "Text not compressed");
+  static char decoded[8192];
+  size_t dlen = 0;
+  for (size_t i = 0; i < n; i++) {
+    int32_t stack[64];
+    int top = 0;
+    stack[top++] = ids[i];
+    while (top > 0) {
+      int32_t id = stack[--top];
+      if (id < INITIAL_VOCAB_SIZE) {
+        decoded[dlen++] = (char)id;
+      } else {
+        stack[top++] = trainer->merge_ops[id - INITIAL_VOCAB_SIZE].second;
+        stack[top++] = trainer->merge_ops[id - INITIAL_VOCAB_SIZE].first;
+      }
+    }
+  }
+  TEST_ASSERT(dlen == len && memcmp(decoded, text, len) == 0, "Decoded ids differ from the text");
+
+  // a batch big enough to be split across threads: every text encodes as it does alone
+  size_t ntexts = 3 * MIN_SHARD_BYTES / len + 1;
+  const char** texts = (const char**)malloc(ntexts * sizeof(char*));
+  size_t* lengths = (size_t*)malloc(ntexts * sizeof(size_t));
+  TEST_ASSERT(texts && lengths, "Failed allocation of batch texts");
+  for (size_t i = 0; i < ntexts; i++) {
+    texts[i] = text + i % 7;   // texts of varying cut
+    lengths[i] = len - i % 7 - i % 5;
+  }
+  EncodeBatch* batch = encoder_encode_batch(enc, texts, lengths, ntexts);
+  TEST_ASSERT(batch != NULL && batch->num_texts == ntexts, "Batch encoding failed");
+  TEST_ASSERT(batch->offsets[0] == 0 && batch->offsets[ntexts] == batch->num_ids, "Batch offsets don't span the ids");
+  for (size_t i = 0; i < ntexts; i++) {
+    size_t k = encoder_encode(enc, texts[i], lengths[i], ids);
+    TEST_ASSERT(batch->offsets[i + 1] - batch->offsets[i] == k, "Batch text id count differs");
+    TEST_ASSERT(memcmp(batch->ids + batch->offsets[i], ids, k * sizeof(int32_t)) == 0, "Batch text ids differ");
+  }
+
+  // batches from two threads on one pooled encoder take turns & match the single-threaded ids
+  Encoder* pooled = encoder_create(model_file, PRETOK_WHITESPACE, 4);
+  TEST_ASSERT(pooled != NULL, "Failed to load model");
+  BatchCall calls[2] = { { pooled, texts, lengths, ntexts, NULL }, { pooled, texts, lengths, ntexts, NULL } };
+  pthread_t callers[2];
+  for (int c = 0; c < 2; c++) TEST_ASSERT(pthread_create(&callers[c], NULL, batch_call, &calls[c]) == 0, "Failed to start batch thread");
+  for (int c = 0; c < 2; c++) pthread_join(callers[c], NULL);
+  for (int c = 0; c < 2; c++) {
+    TEST_ASSERT(calls[c].batch != NULL && calls[c].batch->num_ids == batch->num_ids, "Concurrent batch id count differs");
+    TEST_ASSERT(memcmp(calls[c].batch->ids, batch->ids, batch->num_ids * sizeof(int32_t)) == 0, "Concurrent batch ids differ");
+    encoder_batch_free(calls[c].batch);
+  }
+  encoder_destroy(pooled);
+  encoder_batch_free(batch);
+  batch = encoder_encode_batch(enc, texts, lengths, 0);
+  TEST_ASSERT(batch != NULL && batch->num_ids == 0 && batch->offsets[0] == 0, "Empty batch failed");
+  encoder_batch_free(batch);
+
+  // cached words encode as before, and warming from the trainer's words fills the cache
+  n = encoder_encode(enc, text, len, ids);
+  TEST_ASSERT(encoder_set_cache(enc, 64) == 0, "Failed to turn the cache on");
+  for (int pass = 0; pass < 2; pass++) {
+    TEST_ASSERT(encoder_encode(enc, text, len, expect) == n && memcmp(expect, ids, n * sizeof(int32_t)) == 0, "Cached ids differ");
+  }
+  uint64_t hits, misses;
+  size_t cached;
+  encoder_cache_stats(enc, &hits, &misses, &cached);
+  TEST_ASSERT(hits > misses && cached > 0 && cached <= 64, "Cache not used");
+  TEST_ASSERT(encoder_set_cache(enc, 1000) == 0, "Failed to resize the cache");
+  long warmed = encoder_warm(enc, trainer, 10);
+  encoder_cache_stats(enc, &hits, &misses, &cached);
+  TEST_ASSERT(warmed == 10 && cached == 10 && hits == 0 && misses == 0, "Warming from the corpus failed");
+  TEST_ASSERT(encoder_encode_word(enc, "the", 3, ids) == 1, "Warmed word encodes differently");
+  encoder_cache_stats(enc, &hits, &misses, &cached);
+  TEST_ASSERT(hits == 1, "Warmed word not cached");
+  Trainer* counter = create_trainer(&config);
+  TEST_ASSERT(bpe_count_files(counter, &test_file, 1) == 0, "Counting corpus failed");
+  TEST_ASSERT(encoder_warm(enc, counter, 0) > 10, "Warming from pending counts failed");
+  bpe_trainer_destroy(counter);
+
+  // words fed on several threads sit in several pending tables, warming counts each word once
+  BPEConfig threaded = config;
+  threaded.num_threads = 4;
+  counter = create_trainer(&threaded);
+  size_t fed_len = 8 * MIN_SHARD_BYTES;
+  char* fed = (char*)malloc(fed_len);
+  TEST_ASSERT(fed != NULL, "Failed allocation of fed text");
+  for (size_t i = 0; i < fed_len; i++) fed[i] = "hello world foo "[i % 16];
+  const char* fed_texts[] = { fed };
+  TEST_ASSERT(bpe_feed(counter, fed_texts, &fed_len, 1) == 0 && counter->npending > 1, "Threaded feed failed");
+  TEST_ASSERT(encoder_set_cache(enc, 1000) == 0, "Failed to reset the cache");
+  warmed = encoder_warm(enc, counter, 3);
+  encoder_cache_stats(enc, &hits, &misses, &cached);
+  TEST_ASSERT(warmed == 3 && cached == 3, "Words of several pending tables cached twice");
+  TEST_ASSERT(encoder_encode_word(enc, "foo", 3, ids) > 0, "Failed to encode fed word");
+  encoder_cache_stats(enc, &hits, &misses, &cached);
+  TEST_ASSERT(hits == 1, "Fed word not cached");
+  free(fed);
+  bpe_trainer_destroy(counter);
+  TEST_ASSERT(encoder_set_cache(enc, 0) == 0 && encoder_warm(enc, trainer, 0) == -1, "Warmed a disabled cache");
+
+  free(texts);
+  free(lengths);
+  encoder_destroy(enc);
+
+  // truncated & out-of-order models are rejected
+  fp = fopen(bad_file, "wb");
+  int32_t bad[4] = { 'a', 'b', 300, 7 };
+  fwrite(bad, sizeof(int32_t), 4, fp);
+  fclose(fp);
+  TEST_ASSERT(encoder_create(bad_file, PRETOK_WHITESPACE, 0) == NULL, "Truncated model accepted");
+  fp = fopen(bad_file, "wb");
+  fwrite(bad, sizeof(int32_t), 3, fp);
+  fclose(fp);
+  TEST_ASSERT(encoder_create(bad_file, PRETOK_WHITESPACE, 0) == NULL, "Out-of-order merge accepted");
+  TEST_ASSERT(encoder_create("nonexistent.model", PRETOK_WHITESPACE, 0) == NULL, "Missing model accepted");
+
+  bpe_trainer_destroy(trainer);
+  unlink(test_file);
+  unlink(model_file);
+  unlink(vocab_file);
+  unlink(bad_file);
+  TEST_PASS("test_encoder");
+}
+
+// reads one shard back, checking its header & offsets, returns its no of docs or -1
+static long read_shard(const char* prefix, long index, int32_t* ids, uint64_t* offsets) {
+  char path[256];
+  ShardHeader header;
+  snprintf(path, sizeof(path), "%s_%05ld.idx", prefix, index);
+  FILE* fp = fopen(path, "rb");
+  if (!fp) return -1;
+  long docs = -1;
+  if (fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, SHARD_MAGIC, 8) == 0 && header.id_bytes == 2 &&
+      fread(offsets, sizeof(uint64_t), header.num_docs + 1, fp) == header.num_docs + 1 && offsets[header.num_docs] == header.num_tokens && fgetc(fp) == EOF) {
+    docs = (long)header.num_docs;
+  }
+  fclose(fp);
+  unlink(path);
+  snprintf(path, sizeof(path), "%s_%05ld.bin", prefix, index);
+  fp = fopen(path, "rb");
+  if (!fp) return -1;
+  for (uint64_t i = 0; i < header.num_tokens; i++) {
+    uint16_t id;
+    if (fread(&id, sizeof(id), 1, fp) != 1) docs = -1;
+    ids[i] = id;
+  }
+  if (fgetc(fp) != EOF) docs = -1;
+  fclose(fp);
+  unlink(path);
+  return docs;
+}
+
+static int test_encode_files() {
+  const char* test_file = "test_shards.txt";
+  const char* tail_file = "test_shards_tail.txt";
+  const char* model_file = "test_shards.model";
+  const char* vocab_file = "test_shards.vocab";
+  const char* prefix = "test_shards_out";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+  FILE* fp = fopen(tail_file, "wb");
+  TEST_ASSERT(fp != NULL, "Failed to create tail file");
+  fputs("\n\nfirst doc after blank lines\n\nlast doc without newline", fp);
+  fclose(fp);
+  BPEConfig config = {
+    .target_vocab_size = 300,
+    .unk_id = -1,
+    .character_coverage = 1.0,
+    .min_pair_freq = 2
+  };
+  Trainer* trainer = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(trainer, test_file) == 0, "Failed to load corpus");
+  TEST_ASSERT(bpe_train(trainer) > 0, "No merges performed");
+  bpe_save(trainer, model_file, vocab_file);
+  bpe_trainer_destroy(trainer);
+  Encoder* enc = encoder_create(model_file, PRETOK_WHITESPACE, 0);
+  TEST_ASSERT(enc != NULL, "Failed to load model");
+
+  // every non-empty line of both files, in order, is one document
+  const char* paths[] = { test_file, tail_file };
+  long nshards = encoder_encode_files(enc, paths, 2, prefix, 200, '\n');
+  TEST_ASSERT(nshards > 1, "Corpus not split into shards");
+  static char text[8192];
+  size_t len = 0;
+  for (int f = 0; f < 2; f++) {
+    fp = fopen(paths[f], "rb");
+    len += fread(text + len, 1, sizeof(text) - len, fp);
+    fclose(fp);
+  }
+  static int32_t ids[8192], expect[8192];
+  static uint64_t offsets[1024];
+  const char* line = text;
+  const char* end = text + len;
+  long docs = 0;
+  for (long s = 0; s < nshards; s++) {
+    long ndocs = read_shard(prefix, s, ids, offsets);
+    TEST_ASSERT(ndocs > 0, "Shard unreadable or malformed");
+    TEST_ASSERT(s == nshards - 1 || offsets[ndocs - 1] < 200, "Shard continued past its token limit");
+    for (long d = 0; d < ndocs; d++, docs++) {
+      while (line < end && *line == '\n') line++;
+      const char* stop = (const char*)memchr(line, '\n', (size_t)(end - line));
+      if (!stop) stop = end;
+      size_t n = encoder_encode(enc, line, (size_t)(stop - line), expect);
+      TEST_ASSERT(offsets[d + 1] - offsets[d] == n && memcmp(ids + offsets[d], expect, n * sizeof(int32_t)) == 0, "Document ids differ");
+      line = stop;
+    }
+  }
+  TEST_ASSERT(docs == 72, "Wrong document count");
+  char path[256];
+  snprintf(path, sizeof(path), "%s_%05ld.idx", prefix, nshards);
+  TEST_ASSERT(access(path, F_OK) != 0, "Extra shard written");
+
+  TEST_ASSERT(encoder_encode_files(enc, paths, 2, prefix, 0, 256) == -1, "Multi-byte separator accepted");
+  const char* missing = "nonexistent_shards.txt";
+  TEST_ASSERT(encoder_encode_files(enc, &missing, 1, prefix, 0, '\n') == -1, "Missing input accepted");
+  encoder_destroy(enc);
+  unlink(test_file);
+  unlink(tail_file);
+  unlink(model_file);
+  unlink(vocab_file);
+  TEST_PASS("test_encode_files");
+}
+
+static int test_decoder() {
+  const char* test_file = "test_decoder.txt";
+  const char* model_file = "test_decoder.model";
+  const char* vocab_file = "test_decoder.vocab";
+  TEST_ASSERT(create_test_corpus(test_file), "Failed to create test corpus");
+  BPEConfig config = {
+    .target_vocab_size = 320,
+    .unk_id = -1,
+    .character_coverage = 1.0,
+    .min_pair_freq = 2
+  };
+  Trainer* trainer = create_trainer(&config);
+  TEST_ASSERT(bpe_load_corpus(trainer, test_file) == 0, "Failed to load corpus");
+  TEST_ASSERT(bpe_train(trainer) > 0, "No merges performed");
+  bpe_save(trainer, model_file, vocab_file);
+  Encoder* enc = encoder_create(model_file, PRETOK_WHITESPACE, 0);
+  Decoder* dec = decoder_create(model_file);
+  TEST_ASSERT(enc != NULL && dec != NULL, "Failed to load model");
+  TEST_ASSERT(decoder_vocab_size(dec) == encoder_vocab_size(enc), "Vocab size mismatch");
+  TEST_ASSERT(dec->offsets[INITIAL_VOCAB_SIZE + 1] - dec->offsets[INITIAL_VOCAB_SIZE] == 2, "First merge isn't two bytes");
+
+  // encoded text, multi-byte characters included, decodes back to the exact bytes
+  static char text[8192], out[8192];
+  FILE* fp = fopen(test_file, "rb");
+  TEST_ASSERT(fp != NULL, "Test corpus not readable");
+  size_t len = fread(text, 1, 4096, fp);
+  fclose(fp);
+  const char* extra = "na\xC3\xAFve caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 the quick fox";
+  memcpy(text + len, extra, strlen(extra));
+  len += strlen(extra);
+  static int32_t ids[8192];
+  size_t n = encoder_encode(enc, text, len, ids);
+  TEST_ASSERT(decoder_decode(dec, ids, n, out, sizeof(out)) == (int64_t)len && memcmp(out, text, len) == 0, "Decoded bytes differ");
+  out[0] = 'X';
+  TEST_ASSERT(decoder_decode(dec, ids, n, out, len - 1) == (int64_t)len && out[0] == 'X', "Short buffer written to");
+  int32_t bad = (int32_t)decoder_vocab_size(dec);
+  TEST_ASSERT(decoder_decode(dec, &bad, 1, out, sizeof(out)) == -1, "Out of range id decoded");
+
+  // a batch decodes sequence by sequence
+  const char* texts[] = { text, text + 100, extra, text };
+  size_t lengths[] = { 50, 0, strlen(extra), len };
+  EncodeBatch* batch = encoder_encode_batch(enc, texts, lengths, 4);
+  TEST_ASSERT(batch != NULL, "Batch encoding failed");
+  DecodeBatch* decoded = decoder_decode_batch(dec, batch->ids, batch->offsets, 4);
+  TEST_ASSERT(decoded != NULL && decoded->num_texts == 4, "Batch decoding failed");
+  for (size_t i = 0; i < 4; i++) {
+    TEST_ASSERT(decoded->offsets[i + 1] - decoded->offsets[i] == lengths[i], "Batch text length differs");
+    TEST_ASSERT(memcmp(decoded->bytes + decoded->offsets[i], texts[i], lengths[i]) == 0, "Batch text bytes differ");
+  }
+  decoder_batch_free(decoded);
+  encoder_batch_free(batch);
+
+  // a stream fed one id at a time only hands out whole characters & adds up to the text
+  DecodeStream* stream = decoder_stream_create(dec);
+  TEST_ASSERT(stream != NULL, "Failed to create stream");
+  size_t total = 0, got;
+  for (size_t i = 0; i < n; i++) {
+    const char* bytes = decoder_stream_push(stream, &ids[i], 1, &got);
+    TEST_ASSERT(bytes != NULL, "Stream push failed");
+    TEST_ASSERT(got == 0 || (((unsigned char)bytes[0] & 0xC0) != 0x80 && total + got < len && ((unsigned char)text[total + got] & 0xC0) != 0x80) || total + got == len, "Stream split a character");
+    memcpy(out + total, bytes, got);
+    total += got;
+  }
+  decoder_stream_flush(stream, &got);
+  TEST_ASSERT(got == 0 && total == len && memcmp(out, text, len) == 0, "Streamed bytes differ");
+
+  int32_t euro[3] = { 0xE2, 0x82, 0xAC };
+  TEST_ASSERT(decoder_stream_push(stream, euro, 2, &got) != NULL && got == 0, "Unfinished character handed out");
+  TEST_ASSERT(decoder_stream_push(stream, &bad, 1, &got) == NULL, "Out of range id streamed");
+  const char* bytes = decoder_stream_push(stream, euro + 2, 1, &got);
+  TEST_ASSERT(got == 3 && memcmp(bytes, "\xE2\x82\xAC", 3) == 0, "Finished character not handed out");
+  decoder_stream_push(stream, euro, 1, &got);
+  bytes = decoder_stream_flush(stream, &got);
+  TEST_ASSERT(got == 1 && (unsigned char)bytes[0] == 0xE2, "Held byte not flushed");
+  int32_t stray[2] = { 0xA9, 'a' };
+  bytes = decoder_stream_push(stream, stray, 2, &got);
+  TEST_ASSERT(got == 2 && (unsigned char)bytes[0] == 0xA9, "Stray continuation byte held back");
+  decoder_stream_destroy(stream);
+
+  // saved vocab lines start with the decoder's token bytes, escaped so each token takes one line
+  fp = fopen(vocab_file, "rb");
+  TEST_ASSERT(fp != NULL, "Vocab file not created");
+  size_t vlen = fread(out, 1, sizeof(out) - 1, fp);
+  fclose(fp);
+  out[vlen] = '\0';
+  size_t first = dec->offsets[INITIAL_VOCAB_SIZE];
+  const char* line = (const char*)memmem(out, vlen, dec->bytes + first, dec->offsets[INITIAL_VOCAB_SIZE + 1] - first);
+  TEST_ASSERT(vlen > 2 * INITIAL_VOCAB_SIZE && memcmp(out, "\\0 ", 3) == 0 && line != NULL, "Vocab tokens differ from the decoder's");
+  TEST_ASSERT(strstr(out, "\n\\n ") != NULL && strstr(out, "\n\\t ") != NULL, "Vocab whitespace tokens not escaped");
+
+  PairKey forward = { 'a', INITIAL_VOCAB_SIZE };
+  TEST_ASSERT(decoder_build(&forward, 1) == NULL, "Merge of a later id accepted");
+  TEST_ASSERT(decoder_create("nonexistent.model") == NULL, "Missing model accepted");
+  decoder_destroy(dec);
+  encoder_destroy(enc);
+  bpe_trainer_destroy(trainer);
+  unlink(test_file);
+  unlink(model_file);
+  unlink(vocab_file);
+  TEST_PASS("test_decoder");
+}
+
 // Test runner
 typedef struct {
   const char* name;
@@ -331,10 +1096,20 @@ static TestCase tests[] = {
   {"Trainer Creation", test_trainer_creation},
   {"Config Defaults", test_config_defaults},
   {"Corpus Loading", test_corpus_loading},
+  {"Multi-file Loading", test_multi_file_loading},
+  {"Feed Buffers", test_feed_buffers},
+  {"Count Files", test_count_files},
+  {"Pre-tokenizer", test_pre_tokenizer},
+  {"Scan Kernels", test_scan_kernels},
   {"Bigram Counting", test_bigram_counting},
   {"Single Merge", test_single_merge},
   {"Full Training", test_full_training},
   {"Model Saving", test_model_saving},
+  {"Checkpoint Resume", test_checkpoint_resume},
+  {"Load Merges", test_load_merges},
+  {"Encoder", test_encoder},
+  {"Encode Files", test_encode_files},
+  {"Decoder", test_decoder},
   {"Error Handling", test_error_handling}
 };
 